@@ -0,0 +1,35 @@
+// Measures the Buffer encoders. Usage: node buffer_codec.js [size]
+var Buffer = require('buffer').Buffer;
+var SlowBuffer = require('buffer').SlowBuffer;
+
+var size = parseInt(process.argv[2], 10) || 64 * 1024;
+var total = 256 * 1024 * 1024; // bytes to push through each encoder
+var iterations = Math.max(1, Math.floor(total / size));
+
+var binary = new Buffer(size);
+for (var i = 0; i < size; i++) binary[i] = (i * 7) & 255;
+
+var ascii = new Buffer(size);
+for (var i = 0; i < size; i++) ascii[i] = 32 + i % 95;
+
+var b64 = binary.toString('base64');
+var hex = binary.toString('hex');
+var scratch = new Buffer(size);
+
+function bench(name, fn) {
+  var start = Date.now();
+  for (var i = 0; i < iterations; i++) fn();
+  var elapsed = (Date.now() - start) / 1000;
+  var mbps = (iterations * size / (1024 * 1024)) / elapsed;
+  console.log('%s: %d MB/s', name, mbps.toFixed(1));
+}
+
+console.log('kernel: %s, buffer size: %d', SlowBuffer.codecKernel, size);
+
+bench('base64 encode', function() { binary.toString('base64'); });
+bench('base64 decode', function() { scratch.write(b64, 0, 'base64'); });
+bench('hex encode', function() { binary.toString('hex'); });
+bench('hex decode', function() { scratch.write(hex, 0, 'hex'); });
+bench('utf8 slice (ascii)', function() { ascii.toString('utf8'); });
+bench('isAscii', function() { Buffer.isAscii(ascii); });
+bench('isUtf8', function() { Buffer.isUtf8(ascii); });
@@ -0,0 +1,26 @@
+// Scans a multipart-like body for its boundary.
+// Usage: node buffer_indexof.js [bodySize]
+var Buffer = require('buffer').Buffer;
+
+var size = parseInt(process.argv[2], 10) || 4 * 1024 * 1024;
+var boundary = '\r\n------------------------------7d93b92e30b82\r\n';
+
+var body = new Buffer(size);
+for (var i = 0; i < size; i++) body[i] = 32 + (i * 31) % 90;
+body.write(boundary, size - boundary.length, 'ascii');
+
+var needle = new Buffer(boundary);
+var iterations = Math.max(1, Math.floor(1024 * 1024 * 1024 / size));
+
+function bench(name, fn) {
+  var start = Date.now();
+  for (var i = 0; i < iterations; i++) fn();
+  var elapsed = (Date.now() - start) / 1000;
+  console.log('%s: %d MB/s', name,
+              (iterations * size / (1024 * 1024) / elapsed).toFixed(1));
+}
+
+bench('indexOf(boundary)', function() { body.indexOf(needle); });
+bench('indexOf(\\r\\n\\r\\n)', function() { body.indexOf('\r\n\r\n'); });
+bench('indexOf(byte)', function() { body.indexOf(0); });
+bench('lastIndexOf(boundary)', function() { body.lastIndexOf(needle, 0); });
@@ -67,6 +67,10 @@ ab_hello_world() {
 ab_hello_world 'string' '1024'
 ab_hello_world 'buffer' '1024'
 
+# 64k
+ab_hello_world 'string' '65536'
+ab_hello_world 'buffer' '65536'
+
 # 100k 
 ab_hello_world 'string' '102400'
 ab_hello_world 'buffer' '102400'
@@ -0,0 +1,110 @@
+// Measures querystring.parse. Usage: node querystring.js [size]
+// Runs a 1k and a 64k query string unless a size is given.
+var qs = require('querystring');
+
+var sizes = process.argv[2] ? [parseInt(process.argv[2], 10)] :
+                              [1024, 64 * 1024];
+var total = 64 * 1024 * 1024; // bytes to push through each run
+
+
+// The pure JS parser this module used before the native one, for
+// comparison.
+function charCode(c) {
+  return c.charCodeAt(0);
+}
+
+function jsUnescape(s) {
+  var out = new Buffer(s.length);
+  var state = 'CHAR';
+  var n, m, hexchar;
+
+  for (var inIndex = 0, outIndex = 0; inIndex <= s.length; inIndex++) {
+    var c = s.charCodeAt(inIndex);
+    switch (state) {
+      case 'CHAR':
+        if (c == charCode('%')) {
+          n = 0;
+          m = 0;
+          state = 'HEX0';
+        } else {
+          if (c == charCode('+')) c = charCode(' ');
+          out[outIndex++] = c;
+        }
+        break;
+
+      case 'HEX0':
+        state = 'HEX1';
+        hexchar = c;
+        n = parseInt(String.fromCharCode(c), 16);
+        if (isNaN(n)) {
+          out[outIndex++] = charCode('%');
+          out[outIndex++] = c;
+          state = 'CHAR';
+        }
+        break;
+
+      case 'HEX1':
+        state = 'CHAR';
+        m = parseInt(String.fromCharCode(c), 16);
+        if (isNaN(m)) {
+          out[outIndex++] = charCode('%');
+          out[outIndex++] = hexchar;
+          out[outIndex++] = c;
+          break;
+        }
+        out[outIndex++] = 16 * n + m;
+        break;
+    }
+  }
+
+  return out.slice(0, outIndex - 1).toString();
+}
+
+function jsParse(s) {
+  var obj = {};
+  s.split('&').forEach(function(kvp) {
+    var x = kvp.split('=');
+    var k = jsUnescape(x[0]);
+    var v = jsUnescape(x.slice(1).join('='));
+
+    if (!(k in obj)) {
+      obj[k] = v;
+    } else if (!Array.isArray(obj[k])) {
+      obj[k] = [obj[k], v];
+    } else {
+      obj[k].push(v);
+    }
+  });
+  return obj;
+}
+
+
+function makeQuery(size) {
+  var parts = [];
+  var length = 0;
+  for (var i = 0; length < size; i++) {
+    var part = 'key' + (i % 50) + '=some+value%20' + i + '%2Fpath';
+    parts.push(part);
+    length += part.length + 1;
+  }
+  return parts.join('&').slice(0, size);
+}
+
+function bench(name, size, fn) {
+  var iterations = Math.max(1, Math.floor(total / size));
+  var start = Date.now();
+  for (var i = 0; i < iterations; i++) fn();
+  var elapsed = (Date.now() - start) / 1000;
+  var mbps = (iterations * size / (1024 * 1024)) / elapsed;
+  console.log('%s (%d bytes): %d MB/s', name, size, mbps.toFixed(1));
+}
+
+sizes.forEach(function(size) {
+  var str = makeQuery(size);
+  var buf = new Buffer(str);
+
+  bench('js parse', size, function() { jsParse(str); });
+  bench('parse string', size, function() { qs.parse(str); });
+  bench('parse buffer', size, function() { qs.parse(buf); });
+  bench('unescape', size, function() { qs.unescape(str, true); });
+});
@@ -45,9 +45,12 @@ set(node_sources
   src/node_main.cc
   src/node.cc
   src/node_buffer.cc
+  src/node_buffer_codec.cc
   src/node_javascript.cc
   src/node_extensions.cc
   src/node_http_parser.cc
+  src/node_http_writer.cc
+  src/node_url.cc
   src/node_net.cc
   src/node_io_watcher.cc
   src/node_child_process.cc
@@ -22,6 +22,14 @@
 #include <assert.h>
 #include <stddef.h>
 
+#if defined(__GNUC__) && defined(__SSE4_2__)
+# include <nmmintrin.h>
+# define HTTP_PARSER_SSE42 1
+#elif defined(__GNUC__) && defined(__SSE2__)
+# include <emmintrin.h>
+# define HTTP_PARSER_SSE2 1
+#endif
+
 
 #ifndef MIN
 # define MIN(a,b) ((a) < (b) ? (a) : (b))
@@ -63,6 +71,17 @@ do {                                                                 \
 } while (0)
 
 
+/* Moves p over the bytes after it that scan() says need no attention,
+ * keeping the header size accounting in step. */
+#define SKIP_AHEAD(scan)                                             \
+do {                                                                 \
+  const char *q = scan(p + 1, pe);                                   \
+  nread += q - (p + 1);                                              \
+  if (nread > HTTP_MAX_HEADER_SIZE) goto error;                      \
+  p = q - 1;                                                         \
+} while (0)
+
+
 #define PROXY_CONNECTION "proxy-connection"
 #define CONNECTION "connection"
 #define CONTENT_LENGTH "content-length"
@@ -316,6 +335,91 @@ enum flags
 #endif
 
 
+/* Skip-ahead for the long runs of ordinary bytes in header values (think
+ * cookies) and URLs. Both functions return a pointer to the first byte in
+ * [p, pe) that the state machine has to look at, or pe.
+ *
+ * With SSE4.2 or SSE2 16 bytes are checked at a time and the scalar loop
+ * only deals with the tail.
+ */
+static const char *
+scan_header_value(const char *p, const char *pe)
+{
+#if HTTP_PARSER_SSE42
+  /* CR and LF end the value. */
+  const __m128i stop = _mm_setr_epi8('\r', '\n', 0, 0, 0, 0, 0, 0,
+                                     0, 0, 0, 0, 0, 0, 0, 0);
+
+  for (; pe - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int i = _mm_cmpestri(stop, 2, v, 16,
+                         _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                         _SIDD_LEAST_SIGNIFICANT);
+    if (i != 16) return p + i;
+  }
+#elif HTTP_PARSER_SSE2
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+
+  for (; pe - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                                              _mm_cmpeq_epi8(v, lf)));
+    if (mask) return p + __builtin_ctz(mask);
+  }
+#endif
+
+  for (; p != pe; p++) {
+    if (*p == CR || *p == LF) break;
+  }
+
+  return p;
+}
+
+
+static const char *
+scan_url(const char *p, const char *pe)
+{
+#if HTTP_PARSER_SSE42
+  /* The bytes normal_url_char[] rejects: controls and space, '#', '?',
+   * DEL and everything above. */
+  const __m128i stop = _mm_setr_epi8(0x00, 0x20, '#', '#', '?', '?',
+                                     0x7f, (char) 0xff,
+                                     0, 0, 0, 0, 0, 0, 0, 0);
+
+  for (; pe - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int i = _mm_cmpestri(stop, 8, v, 16,
+                         _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                         _SIDD_LEAST_SIGNIFICANT);
+    if (i != 16) return p + i;
+  }
+#elif HTTP_PARSER_SSE2
+  /* Signed compares: bytes above DEL are negative and fail the first. */
+  const __m128i above_space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i hash = _mm_set1_epi8('#');
+  const __m128i question = _mm_set1_epi8('?');
+
+  for (; pe - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, above_space),
+                               _mm_cmplt_epi8(v, del));
+    __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, hash),
+                                   _mm_cmpeq_epi8(v, question));
+    int mask = _mm_movemask_epi8(ok) & ~_mm_movemask_epi8(special);
+    if (mask != 0xffff) return p + __builtin_ctz(~mask);
+  }
+#endif
+
+  for (; p != pe; p++) {
+    if (!normal_url_char[(unsigned char)*p]) break;
+  }
+
+  return p;
+}
+
+
 size_t http_parser_execute (http_parser *parser,
                             const http_parser_settings *settings,
                             const char *data,
@@ -747,7 +851,10 @@ size_t http_parser_execute (http_parser *parser,
 
       case s_req_path:
       {
-        if (normal_url_char[(unsigned char)ch]) break;
+        if (normal_url_char[(unsigned char)ch]) {
+          SKIP_AHEAD(scan_url);
+          break;
+        }
 
         switch (ch) {
           case ' ':
@@ -821,7 +928,10 @@ size_t http_parser_execute (http_parser *parser,
 
       case s_req_query_string:
       {
-        if (normal_url_char[(unsigned char)ch]) break;
+        if (normal_url_char[(unsigned char)ch]) {
+          SKIP_AHEAD(scan_url);
+          break;
+        }
 
         switch (ch) {
           case '?':
@@ -895,7 +1005,10 @@ size_t http_parser_execute (http_parser *parser,
 
       case s_req_fragment:
       {
-        if (normal_url_char[(unsigned char)ch]) break;
+        if (normal_url_char[(unsigned char)ch]) {
+          SKIP_AHEAD(scan_url);
+          break;
+        }
 
         switch (ch) {
           case ' ':
@@ -1277,6 +1390,7 @@ size_t http_parser_execute (http_parser *parser,
 
         switch (header_state) {
           case h_general:
+            SKIP_AHEAD(scan_header_value);
             break;
 
           case h_connection:
@@ -41,6 +41,9 @@ SlowBuffer.prototype.toString = function(encoding, start, end) {
     case 'base64':
       return this.base64Slice(start, end);
 
+    case 'hex':
+      return this.hexSlice(start, end);
+
     case 'ucs2':
     case 'ucs-2':
       return this.ucs2Slice(start, end);
@@ -77,6 +80,9 @@ SlowBuffer.prototype.write = function(string, offset, encoding) {
     case 'base64':
       return this.base64Write(string, offset);
 
+    case 'hex':
+      return this.hexWrite(string, offset);
+
     case 'ucs2':
     case 'ucs-2':
       return this.ucs2Write(start, end);
@@ -242,6 +248,10 @@ Buffer.prototype.write = function(string, offset, encoding) {
       ret = this.parent.base64Write(string, this.offset + offset, maxLength);
       break;
 
+    case 'hex':
+      ret = this.parent.hexWrite(string, this.offset + offset, maxLength);
+      break;
+
     case 'ucs2':
     case 'ucs-2':
       ret = this.parent.ucs2Write(string, this.offset + offset, maxLength);
@@ -290,6 +300,9 @@ Buffer.prototype.toString = function(encoding, start, end) {
     case 'base64':
       return this.parent.base64Slice(start, end);
 
+    case 'hex':
+      return this.parent.hexSlice(start, end);
+
     case 'ucs2':
     case 'ucs-2':
       return this.parent.ucs2Slice(start, end);
@@ -304,6 +317,39 @@ Buffer.prototype.toString = function(encoding, start, end) {
 Buffer.byteLength = SlowBuffer.byteLength;
 
 
+// isAscii(buffer), isUtf8(buffer)
+Buffer.isAscii = SlowBuffer.isAscii;
+Buffer.isUtf8 = SlowBuffer.isUtf8;
+
+
+// Statistics of the native allocator backing all SlowBuffers.
+Buffer.poolStats = SlowBuffer.poolStats;
+
+
+// concat(list, totalLength=sum of lengths)
+Buffer.concat = function(list, totalLength) {
+  if (!Array.isArray(list)) {
+    throw new Error('Usage: Buffer.concat(list, [totalLength])');
+  }
+
+  if (typeof totalLength !== 'number') {
+    if (list.length === 0) return new Buffer(0);
+    if (list.length === 1) return list[0];
+
+    totalLength = 0;
+    for (var i = 0; i < list.length; i++) {
+      totalLength += list[i].length;
+    }
+  } else if (list.length === 1 && totalLength === list[0].length) {
+    return list[0];
+  }
+
+  var buffer = new Buffer(totalLength);
+  SlowBuffer.concat(list, buffer);
+  return buffer;
+};
+
+
 // copy(targetBuffer, targetStart=0, sourceStart=0, sourceEnd=buffer.length)
 Buffer.prototype.copy = function(target, target_start, start, end) {
   var source = this;
@@ -355,6 +401,148 @@ Buffer.prototype.slice = function(start, end) {
 };
 
 
+// Typed accessors
+//
+// buffer.readUInt16LE(offset, noAssert=false) and friends. The 16 and 32
+// bit integers, floats and doubles are implemented by SlowBuffer in C++;
+// Buffer only checks the arguments against its own window and forwards.
+// Pass noAssert = true to skip those checks in hot loops: the native code
+// still refuses to touch memory outside of the parent SlowBuffer.
+
+function checkOffset(offset, size, length) {
+  if (typeof offset !== 'number' || offset < 0 || offset % 1 !== 0) {
+    throw new TypeError('offset must be a non-negative integer');
+  }
+  if (offset + size > length) {
+    throw new RangeError('Trying to access beyond buffer length');
+  }
+}
+
+
+function checkInt(value, min, max) {
+  if (typeof value !== 'number' || value % 1 !== 0) {
+    throw new TypeError('value must be an integer');
+  }
+  if (value < min || value > max) {
+    throw new RangeError('value is out of bounds');
+  }
+}
+
+
+function checkNumber(value) {
+  if (typeof value !== 'number') {
+    throw new TypeError('value must be a number');
+  }
+}
+
+
+var numberTypes = {
+  UInt16: { size: 2, min: 0, max: 0xffff },
+  Int16: { size: 2, min: -0x8000, max: 0x7fff },
+  UInt32: { size: 4, min: 0, max: 0xffffffff },
+  Int32: { size: 4, min: -0x80000000, max: 0x7fffffff },
+  Float: { size: 4 },
+  Double: { size: 8 }
+};
+
+Object.keys(numberTypes).forEach(function(type) {
+  var size = numberTypes[type].size;
+  var min = numberTypes[type].min;
+  var max = numberTypes[type].max;
+
+  ['LE', 'BE'].forEach(function(endian) {
+    var read = 'read' + type + endian;
+    var write = 'write' + type + endian;
+
+    Buffer.prototype[read] = function(offset, noAssert) {
+      if (!noAssert) checkOffset(offset, size, this.length);
+      return this.parent[read](this.offset + offset);
+    };
+
+    Buffer.prototype[write] = function(value, offset, noAssert) {
+      if (!noAssert) {
+        if (min === undefined) {
+          checkNumber(value);
+        } else {
+          checkInt(value, min, max);
+        }
+        checkOffset(offset, size, this.length);
+      }
+      this.parent[write](value, this.offset + offset);
+    };
+  });
+});
+
+
+// Single bytes go straight through the indexed external array.
+
+function readUInt8(offset, noAssert) {
+  if (!noAssert) checkOffset(offset, 1, this.length);
+  return this[offset];
+}
+
+function readInt8(offset, noAssert) {
+  if (!noAssert) checkOffset(offset, 1, this.length);
+  var v = this[offset];
+  return v & 0x80 ? v - 0x100 : v;
+}
+
+function writeUInt8(value, offset, noAssert) {
+  if (!noAssert) {
+    checkInt(value, 0, 0xff);
+    checkOffset(offset, 1, this.length);
+  }
+  this[offset] = value;
+}
+
+function writeInt8(value, offset, noAssert) {
+  if (!noAssert) {
+    checkInt(value, -0x80, 0x7f);
+    checkOffset(offset, 1, this.length);
+  }
+  this[offset] = value < 0 ? value + 0x100 : value;
+}
+
+Buffer.prototype.readUInt8 = SlowBuffer.prototype.readUInt8 = readUInt8;
+Buffer.prototype.readInt8 = SlowBuffer.prototype.readInt8 = readInt8;
+Buffer.prototype.writeUInt8 = SlowBuffer.prototype.writeUInt8 = writeUInt8;
+Buffer.prototype.writeInt8 = SlowBuffer.prototype.writeInt8 = writeInt8;
+
+
+// indexOf(needle, fromIndex=0)
+// needle is a byte value, a string (matched as utf8) or a Buffer.
+Buffer.prototype.indexOf = function(needle, fromIndex) {
+  fromIndex = +fromIndex || 0;
+  if (fromIndex < 0) fromIndex = Math.max(this.length + fromIndex, 0);
+  if (fromIndex > this.length) return -1;
+
+  var i = this.parent.indexOf(needle,
+                              this.offset + fromIndex,
+                              this.offset + this.length);
+  return i === -1 ? -1 : i - this.offset;
+};
+
+
+// lastIndexOf(needle, fromIndex=buffer.length)
+// Finds the last match that starts at or before fromIndex.
+Buffer.prototype.lastIndexOf = function(needle, fromIndex) {
+  var needleLength = typeof needle === 'string' ? Buffer.byteLength(needle) :
+                     typeof needle === 'number' ? 1 : needle.length;
+
+  if (fromIndex === undefined) {
+    fromIndex = this.length;
+  } else {
+    fromIndex = +fromIndex || 0;
+    if (fromIndex < 0) fromIndex += this.length;
+    if (fromIndex < 0) return -1;
+  }
+
+  var end = Math.min(this.length, fromIndex + needleLength);
+  var i = this.parent.lastIndexOf(needle, this.offset, this.offset + end);
+  return i === -1 ? -1 : i - this.offset;
+};
+
+
 // Legacy methods for backwards compatibility.
 
 Buffer.prototype.utf8Slice = function(start, end) {
@@ -381,3 +569,166 @@ Buffer.prototype.asciiWrite = function(string, offset) {
   return this.write(string, offset, 'ascii');
 };
 
+
+// BufferList
+//
+// Holds a queue of Buffers without copying them and lets parsers look at
+// the data as one contiguous byte sequence. Memory is only copied when a
+// slice spans more than one chunk.
+
+function BufferList() {
+  this.chunks = [];
+  this.length = 0;
+}
+exports.BufferList = BufferList;
+
+
+BufferList.prototype.push = function(buffer) {
+  if (!Buffer.isBuffer(buffer)) {
+    throw new TypeError('BufferList only holds Buffers');
+  }
+  if (buffer.length === 0) return this.length;
+  this.chunks.push(buffer);
+  this.length += buffer.length;
+  return this.length;
+};
+
+
+// Returns [chunkIndex, offsetInChunk] for the absolute index i.
+BufferList.prototype._locate = function(i) {
+  var chunks = this.chunks;
+  for (var c = 0; c < chunks.length; c++) {
+    if (i < chunks[c].length) return [c, i];
+    i -= chunks[c].length;
+  }
+  return [chunks.length, 0];
+};
+
+
+BufferList.prototype.get = function(i) {
+  if (i < 0 || i >= this.length) throw new Error('oob');
+  var pos = this._locate(i);
+  return this.chunks[pos[0]][pos[1]];
+};
+
+
+// slice(start=0, end=list.length)
+BufferList.prototype.slice = function(start, end) {
+  start = +start || 0;
+  if (end === undefined) end = this.length;
+  if (end > this.length) throw new Error('oob');
+  if (start < 0 || start > end) throw new Error('oob');
+
+  if (start === end) return new Buffer(0);
+
+  var pos = this._locate(start);
+  var c = pos[0];
+  var chunk = this.chunks[c];
+
+  // Fast path: the whole range lives inside a single chunk.
+  if (pos[1] + end - start <= chunk.length) {
+    return chunk.slice(pos[1], pos[1] + end - start);
+  }
+
+  var pieces = [chunk.slice(pos[1], chunk.length)];
+  var remaining = end - start - (chunk.length - pos[1]);
+  while (remaining > 0) {
+    chunk = this.chunks[++c];
+    if (remaining < chunk.length) {
+      pieces.push(chunk.slice(0, remaining));
+      break;
+    }
+    pieces.push(chunk);
+    remaining -= chunk.length;
+  }
+
+  return Buffer.concat(pieces, end - start);
+};
+
+
+// indexOf(needle, fromIndex=0)
+// needle may be a byte value, a string or a Buffer. Returns -1 when the
+// needle does not occur.
+BufferList.prototype.indexOf = function(needle, fromIndex) {
+  if (typeof needle === 'number') {
+    needle = new Buffer([needle & 255]);
+  } else if (typeof needle === 'string') {
+    needle = new Buffer(needle);
+  } else if (!Buffer.isBuffer(needle)) {
+    throw new TypeError('needle must be a number, string or Buffer');
+  }
+
+  var n = needle.length;
+  var from = +fromIndex || 0;
+  if (from < 0) from = 0;
+  if (n === 0) return from <= this.length ? from : -1;
+
+  var chunks = this.chunks;
+  for (var c = 0, base = 0; c < chunks.length; base += chunks[c++].length) {
+    var chunk = chunks[c];
+    if (base + chunk.length <= from) continue;
+
+    // Matches inside the chunk are found natively...
+    var start = Math.max(from - base, 0);
+    var i = chunk.indexOf(needle, start);
+    if (i !== -1) return base + i;
+
+    // ...and only the few windows straddling the next chunk are walked here.
+    for (i = Math.max(start, chunk.length - n + 1); i < chunk.length; i++) {
+      if (base + i + n > this.length) return -1;
+      if (this._matchAt(c, i, needle)) return base + i;
+    }
+  }
+
+  return -1;
+};
+
+
+BufferList.prototype._matchAt = function(c, i, needle) {
+  var chunks = this.chunks;
+  for (var k = 0; k < needle.length; k++, i++) {
+    if (i === chunks[c].length) {
+      c++;
+      i = 0;
+    }
+    if (chunks[c][i] !== needle[k]) return false;
+  }
+  return true;
+};
+
+
+// Drops the first n bytes from the list.
+BufferList.prototype.consume = function(n) {
+  n = Math.min(+n || 0, this.length);
+  this.length -= n;
+
+  var chunks = this.chunks;
+  while (n > 0) {
+    var chunk = chunks[0];
+    if (n < chunk.length) {
+      chunks[0] = chunk.slice(n, chunk.length);
+      break;
+    }
+    chunks.shift();
+    n -= chunk.length;
+  }
+};
+
+
+// Removes and returns the first n bytes.
+BufferList.prototype.take = function(n) {
+  var buffer = this.slice(0, n);
+  this.consume(n);
+  return buffer;
+};
+
+
+BufferList.prototype.toBuffer = function() {
+  return Buffer.concat(this.chunks, this.length);
+};
+
+
+BufferList.prototype.toString = function(encoding, start, end) {
+  return this.slice(start, end).toString(encoding);
+};
+
@@ -1,5 +1,3 @@
-var writeError = process.binding('stdio').writeError;
-
 // console object
 var formatRegExp = /%[sdj]/g;
 function format(f) {
@@ -45,7 +43,7 @@ exports.info = exports.log;
 
 
 exports.warn = function() {
-  writeError(format.apply(this, arguments) + '\n');
+  process.stderr.write(format.apply(this, arguments) + '\n');
 };
 
 
@@ -114,3 +114,19 @@ exports.Verify = Verify;
 exports.createVerify = function(algorithm) {
   return (new Verify).init(algorithm);
 };
+
+
+// crypto.hashFile(path, algorithm, [encoding], callback)
+// Digests a file on the thread pool without reading it into memory. The
+// digest is a Buffer unless an encoding is given.
+exports.hashFile = function(path, algorithm, encoding, callback) {
+  if (typeof encoding == 'function') {
+    callback = encoding;
+    encoding = null;
+  }
+
+  binding.hashFile(path, algorithm, function(err, digest) {
+    if (err) return callback(err);
+    callback(null, encoding ? digest.toString(encoding) : digest);
+  });
+};
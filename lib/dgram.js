@@ -9,6 +9,8 @@ var constants = process.binding('constants');
 
 var socket = binding.socket;
 var recvfrom = binding.recvfrom;
+var recvMany = binding.recvMany;
+var sendMany = binding.sendMany;
 var close = binding.close;
 
 var ENOENT = constants.ENOENT;
@@ -16,11 +18,11 @@ var ENOENT = constants.ENOENT;
 function isPort(x) { return parseInt(x) >= 0; }
 var pool = null;
 
-function getPool() {
+function getPool(minPoolAvail) {
   /* TODO: this effectively limits you to 8kb maximum packet sizes */
-  var minPoolAvail = 1024 * 8;
+  minPoolAvail = minPoolAvail || 1024 * 8;
 
-  var poolSize = 1024 * 64;
+  var poolSize = Math.max(1024 * 64, minPoolAvail * 4);
 
   if (pool === null || (pool.used + minPoolAvail > pool.length)) {
     pool = new Buffer(poolSize);
@@ -60,6 +62,8 @@ function Socket(type, listener) {
   self.watcher = new IOWatcher();
   self.watcher.host = self;
   self.watcher.callback = function() {
+    if (self._recvBatch) return self._receiveBatch();
+
     while (self.fd) {
       var p = getPool();
       var rinfo = recvfrom(self.fd, p, p.used, p.length - p.used, 0);
@@ -84,6 +88,58 @@ exports.createSocket = function(type, listener) {
   return new Socket(type, listener);
 };
 
+// socket.setRecvBatch(count, [maxSize])
+// Read up to count datagrams of at most maxSize bytes per system call and
+// emit them together as a 'messages' event. Longer datagrams are cut short
+// and flagged in info.truncated. A count of 0 switches back to one datagram
+// per read.
+Socket.prototype.setRecvBatch = function(count, maxSize) {
+  if (!recvMany) throw new Error('Batched receive is not supported');
+
+  count = parseInt(count, 10) || 0;
+  if (count < 0 || count > 64) {
+    throw new Error('Batch count must be between 0 and 64');
+  }
+
+  this._recvBatch = count;
+  this._recvBatchSize = parseInt(maxSize, 10) || 2048;
+};
+
+
+Socket.prototype._receiveBatch = function() {
+  var count = this._recvBatch;
+  var need = count * this._recvBatchSize;
+
+  while (this.fd) {
+    var p = getPool(need);
+    var info = recvMany(this.fd, p, p.used, need, count);
+
+    if (!info) return;
+
+    var chunk = p.slice(p.used, p.used + info.size);
+    p.used += info.size;
+
+    // chunk holds the datagrams back to back; info.offsets[i] and
+    // info.lengths[i] locate datagram i and info.from[i] is its sender.
+    this.emit('messages', chunk, info);
+
+    if (this.listeners('message').length) {
+      for (var i = 0; i < info.offsets.length; i++) {
+        var start = info.offsets[i], size = info.lengths[i];
+        var rinfo = { address: info.from[i].address,
+                      port: info.from[i].port,
+                      size: size };
+        if (info.truncated[i]) rinfo.truncated = true;
+        this.emit('message', chunk.slice(start, start + size), rinfo);
+      }
+    }
+
+    // A short batch means the socket has been drained.
+    if (info.offsets.length < count) return;
+  }
+};
+
+
 Socket.prototype.bind = function() {
   var self = this;
 
@@ -269,6 +325,53 @@ Socket.prototype.sendto = function(buffer,
   }
 };
 
+// socket.sendBatch(messages, [callback])
+// messages is an array of { buffer, offset, length, port, address } (or
+// { buffer, offset, length, path } for unix_dgram). Addresses must be IPs.
+// As many as possible go out in one system call per 64 messages; callback
+// gets (err, count) with the number of datagrams handed to the kernel.
+// Sending stops at the first message that fails: err is its error (EAGAIN
+// if the send buffer filled up, EMSGSIZE, ECONNREFUSED...) and the messages
+// from count on were not sent.
+Socket.prototype.sendBatch = function(messages, callback) {
+  var sent = 0;
+
+  try {
+    if (!sendMany) throw new Error('Batched send is not supported');
+
+    while (sent < messages.length) {
+      var batch = [];
+      for (var i = sent; i < messages.length && batch.length < 64; i++) {
+        var m = messages[i];
+        var offset = m.offset || 0;
+        var length = m.length === undefined ? m.buffer.length - offset
+                                            : m.length;
+        if (this.type === 'unix_dgram') {
+          batch.push([m.buffer, offset, length, m.path]);
+        } else {
+          batch.push([m.buffer, offset, length, m.port, m.address]);
+        }
+      }
+
+      var n = sendMany(this.fd, batch);
+      sent += n;
+      if (n < batch.length) {
+        throw binding.errnoException(sendMany.errno, 'sendmmsg');
+      }
+    }
+  } catch (err) {
+    if (callback) {
+      callback(err, sent);
+    }
+    return sent;
+  }
+
+  if (callback) {
+    callback(null, sent);
+  }
+  return sent;
+};
+
 Socket.prototype.close = function() {
   var self = this;
 
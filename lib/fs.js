@@ -62,20 +62,7 @@ fs.readFile = function(path, encoding_) {
 
   readStream.on('end', function() {
     // copy all the buffers into one
-    var buffer;
-    switch (buffers.length) {
-      case 0: buffer = new Buffer(0); break;
-      case 1: buffer = buffers[0]; break;
-      default: // concat together
-        buffer = new Buffer(nread);
-        var n = 0;
-        buffers.forEach(function(b) {
-          var l = b.length;
-          b.copy(buffer, n, 0, l);
-          n += l;
-        });
-        break;
-    }
+    var buffer = Buffer.concat(buffers, nread);
     if (encoding) {
       try {
         buffer = buffer.toString(encoding);
@@ -107,14 +94,9 @@ fs.readFileSync = function(path, encoding) {
   fs.closeSync(fd);
 
   if (buffers.length > 1) {
-    var offset = 0;
-    var i;
-    buffer = new Buffer(nread);
-    buffers.forEach(function(i) {
-      if (!i._bytesRead) return;
-      i.copy(buffer, offset, 0, i._bytesRead);
-      offset += i._bytesRead;
-    });
+    buffer = Buffer.concat(buffers.map(function(b) {
+      return b.slice(0, b._bytesRead);
+    }), nread);
   } else if (buffers.length) {
     // buffers has exactly 1 (possibly zero length) buffer, so this should
     // be a shortcut
@@ -946,6 +928,11 @@ var WriteStream = fs.WriteStream = function(path, options) {
   this.encoding = 'binary';
   this.mode = parseInt('0666', 8);
 
+  // Group commit policy, see _flushWrites().
+  this.maxLatency = 0;
+  this.maxBytes = null;
+  this.syncInterval = 0;
+
   options = options || {};
 
   // Mixin options into this
@@ -957,6 +944,10 @@ var WriteStream = fs.WriteStream = function(path, options) {
 
   this.busy = false;
   this._queue = [];
+  this._pendingBytes = 0;
+  this._flushTimer = null;
+  this._syncTimer = null;
+  this._unsynced = false;
 
   if (this.fd === null) {
     this._queue.push([fs.open, this.path, this.flags, this.mode, undefined]);
@@ -982,7 +973,10 @@ WriteStream.prototype.flush = function() {
   var method = args.shift(),
       cb = args.pop();
 
-  var self = this;
+  if (method === fs.write) {
+    this._flushWrites(args[0], cb);
+    return;
+  }
 
   args.push(function(err) {
     self.busy = false;
@@ -1025,6 +1019,127 @@ WriteStream.prototype.flush = function() {
   method.apply(this, args);
 };
 
+// Most bytes _flushWrites() copies into one buffer when maxBytes is unset.
+var MAX_GROUP_BYTES = 64 * 1024;
+
+// Group commit: the writes queued behind the first one go to the file with
+// it, as one contiguous buffer and a single fs.write(), up to maxBytes (or
+// MAX_GROUP_BYTES) in all. Writes made while a flush is in progress
+// therefore cost one thread pool round trip per group, not one each.
+WriteStream.prototype._flushWrites = function(first, cb) {
+  var self = this;
+  var buffers = [first];
+  var callbacks = [cb];
+  var length = first.length;
+  var limit = this.maxBytes || MAX_GROUP_BYTES;
+
+  while (this._queue.length > 0 && this._queue[0][0] === fs.write &&
+         length + this._queue[0][1].length <= limit) {
+    var args = this._queue.shift();
+    buffers.push(args[1]);
+    callbacks.push(args[5]);
+    length += args[1].length;
+  }
+
+  this._pendingBytes -= length;
+  if (this._flushTimer) {
+    clearTimeout(this._flushTimer);
+    this._flushTimer = null;
+  }
+
+  var data = first;
+  if (buffers.length > 1) {
+    data = new Buffer(length);
+    for (var i = 0, offset = 0; i < buffers.length; i++) {
+      buffers[i].copy(data, offset, 0);
+      offset += buffers[i].length;
+    }
+  }
+
+  function done(err) {
+    self.busy = false;
+
+    for (var i = 0; i < callbacks.length; i++) {
+      if (!callbacks[i]) continue;
+      if (err) {
+        callbacks[i](err);
+      } else {
+        callbacks[i](null, buffers[i].length);
+      }
+    }
+
+    if (err) {
+      self.writable = false;
+      self.emit('error', err);
+      return;
+    }
+
+    self._unsynced = true;
+    self._scheduleSync();
+    self.flush();
+  }
+
+  (function writeOut(offset) {
+    fs.write(self.fd, data, offset, length - offset, null,
+             function(err, written) {
+      if (err) return done(err);
+      offset += written;
+      if (offset >= length) return done(null);
+      // Retrying a write that wrote nothing would just spin; fail rather
+      // than drop the rest.
+      if (written === 0) {
+        return done(new Error('Short write: ' + offset + ' of ' + length +
+                              ' bytes written'));
+      }
+      writeOut(offset);
+    });
+  })(0);
+};
+
+// With maxLatency set, a write may wait that many milliseconds to be
+// grouped with later ones, unless maxBytes are already pending.
+WriteStream.prototype._scheduleFlush = function() {
+  if (!this.maxLatency ||
+      (this.maxBytes && this._pendingBytes >= this.maxBytes)) {
+    this.flush();
+    return;
+  }
+
+  if (this._flushTimer) return;
+
+  var self = this;
+  this._flushTimer = setTimeout(function() {
+    self._flushTimer = null;
+    self.flush();
+  }, this.maxLatency);
+};
+
+// With syncInterval set, written data is fdatasync()ed at most that many
+// milliseconds after it was written.
+WriteStream.prototype._scheduleSync = function() {
+  if (!this.syncInterval || this._syncTimer) return;
+
+  var self = this;
+  this._syncTimer = setTimeout(function() {
+    self._syncTimer = null;
+    if (!self.writable) return;
+    self._unsynced = false;
+    self._queue.push([fs.fdatasync, undefined]);
+    self.flush();
+  }, this.syncInterval);
+};
+
+WriteStream.prototype._clearTimers = function() {
+  if (this._flushTimer) {
+    clearTimeout(this._flushTimer);
+    this._flushTimer = null;
+  }
+  if (this._syncTimer) {
+    clearTimeout(this._syncTimer);
+    this._syncTimer = null;
+  }
+};
+
 WriteStream.prototype.write = function(data) {
   if (!this.writable) {
     throw new Error('stream not writable');
@@ -1037,22 +1152,26 @@ WriteStream.prototype.write = function(data) {
     cb = arguments[arguments.length - 1];
   }
 
-  if (Buffer.isBuffer(data)) {
-    this._queue.push([fs.write, data, 0, data.length, null, cb]);
-  } else {
+  if (!Buffer.isBuffer(data)) {
     var encoding = 'utf8';
     if (typeof(arguments[1]) == 'string') encoding = arguments[1];
-    this._queue.push([fs.write, data, undefined, encoding, cb]);
+    data = new Buffer(String(data), encoding);
   }
 
+  this._queue.push([fs.write, data, 0, data.length, null, cb]);
+  this._pendingBytes += data.length;
 
-  this.flush();
+  this._scheduleFlush();
 
   return false;
 };
 
 WriteStream.prototype.end = function(cb) {
   this.writable = false;
+  this._clearTimers();
+  if (this.syncInterval && (this._unsynced || this._pendingBytes > 0)) {
+    this._queue.push([fs.fdatasync, undefined]);
+  }
   this._queue.push([fs.close, cb]);
   this.flush();
 };
@@ -1060,6 +1179,7 @@ WriteStream.prototype.end = function(cb) {
 WriteStream.prototype.destroy = function(cb) {
   var self = this;
   this.writable = false;
+  this._clearTimers();
 
   function close() {
     fs.close(self.fd, function(err) {
@@ -4,6 +4,7 @@ var stream = require('stream');
 var EventEmitter = require('events').EventEmitter;
 var FreeList = require('freelist').FreeList;
 var HTTPParser = process.binding('http_parser').HTTPParser;
+var writer = process.binding('http_writer');
 var assert = require('assert').ok;
 
 
@@ -20,8 +21,7 @@ var parsers = new FreeList('parsers', 1000, function() {
 
   parser.onMessageBegin = function() {
     parser.incoming = new IncomingMessage(parser.socket);
-    parser.field = null;
-    parser.value = null;
+    parser.incoming._parser = parser;
   };
 
   // Only servers will get URL events.
@@ -35,35 +35,11 @@ var parsers = new FreeList('parsers', 1000, function() {
     }
   };
 
-  parser.onHeaderField = function(b, start, len) {
-    var slice = b.toString('ascii', start, start + len).toLowerCase();
-    if (parser.value != undefined) {
-      parser.incoming._addHeaderLine(parser.field, parser.value);
-      parser.field = null;
-      parser.value = null;
-    }
-    if (parser.field) {
-      parser.field += slice;
-    } else {
-      parser.field = slice;
-    }
-  };
-
-  parser.onHeaderValue = function(b, start, len) {
-    var slice = b.toString('ascii', start, start + len);
-    if (parser.value) {
-      parser.value += slice;
-    } else {
-      parser.value = slice;
-    }
-  };
-
+  // The header names arrive lower-cased, and interned when they are
+  // common ones. The values stay in the parsed Buffer until req.headers is
+  // first used.
   parser.onHeadersComplete = function(info) {
-    if (parser.field && (parser.value != undefined)) {
-      parser.incoming._addHeaderLine(parser.field, parser.value);
-      parser.field = null;
-      parser.value = null;
-    }
+    if (info.headerNames) parser.incoming._rawHeaders = info;
 
     parser.incoming.httpVersionMajor = info.versionMajor;
     parser.incoming.httpVersionMinor = info.versionMinor;
@@ -72,6 +48,8 @@ var parsers = new FreeList('parsers', 1000, function() {
     if (info.method) {
       // server only
       parser.incoming.method = info.method;
+      info.url = parser.incoming.url;
+      parser.incoming._urlInfo = info;
     } else {
       // client only
       parser.incoming.statusCode = info.statusCode;
@@ -91,21 +69,19 @@ var parsers = new FreeList('parsers', 1000, function() {
   };
 
   parser.onBody = function(b, start, len) {
-    // TODO body encoding?
-    var slice = b.slice(start, start + len);
-    if (parser.incoming._decoder) {
-      var string = parser.incoming._decoder.write(slice);
-      if (string.length) parser.incoming.emit('data', string);
-    } else {
-      parser.incoming.emit('data', slice);
-    }
+    parser.incoming._emitData(b.slice(start, start + len));
+  };
+
+  // With request.setBodyMode() the parser collects the body itself and
+  // calls this once per socket read.
+  parser.onBodyRead = function() {
+    parser.incoming._collectedBody(false);
   };
 
-  parser.onMessageComplete = function() {
+  parser.onMessageComplete = function(trailers) {
     this.incoming.complete = true;
-    if (parser.field && (parser.value != undefined)) {
-      parser.incoming._addHeaderLine(parser.field, parser.value);
-    }
+    if (trailers) parser.incoming._rawTrailers = trailers;
+    if (parser.incoming._bodyMode) parser.incoming._collectedBody(true);
     if (!parser.incoming.upgrade) {
       // For upgraded connections, also emit this after parser.execute
       parser.incoming.emit('end');
@@ -174,14 +150,48 @@ var STATUS_CODES = exports.STATUS_CODES = {
 };
 
 
-var connectionExpression = /Connection/i;
-var transferEncodingExpression = /Transfer-Encoding/i;
-var closeExpression = /close/i;
-var chunkExpression = /chunk/i;
-var contentLengthExpression = /Content-Length/i;
-var expectExpression = /Expect/i;
 var continueExpression = /100-continue/i;
 
+writer.setStatusLines(STATUS_CODES);
+
+var writeHeader = writer.writeHeader;
+var HEADER_KEEP_ALIVE = writer.HEADER_KEEP_ALIVE;
+var HEADER_CHUNKED_DEFAULT = writer.HEADER_CHUNKED_DEFAULT;
+var HEADER_BODYLESS = writer.HEADER_BODYLESS;
+var HEADER_HAS_BODY = writer.HEADER_HAS_BODY;
+var HEADER_LAST = writer.HEADER_LAST;
+var HEADER_CHUNKED = writer.HEADER_CHUNKED;
+var HEADER_CONNECTION = writer.HEADER_CONNECTION;
+var HEADER_EXPECT = writer.HEADER_EXPECT;
+
+// Outgoing headers are serialized into a shared pool. Each message keeps
+// its slice of the pool in _header.
+var kHeaderPoolSize = 16 * 1024;
+var headerPool = null;
+var headerState = [0];
+
+function allocHeaderPool(size) {
+  headerPool = new Buffer(size);
+  headerPool.used = 0;
+}
+
+// Buffer chunks of a chunked body are framed without touching their data:
+// the '<hex length>\r\n' line is written into the header pool natively and
+// sent together with the chunk and a shared CRLF in one writev().
+var writeChunkHeader = writer.writeChunkHeader;
+var kChunkHeaderMax = 18;
+var crlfBuffer = new Buffer(CRLF);
+var lastChunkBuffer = new Buffer('\r\n0\r\n\r\n');
+
+function chunkHeader(size) {
+  if (!headerPool || headerPool.length - headerPool.used < kChunkHeaderMax) {
+    allocHeaderPool(kHeaderPoolSize);
+  }
+  var start = headerPool.used;
+  headerPool.used += writeChunkHeader(headerPool, start, size);
+  return headerPool.slice(start, headerPool.used);
+}
+
 
 /* Abstract base class for ServerRequest and ClientResponse. */
 function IncomingMessage(socket) {
@@ -193,8 +203,14 @@ function IncomingMessage(socket) {
 
   this.httpVersion = null;
   this.complete = false;
-  this.headers = {};
-  this.trailers = {};
+  this._headers = null;
+  this._trailers = null;
+  this._rawHeaders = null;
+  this._rawTrailers = null;
+
+  this._parser = null;
+  this._bodyMode = null;
+  this._bodySize = 0;
 
   this.readable = true;
 
@@ -213,6 +229,127 @@ util.inherits(IncomingMessage, stream.Stream);
 exports.IncomingMessage = IncomingMessage;
 
 
+// request.pathname, request.query
+// The parser reports where the path and the query string sit in the URL,
+// so routing does not need a full url.parse() per request. Both are
+// computed on first use, and again if request.url is rewritten.
+function parsedUrlInfo(req) {
+  var info = req._urlInfo;
+  return info && info.url === req.url ? info : null;
+}
+
+
+IncomingMessage.prototype.__defineGetter__('pathname', function() {
+  if (this._pathnameUrl !== this.url) {
+    var info = parsedUrlInfo(this);
+    if (info && info.pathStart !== undefined) {
+      this._pathname = this.url.slice(info.pathStart, info.pathEnd);
+    } else {
+      this._pathname = require('url').parse(this.url).pathname;
+    }
+    this._pathnameUrl = this.url;
+  }
+  return this._pathname;
+});
+
+IncomingMessage.prototype.__defineSetter__('pathname', function(value) {
+  this._pathname = value;
+  this._pathnameUrl = this.url;
+});
+
+
+IncomingMessage.prototype.__defineGetter__('query', function() {
+  if (this._queryUrl !== this.url) {
+    var info = parsedUrlInfo(this);
+    if (!info) {
+      this._query = require('url').parse(this.url, true).query || {};
+    } else if (info.queryStart !== undefined) {
+      this._query = require('querystring').parse(
+          this.url.slice(info.queryStart, info.queryEnd));
+    } else {
+      this._query = {};
+    }
+    this._queryUrl = this.url;
+  }
+  return this._query;
+});
+
+IncomingMessage.prototype.__defineSetter__('query', function(value) {
+  this._query = value;
+  this._queryUrl = this.url;
+});
+
+
+// request.headers, request.trailers
+// Built from the parser's header lines the first time they are used.
+IncomingMessage.prototype._buildHeaders = function(raw, dest) {
+  var names = raw.headerNames;
+  var values = raw.headerValues;
+  var offsets = raw.headerOffsets;
+  for (var i = 0, l = names.length; i < l; i++) {
+    this._addHeaderLine(names[i],
+                        values.toString('ascii', offsets[2 * i],
+                                        offsets[2 * i + 1]),
+                        dest);
+  }
+};
+
+
+IncomingMessage.prototype.__defineGetter__('headers', function() {
+  if (!this._headers) {
+    this._headers = {};
+    if (this._rawHeaders) {
+      this._buildHeaders(this._rawHeaders, this._headers);
+      this._rawHeaders = null;
+    }
+  }
+  return this._headers;
+});
+
+IncomingMessage.prototype.__defineSetter__('headers', function(value) {
+  this._headers = value;
+  this._rawHeaders = null;
+});
+
+
+IncomingMessage.prototype.__defineGetter__('trailers', function() {
+  if (!this._trailers) {
+    this._trailers = {};
+    if (this._rawTrailers) {
+      this._buildHeaders(this._rawTrailers, this._trailers);
+      this._rawTrailers = null;
+    }
+  }
+  return this._trailers;
+});
+
+IncomingMessage.prototype.__defineSetter__('trailers', function(value) {
+  this._trailers = value;
+  this._rawTrailers = null;
+});
+
+
+// request.headers[name] without building request.headers. Repeated lines
+// are combined by _addHeaderLine() just as they would be there. name must
+// be lower case.
+IncomingMessage.prototype._getHeader = function(name) {
+  var raw = this._rawHeaders;
+  if (!raw) return this.headers[name];
+
+  var names = raw.headerNames;
+  var dest = null;
+  for (var i = 0, l = names.length; i < l; i++) {
+    if (names[i] === name) {
+      var value = raw.headerValues.toString('ascii', raw.headerOffsets[2 * i],
+                                            raw.headerOffsets[2 * i + 1]);
+      if (!dest) dest = {};
+      this._addHeaderLine(name, value, dest);
+    }
+  }
+  return dest ? dest[name] : undefined;
+};
+
+
 IncomingMessage.prototype.destroy = function(error) {
   this.socket.destroy(error);
 };
@@ -224,6 +361,86 @@ IncomingMessage.prototype.setEncoding = function(encoding) {
 };
 
 
+IncomingMessage.prototype._emitData = function(chunk) {
+  if (this._decoder) {
+    var string = this._decoder.write(chunk);
+    if (string.length) this.emit('data', string);
+  } else {
+    this.emit('data', chunk);
+  }
+};
+
+
+// request.setBodyMode(mode, [size])
+// How the body is delivered:
+//   'chunk'      one 'data' event per piece the parser finds (default)
+//   'read'       one 'data' event per socket read
+//   'watermark'  'data' events of at least size bytes, the last one
+//                excepted
+//   'body'       a single 'body' event with the whole body as one Buffer,
+//                at most size bytes of it if size is given
+// In all but 'chunk' the parser copies the body into one growing pooled
+// buffer instead of handing out a slice for every piece.
+IncomingMessage.prototype.setBodyMode = function(mode, size) {
+  if (mode != 'chunk' && mode != 'read' &&
+      mode != 'watermark' && mode != 'body') {
+    throw new Error('Unknown body mode: ' + mode);
+  }
+  if (mode == 'watermark' && !(size > 0)) {
+    throw new TypeError('watermark mode needs a size');
+  }
+
+  var parser = this._parser;
+  if (this.complete || !parser || parser.incoming !== this) return;
+
+  // Whatever is collected so far goes out as 'data', unless it is to
+  // become part of a 'body'.
+  if (this._bodyMode && mode != 'body' && parser.bodyLength() > 0) {
+    this._emitData(this._takeBody());
+  }
+
+  this._bodyMode = mode == 'chunk' ? null : mode;
+  this._bodySize = size || 0;
+  parser.collectBody(this._bodyMode !== null,
+                     mode == 'body' ? this._bodySize : 0);
+};
+
+
+IncomingMessage.prototype._takeBody = function() {
+  var slow = this._parser.takeBody();
+  return slow ? new Buffer(slow, slow.length, 0) : new Buffer(0);
+};
+
+
+IncomingMessage.prototype._collectedBody = function(last) {
+  var length = this._parser.bodyLength();
+
+  if (this._bodyMode == 'body') {
+    if (length < 0) {
+      if (!this._bodyTooLarge) {
+        this._bodyTooLarge = true;
+        var e = new Error('Body larger than ' + this._bodySize + ' bytes');
+        e.code = 'EMSGSIZE';
+        if (this.listeners('error').length) {
+          this.emit('error', e);
+        } else {
+          this.destroy(e);
+        }
+      }
+    } else if (last) {
+      this.emit('body', this._takeBody());
+    }
+    return;
+  }
+
+  if (length <= 0) return;
+  if (!last && this._bodyMode == 'watermark' && length < this._bodySize) {
+    return;
+  }
+  this._emitData(this._takeBody());
+};
+
+
 IncomingMessage.prototype.pause = function() {
   this.socket.pause();
 };
@@ -241,8 +458,8 @@ IncomingMessage.prototype.resume = function() {
 // multiple values this way. If not, we declare the first instance the winner
 // and drop the second. Extended header fields (those beginning with 'x-') are
 // always joined.
-IncomingMessage.prototype._addHeaderLine = function(field, value) {
-  var dest = this.complete ? this.trailers : this.headers;
+IncomingMessage.prototype._addHeaderLine = function(field, value, dest) {
+  if (!dest) dest = this.complete ? this.trailers : this.headers;
 
   switch (field) {
     // Array headers:
@@ -339,7 +556,7 @@ OutgoingMessage.prototype._send = function(data, encoding) {
   // this at a lower level and in a more general way.
   if (!this._headerSent) {
     if (typeof data === 'string') {
-      data = this._header + data;
+      data = this._headerAnd(data, encoding);
     } else {
       this.output.unshift(this._header);
       this.outputEncodings.unshift('ascii');
@@ -374,6 +591,34 @@ OutgoingMessage.prototype._writeRaw = function(data, encoding) {
 };
 
 
+// Sends a list of Buffers, preceded by the header if it has not gone out
+// yet. They leave with a single writev() unless output is queued ahead of
+// them.
+OutgoingMessage.prototype._sendBuffers = function(buffers) {
+  if (!this._headerSent) {
+    buffers.unshift(this._header);
+    this._headerSent = true;
+  }
+
+  // Only net.Socket has _writeBuffers(); a TLS CleartextStream gets the
+  // buffers one by one.
+  var connection = this.connection;
+  if (this.output.length === 0 &&
+      connection &&
+      connection._httpMessage === this &&
+      connection.writable &&
+      typeof connection._writeBuffers === 'function') {
+    return connection._writeBuffers(buffers);
+  }
+
+  var ret;
+  for (var i = 0; i < buffers.length; i++) {
+    ret = this._writeRaw(buffers[i]);
+  }
+  return ret;
+};
+
+
 OutgoingMessage.prototype._buffer = function(data, encoding) {
   if (data.length === 0) return;
 
@@ -401,40 +646,12 @@ OutgoingMessage.prototype._buffer = function(data, encoding) {
 };
 
 
-OutgoingMessage.prototype._storeHeader = function(firstLine, headers) {
-  var sentConnectionHeader = false;
-  var sentContentLengthHeader = false;
-  var sentTransferEncodingHeader = false;
-  var sentExpect = false;
-
-  // firstLine in the case of request is: 'GET /index.html HTTP/1.1\r\n'
-  // in the case of response it is: 'HTTP/1.1 200 OK\r\n'
-  var messageHeader = firstLine;
-  var field, value;
-  var self = this;
-
-  function store(field, value) {
-    messageHeader += field + ': ' + value + CRLF;
-
-    if (connectionExpression.test(field)) {
-      sentConnectionHeader = true;
-      if (closeExpression.test(value)) {
-        self._last = true;
-      } else {
-        self.shouldKeepAlive = true;
-      }
-
-    } else if (transferEncodingExpression.test(field)) {
-      sentTransferEncodingHeader = true;
-      if (chunkExpression.test(value)) self.chunkedEncoding = true;
-
-    } else if (contentLengthExpression.test(field)) {
-      sentContentLengthHeader = true;
-
-    } else if (expectExpression.test(field)) {
-      sentExpect = true;
-    }
-  }
+// firstLine in the case of request is: 'GET /index.html HTTP/1.1\r\n'
+// in the case of response it is the status code, sent with reasonPhrase.
+OutgoingMessage.prototype._storeHeader = function(firstLine, headers,
+                                                  reasonPhrase) {
+  var fields = [];
+  var values = [];
 
   if (headers) {
     var keys = Object.keys(headers);
@@ -453,45 +670,73 @@ OutgoingMessage.prototype._storeHeader = function(firstLine, headers) {
 
       if (Array.isArray(value)) {
         for (var j = 0; j < value.length; j++) {
-          store(field, value[j]);
+          fields.push(field);
+          values.push(value[j]);
         }
       } else {
-        store(field, value);
+        fields.push(field);
+        values.push(value);
       }
     }
   }
 
-  // keep-alive logic
-  if (sentConnectionHeader == false) {
-    if (this.shouldKeepAlive &&
-        (sentContentLengthHeader || this.useChunkedEncodingByDefault)) {
-      messageHeader += 'Connection: keep-alive\r\n';
-    } else {
-      this._last = true;
-      messageHeader += 'Connection: close\r\n';
-    }
-  }
+  var flags = 0;
+  if (this.shouldKeepAlive) flags |= HEADER_KEEP_ALIVE;
+  if (this.useChunkedEncodingByDefault) flags |= HEADER_CHUNKED_DEFAULT;
+  if (this._bodyless) flags |= HEADER_BODYLESS;
+  if (this._hasBody) flags |= HEADER_HAS_BODY;
 
-  if (sentContentLengthHeader == false && sentTransferEncodingHeader == false) {
-    if (this._hasBody) {
-      if (this.useChunkedEncodingByDefault) {
-        messageHeader += 'Transfer-Encoding: chunked\r\n';
-        this.chunkedEncoding = true;
-      } else {
-        this._last = true;
-      }
-    } else {
-      // Make sure we don't end the 0\r\n\r\n at the end of the message.
-      this.chunkedEncoding = false;
-    }
+  if (!headerPool) allocHeaderPool(kHeaderPoolSize);
+
+  var n = writeHeader(headerPool, headerPool.used, firstLine, reasonPhrase,
+                      fields, values, flags, headerState);
+
+  // Not enough room left in the pool. Start a new one, bigger than usual
+  // if the header is huge.
+  for (var size = kHeaderPoolSize; n < 0; size *= 2) {
+    allocHeaderPool(size);
+    n = writeHeader(headerPool, 0, firstLine, reasonPhrase,
+                    fields, values, flags, headerState);
   }
 
-  this._header = messageHeader + CRLF;
+  var start = headerPool.used;
+  headerPool.used += n;
+
+  var state = headerState[0];
+  if (state & HEADER_LAST) this._last = true;
+  if (state & HEADER_CONNECTION) this.shouldKeepAlive = true;
+  this.chunkedEncoding = (state & HEADER_CHUNKED) != 0;
+
+  this._header = headerPool.slice(start, headerPool.used);
+  this._headerPool = headerPool;
   this._headerSent = false;
 
   // wait until the first body chunk, or close(), is sent to flush,
   // UNLESS we're sending Expect: 100-continue.
-  if (sentExpect) this._send('');
+  if (state & HEADER_EXPECT) this._send('');
+};
+
+
+// Joins the header and the first string chunk of the body so they go out
+// in one write. The body is encoded into the pool right behind the header
+// when there is room for it.
+OutgoingMessage.prototype._headerAnd = function(data, encoding) {
+  var header = this._header;
+  var pool = this._headerPool;
+  var len = Buffer.byteLength(data, encoding);
+
+  if (pool === headerPool &&
+      pool.used === header.offset - pool.offset + header.length &&
+      len <= pool.length - pool.used) {
+    pool.write(data, pool.used, encoding);
+    pool.used += len;
+    return pool.slice(pool.used - len - header.length, pool.used);
+  }
+
+  var buffer = new Buffer(header.length + len);
+  header.copy(buffer, 0);
+  buffer.write(data, header.length, encoding);
+  return buffer;
 };
 
 
@@ -581,6 +826,17 @@ OutgoingMessage.prototype.write = function(chunk, encoding) {
 
   if (chunk.length === 0) return false;
 
+  if (this._zstream) {
+    var ok = this._zstream.write(chunk, encoding);
+    return ok && this._zret !== false;
+  }
+
+  return this._writeBody(chunk, encoding);
+};
+
+
+// Frames and sends one chunk of the body.
+OutgoingMessage.prototype._writeBody = function(chunk, encoding) {
   var len, ret;
   if (this.chunkedEncoding) {
     if (typeof(chunk) === 'string') {
@@ -590,10 +846,7 @@ OutgoingMessage.prototype.write = function(chunk, encoding) {
       ret = this._send(chunk, encoding);
     } else {
       // buffer
-      len = chunk.length;
-      this._send(len.toString(16) + CRLF);
-      this._send(chunk);
-      ret = this._send(CRLF);
+      ret = this._sendBuffers([chunkHeader(chunk.length), chunk, crlfBuffer]);
     }
   } else {
     ret = this._send(chunk, encoding);
@@ -629,28 +882,64 @@ OutgoingMessage.prototype.end = function(data, encoding) {
     this._implicitHeader();
   }
 
+  if (this._zstream) {
+    // Finish the compressed body first, then end the response as usual.
+    var self = this, z = this._zstream;
+    z.on('end', function() {
+      self._zstream = null;
+      self.end();
+    });
+    z.end(data, encoding);
+    return true;
+  }
+
   var ret;
 
   var hot = this._headerSent === false &&
-            typeof(data) === 'string' &&
+            data &&
             data.length > 0 &&
             this.output.length === 0 &&
             this.connection &&
             this.connection.writable &&
             this.connection._httpMessage === this;
 
-  if (hot) {
+  // Only net.Socket can write several Buffers at once; a TLS
+  // CleartextStream takes the normal path.
+  if (hot && typeof(data) !== 'string') {
+    hot = Buffer.isBuffer(data) &&
+          this._hasBody &&
+          typeof this.connection._writeBuffers === 'function';
+  }
+
+  if (hot && typeof(data) !== 'string') {
+    // res.end(buffer): the header and the body leave with one writev()
+    // straight from their Buffers, nothing is queued or copied.
+    if (this.chunkedEncoding) {
+      var last = this._trailer ?
+                 new Buffer('\r\n0\r\n' + this._trailer + '\r\n') :
+                 lastChunkBuffer;
+      ret = this.connection._writeBuffers([this._header,
+                                           chunkHeader(data.length),
+                                           data,
+                                           last]);
+    } else {
+      ret = this.connection._writeBuffers([this._header, data]);
+    }
+    this._headerSent = true;
+
+  } else if (hot) {
     // Hot path. They're doing
     //   res.writeHead();
     //   res.end(blah);
     // HACKY.
     if (this.chunkedEncoding) {
       var l = Buffer.byteLength(data, encoding).toString(16);
-      ret = this.connection.write(this._header + l + CRLF +
-                                  data + '\r\n0\r\n' +
-                                  this._trailer + '\r\n', encoding);
+      ret = this.connection.write(this._headerAnd(l + CRLF +
+                                                  data + '\r\n0\r\n' +
+                                                  this._trailer + '\r\n',
+                                                  encoding));
     } else {
-      ret = this.connection.write(this._header + data, encoding);
+      ret = this.connection.write(this._headerAnd(data, encoding));
     }
     this._headerSent = true;
 
@@ -741,6 +1030,8 @@ OutgoingMessage.prototype._flush = function() {
 function ServerResponse(req) {
   OutgoingMessage.call(this);
 
+  this._req = req;
+
   if (req.method === 'HEAD') this._hasBody = false;
 
   if (req.httpVersionMajor < 1 || req.httpVersionMinor < 1) {
@@ -755,6 +1046,111 @@ exports.ServerResponse = ServerResponse;
 
 ServerResponse.prototype.statusCode = 200;
 
+// res.compress([options])
+// Opt in to compressing the body with gzip or deflate, whichever the
+// request's Accept-Encoding prefers. options go to zlib, plus 'types', a
+// RegExp for the Content-Types worth compressing.
+ServerResponse.prototype.compress = function(options) {
+  if (this._header) {
+    throw new Error('Can\'t compress after the header is sent.');
+  }
+  this._compressOptions = options || {};
+};
+
+
+var compressibleTypes = /^text\/|json|javascript|xml/i;
+
+
+// 'gzip', 'deflate' or null for an Accept-Encoding header value. gzip wins
+// a tie.
+function acceptedEncoding(header) {
+  if (!header) return null;
+
+  var best = null, bestQ = 0;
+  var codings = String(header).split(',');
+
+  for (var i = 0; i < codings.length; i++) {
+    var params = codings[i].split(';');
+    var coding = params[0].trim().toLowerCase();
+    var q = 1;
+
+    for (var j = 1; j < params.length; j++) {
+      var param = params[j].trim();
+      if (param.slice(0, 2) === 'q=') q = parseFloat(param.slice(2)) || 0;
+    }
+
+    if (coding === '*') coding = 'gzip';
+    if (coding !== 'gzip' && coding !== 'deflate') continue;
+
+    if (q > bestQ || (q === bestQ && q > 0 && coding === 'gzip')) {
+      best = coding;
+      bestQ = q;
+    }
+  }
+
+  return best;
+}
+
+
+// Called from writeHead() after compress(). Returns the header fields as
+// [field, value] pairs, rewritten for a compressed body if the response
+// qualifies, and sets up the compressor.
+ServerResponse.prototype._negotiateEncoding = function(statusCode, headers) {
+  var options = this._compressOptions;
+  var fields = [];
+  var contentType = null, vary = false;
+
+  if (Array.isArray(headers)) {
+    fields = headers.slice();
+  } else if (headers) {
+    for (var key in headers) fields.push([key, headers[key]]);
+  }
+
+  for (var i = 0; i < fields.length; i++) {
+    var name = String(fields[i][0]).toLowerCase();
+    if (name === 'content-encoding') return headers;
+    if (name === 'content-type') contentType = String(fields[i][1]);
+    if (name === 'vary') vary = true;
+  }
+
+  if (statusCode === 206) return headers;
+  if (contentType && !(options.types || compressibleTypes).test(contentType)) {
+    return headers;
+  }
+
+  if (!vary) fields.push(['Vary', 'Accept-Encoding']);
+
+  var coding = acceptedEncoding(this._req._getHeader('accept-encoding'));
+  if (!coding) return fields;
+
+  // The length is no longer known; the body goes out chunked.
+  fields = fields.filter(function(field) {
+    return String(field[0]).toLowerCase() !== 'content-length';
+  });
+  fields.push(['Content-Encoding', coding]);
+
+  var zlib = require('zlib');
+  var z = coding === 'gzip' ? zlib.createGzip(options)
+                            : zlib.createDeflate(options);
+  var self = this;
+
+  z.on('data', function(chunk) {
+    self._zret = self._writeBody(chunk);
+  });
+
+  z.on('drain', function() {
+    self.emit('drain');
+  });
+
+  z.on('error', function(err) {
+    self.destroy(err);
+  });
+
+  this._zstream = z;
+  return fields;
+};
+
+
 ServerResponse.prototype.writeContinue = function() {
   this._writeRaw('HTTP/1.1 100 Continue' + CRLF + CRLF, 'ascii');
   this._sent100 = true;
@@ -807,9 +1203,6 @@ ServerResponse.prototype.writeHead = function(statusCode) {
     headers = obj;
   }
 
-  var statusLine = 'HTTP/1.1 ' + statusCode.toString() + ' ' +
-                   reasonPhrase + CRLF;
-
   if (statusCode === 204 || statusCode === 304 ||
       (100 <= statusCode && statusCode <= 199)) {
     // RFC 2616, 10.2.5:
@@ -831,7 +1224,11 @@ ServerResponse.prototype.writeHead = function(statusCode) {
     this.shouldKeepAlive = false;
   }
 
-  this._storeHeader(statusLine, headers);
+  if (this._compressOptions && this._hasBody) {
+    headers = this._negotiateEncoding(statusCode, headers);
+  }
+
+  this._storeHeader(statusCode, headers, reasonPhrase);
 };
 
 
@@ -861,9 +1258,14 @@ function ClientRequest(options) {
     }
   }
 
-  this.shouldKeepAlive = false;
+  // A pooling agent keeps the connection open. GET and HEAD requests have
+  // no body, so they need neither Content-Length nor chunked encoding for
+  // the server to know where they end.
+  this.shouldKeepAlive = options.agent && options.agent.keepAlive ? true
+                                                                  : false;
   if (method === 'GET' || method === 'HEAD') {
     this.useChunkedEncodingByDefault = false;
+    this._bodyless = true;
   } else {
     this.useChunkedEncodingByDefault = true;
   }
@@ -1036,6 +1438,9 @@ function connectionListener(socket) {
     incoming.push(req);
 
     var res = new ServerResponse(req);
+    if (self.compression) {
+      res.compress(self.compression === true ? null : self.compression);
+    }
     debug('server response shouldKeepAlive: ' + shouldKeepAlive);
     res.shouldKeepAlive = shouldKeepAlive;
     DTRACE_HTTP_SERVER_REQUEST(req, socket);
@@ -1066,9 +1471,10 @@ function connectionListener(socket) {
       }
     });
 
-    if ('expect' in req.headers &&
+    var expect = req._getHeader('expect');
+    if (expect !== undefined &&
         (req.httpVersionMajor == 1 && req.httpVersionMinor == 1) &&
-        continueExpression.test(req.headers['expect'])) {
+        continueExpression.test(expect)) {
       res._expect_continue = true;
       if (self.listeners('checkContinue').length) {
         self.emit('checkContinue', req, res);
@@ -1092,13 +1498,80 @@ function Agent(options) {
 
   this.queue = [];
   this.sockets = [];
-  this.maxSockets = Agent.defaultMaxSockets;
+  this.maxSockets = options.maxSockets || Agent.defaultMaxSockets;
+
+  // Keep-alive pool. Idle connections sit in freeSockets (also counted in
+  // sockets) and are handed out most recently used first, so the warm ones
+  // get reused and the cold ones time out.
+  this.keepAlive = typeof options.keepAlive == 'boolean' ? options.keepAlive
+                                                         : Agent.defaultKeepAlive;
+  this.maxIdleTime = options.maxIdleTime || Agent.defaultMaxIdleTime;
+  this.freeSockets = [];
+
+  this.hits = 0;
+  this.misses = 0;
 }
 util.inherits(Agent, EventEmitter);
 exports.Agent = Agent;
 
 
 Agent.defaultMaxSockets = 5;
+Agent.defaultKeepAlive = false;
+Agent.defaultMaxIdleTime = 5000;
+
+// Limit on the connections of all agents together.
+Agent.maxTotalSockets = Infinity;
+Agent.totalSockets = 0;
+
+// Agents with queued requests that hit maxTotalSockets.
+var waitingAgents = [];
+
+// Idle connections of every agent, least recently used first.
+var idleSockets = [];
+
+
+// agent.getStats()
+// hits: requests served on an idle pooled connection
+// misses: requests that had to open a new connection
+// waiters: requests queued for a connection right now
+Agent.prototype.getStats = function() {
+  return { hits: this.hits,
+           misses: this.misses,
+           waiters: this.queue.length,
+           sockets: this.sockets.length,
+           freeSockets: this.freeSockets.length };
+};
+
+
+// Puts a connection whose response has completed back in the pool.
+Agent.prototype._releaseSocket = function(socket) {
+  var self = this;
+
+  if (!(socket.writable && socket.readable)) return;
+
+  this.freeSockets.push(socket);
+  idleSockets.push(socket);
+
+  socket.setTimeout(this.maxIdleTime);
+  if (!socket._agentIdleTimeout) {
+    socket._agentIdleTimeout = function() {
+      if (self.freeSockets.indexOf(socket) >= 0) socket.destroy();
+    };
+    socket.on('timeout', socket._agentIdleTimeout);
+  }
+
+  // Agents waiting on the global limit can have this one's idle slot.
+  if (waitingAgents.length) socket.destroy();
+};
+
+
+Agent.prototype._removeFreeSocket = function(socket) {
+  var i = this.freeSockets.indexOf(socket);
+  if (i >= 0) {
+    this.freeSockets.splice(i, 1);
+    idleSockets.splice(idleSockets.indexOf(socket), 1);
+  }
+};
 
 
 Agent.prototype.appendMessage = function(options) {
@@ -1122,7 +1595,18 @@ Agent.prototype.appendMessage = function(options) {
 
 Agent.prototype._removeSocket = function(socket) {
   var i = this.sockets.indexOf(socket);
-  if (i >= 0) this.sockets.splice(i, 1);
+  if (i >= 0) {
+    this.sockets.splice(i, 1);
+    Agent.totalSockets--;
+  }
+  this._removeFreeSocket(socket);
+
+  // A slot opened up under the global limit.
+  if (waitingAgents.length) {
+    var agent = waitingAgents.shift();
+    agent._waiting = false;
+    agent._cycle();
+  }
 };
 
 
@@ -1145,6 +1629,8 @@ Agent.prototype._establishNewConnection = function() {
   socket._httpConnecting = true;
 
   this.sockets.push(socket);
+  Agent.totalSockets++;
+  this.misses++;
 
   // Cycle so the request can be assigned to this new socket.
   self._cycle();
@@ -1159,7 +1645,14 @@ Agent.prototype._establishNewConnection = function() {
   socket.on('error', function(err) {
     debug('AGENT SOCKET ERROR: ' + err.message);
     var req;
-    if (socket._httpMessage) {
+    if (self.freeSockets.indexOf(socket) >= 0) {
+      // An idle pooled connection died; nobody is waiting on it.
+      parser.finish();
+      socket.destroy();
+      self._removeSocket(socket);
+      parsers.free(parser);
+      return;
+    } else if (socket._httpMessage) {
       req = socket._httpMessage;
     } else if (self.queue.length) {
       req = self.queue.shift();
@@ -1273,9 +1766,8 @@ Agent.prototype._establishNewConnection = function() {
       return true;
     }
 
-    if (req.shouldKeepAlive && res.headers.connection === 'close') {
-      req.shouldKeepAlive = false;
-    }
+    // The parser has looked at the Connection header and the HTTP version.
+    req.shouldKeepAlive = req.shouldKeepAlive && shouldKeepAlive;
 
     res.addListener('end', function() {
       debug('AGENT request complete');
@@ -1294,6 +1786,14 @@ Agent.prototype._establishNewConnection = function() {
 
       assert(!socket._httpMessage);
 
+      if (req.shouldKeepAlive && self.keepAlive) {
+        if (self.queue.length == 0) {
+          self._releaseSocket(socket);
+        } else {
+          self.hits++;
+        }
+      }
+
       self._cycle();
     });
 
@@ -1325,6 +1825,22 @@ Agent.prototype._cycle = function() {
   var first = this.queue[0];
   if (!first) return;
 
+  // Warmest idle connection first.
+  while (this.freeSockets.length) {
+    var free = this.freeSockets[this.freeSockets.length - 1];
+    this._removeFreeSocket(free);
+    if (!(free.writable && free.readable)) continue;
+    debug('Agent reusing idle socket');
+    free.setTimeout(0);
+    this.hits++;
+    this.queue.shift();
+    assert(first._queue === this.queue);
+    first._queue = null;
+    first.assignSocket(free);
+    self._cycle();
+    return;
+  }
+
   var haveConnectingSocket = false;
 
   // First try to find an available socket.
@@ -1352,13 +1868,26 @@ Agent.prototype._cycle = function() {
   // If no sockets are connecting, and we have space for another we should
   // be starting a new connection to handle this request.
   if (!haveConnectingSocket && this.sockets.length < this.maxSockets) {
-    this._establishNewConnection();
+    if (Agent.totalSockets < Agent.maxTotalSockets) {
+      this._establishNewConnection();
+    } else if (!this._waiting) {
+      this._waiting = true;
+      waitingAgents.push(this);
+      evictIdleSocket();
+    }
   }
 
   // All sockets are filled and all sockets are busy.
 };
 
 
+// Closes the coldest idle connection of any agent to make room under
+// Agent.maxTotalSockets.
+function evictIdleSocket() {
+  if (idleSockets.length) idleSockets[0].destroy();
+}
+
+
 // process-wide hash of agents.
 // keys: "host:port" string
 // values: instance of Agent
@@ -1395,7 +1924,9 @@ exports.request = function(options, cb) {
   if (options.agent === undefined) {
     options.agent = getAgent(options.host, options.port);
   } else if (options.agent === false) {
+    // Nothing else will ever use this agent, so it must not pool.
     options.agent = new Agent(options);
+    options.agent.keepAlive = false;
   }
   return exports._requestFromAgent(options, cb);
 };
@@ -1537,7 +2068,7 @@ Client.prototype._initParser = function() {
       return true;
     }
 
-    if (req.shouldKeepAlive && res.headers.connection === 'close') {
+    if (req.shouldKeepAlive && res._getHeader('connection') === 'close') {
       req.shouldKeepAlive = false;
     }
 
@@ -34,8 +34,20 @@ inherits(Agent, http.Agent);
 
 
 Agent.prototype._getConnection = function(host, port, cb) {
-  var s = tls.connect(port, host, this.options, function() {
+  var self = this;
+  var options = this.options;
+
+  // Resume the last session negotiated with this server, skipping the
+  // full handshake on every new connection.
+  if (this._session) {
+    options = {};
+    for (var key in this.options) options[key] = this.options[key];
+    options.session = this._session;
+  }
+
+  var s = tls.connect(port, host, options, function() {
     // do other checks here?
+    self._session = s.getSession();
     if (cb) cb();
   });
 
@@ -62,7 +74,9 @@ exports.request = function(options, cb) {
   if (options.agent === undefined) {
     options.agent = getAgent(options);
   } else if (options.agent === false) {
+    // Nothing else will ever use this agent, so it must not pool.
     options.agent = new Agent(options);
+    options.agent.keepAlive = false;
   }
   return http._requestFromAgent(options, cb);
 };
@@ -35,6 +35,7 @@ var bind = binding.bind;
 var connect = binding.connect;
 var listen = binding.listen;
 var accept = binding.accept;
+var acceptMany = binding.acceptMany;
 var close = binding.close;
 var shutdown = binding.shutdown;
 var read = binding.read;
@@ -46,11 +47,13 @@ var socketError = binding.socketError;
 var getsockname = binding.getsockname;
 var errnoException = binding.errnoException;
 var sendMsg = binding.sendMsg;
+var writev = binding.writev;
 var recvMsg = binding.recvMsg;
 
 var EINPROGRESS = constants.EINPROGRESS || constants.WSAEINPROGRESS;
 var ENOENT = constants.ENOENT;
 var EMFILE = constants.EMFILE;
+var ENFILE = constants.ENFILE;
 
 var END_OF_FILE = 42;
 
@@ -60,6 +63,7 @@ var ioWatchers = new FreeList('iowatcher', 100, function() {
 });
 
 exports.isIP = binding.isIP;
+exports.hasReusePort = binding.hasReusePort;
 
 exports.isIPv4 = function(input) {
   if (binding.isIP(input) === 4) {
@@ -143,6 +147,12 @@ function setImplmentationMethods(self) {
     };
   }
 
+  // Not available on every platform; _writeBuffers() falls back to one
+  // write per buffer.
+  self._writevImpl = writev ? function(buffers) {
+    return writev(self.fd, buffers);
+  } : null;
+
   self._shutdownImpl = function() {
     shutdown(self.fd, 'write');
   };
@@ -481,6 +491,69 @@ Socket.prototype._writeOut = function(data, encoding, fd, cb) {
 };
 
 
+// Writes an array of Buffers with one system call where the platform
+// allows it. Whatever the kernel does not take is queued like the tail of
+// a partial write(). Returns true if everything was flushed.
+Socket.prototype._writeBuffers = function(buffers) {
+  if (!this._writevImpl ||
+      this._connecting ||
+      (this._writeQueue && this._writeQueue.length)) {
+    var ret;
+    for (var i = 0; i < buffers.length; i++) {
+      ret = this.write(buffers[i]);
+    }
+    return ret;
+  }
+
+  if (!this.writable) {
+    throw new Error('Socket is not writable');
+  }
+
+  var bytesWritten;
+
+  try {
+    bytesWritten = this._writevImpl(buffers) || 0;
+    DTRACE_NET_SOCKET_WRITE(this, bytesWritten);
+  } catch (e) {
+    this.destroy(e);
+    return false;
+  }
+
+  debug('wrote ' + bytesWritten + ' bytes to socket with writev.');
+
+  timers.active(this);
+
+  var queued = false;
+
+  for (var i = 0; i < buffers.length; i++) {
+    var buffer = buffers[i];
+    if (bytesWritten >= buffer.length) {
+      bytesWritten -= buffer.length;
+      continue;
+    }
+
+    if (bytesWritten > 0) {
+      buffer = buffer.slice(bytesWritten, buffer.length);
+      bytesWritten = 0;
+    }
+
+    this.bufferSize += buffer.length;
+    this._writeQueue.push(buffer);
+    this._writeQueueEncoding.push(null);
+    this._writeQueueCallbacks.push(undefined);
+    queued = true;
+  }
+
+  if (queued) {
+    this._writeWatcher.start();
+    this._onBufferChange();
+    return false;
+  }
+
+  return true;
+};
+
+
 Socket.prototype._onBufferChange = function() {
   // Put DTrace hooks here.
   ;
@@ -863,36 +936,44 @@ function Server(/* [ options, ] listener */) {
 
   self.allowHalfOpen = options.allowHalfOpen || false;
 
+  // Set SO_REUSEPORT on the listening socket so that several processes can
+  // listen() on the same address. See lib/prefork.js.
+  self.reusePort = options.reusePort || false;
+
+  // Upper bound on connections accepted per readiness event.
+  self.acceptBatch = options.acceptBatch || 64;
+
   self.watcher = new IOWatcher();
   self.watcher.host = self;
   self.watcher.callback = function() {
-    // Just in case we don't have a dummy fd.
-    getDummyFD();
-
     if (self._pauseTimer) {
       // Somehow the watcher got started again. Need to wait until
       // the timer finishes.
       self.watcher.stop();
+      return;
     }
 
-    while (self.fd) {
-      try {
-        var peerInfo = accept(self.fd);
-      } catch (e) {
-        if (e.errno != EMFILE) throw e;
+    // One call drains up to acceptBatch connections; if the backlog holds
+    // more the watcher simply fires again.
+    try {
+      var peers = acceptPeers(self.fd, self.acceptBatch);
+    } catch (e) {
+      if (e.errno != EMFILE && e.errno != ENFILE) throw e;
 
-        // Gracefully reject pending clients by freeing up a file
-        // descriptor.
-        rescueEMFILE(function() {
-          self._rejectPending();
-        });
-        return;
-      }
-      if (!peerInfo) return;
+      // acceptMany() has already turned away the pending clients using its
+      // reserved descriptor. Back off until some descriptors are freed.
+      warnEMFILE();
+      self.pause(100);
+      return;
+    }
+    if (!peers) return;
+
+    for (var i = 0; i < peers.length; i++) {
+      var peerInfo = peers[i];
 
       if (self.maxConnections && self.connections >= self.maxConnections) {
-        // Close the connection we just had
-        close(peerInfo.fd);
+        // Close the connections we just had
+        for (; i < peers.length; i++) close(peers[i].fd);
         // Reject all other pending connectins.
         self._rejectPending();
         return;
@@ -919,7 +1000,6 @@ function Server(/* [ options, ] listener */) {
         s.emit('connect');
       } catch (e) {
         s.destroy(e);
-        return;
       }
     }
   };
@@ -928,6 +1008,28 @@ util.inherits(Server, events.EventEmitter);
 exports.Server = Server;
 
 
+// Takes up to max connections off the backlog in one call. acceptMany() is
+// only built on POSIX; elsewhere accept() is called in a loop.
+function acceptPeers(fd, max) {
+  if (acceptMany) return acceptMany(fd, max);
+
+  var peers = null;
+  while (!peers || peers.length < max) {
+    try {
+      var peerInfo = accept(fd);
+    } catch (e) {
+      // Hand out what we have; the error comes back on the next call.
+      if (peers) break;
+      throw e;
+    }
+    if (!peerInfo) break;
+    if (!peers) peers = [];
+    peers.push(peerInfo);
+  }
+  return peers;
+}
+
+
 exports.createServer = function() {
   return new Server(arguments[0], arguments[1]);
 };
@@ -997,7 +1099,7 @@ Server.prototype.listen = function() {
     // Don't bind(). OS will assign a port with INADDR_ANY.
     // The port can be found with server.address()
     self.type = 'tcp4';
-    self.fd = socket(self.type);
+    self.fd = socket(self.type, self.reusePort);
     self._doListen(port);
   } else if (port === false) {
     // the first argument specifies a path
@@ -1031,7 +1133,12 @@ Server.prototype.listen = function() {
         self.emit('error', err);
       } else {
         self.type = addressType == 4 ? 'tcp4' : 'tcp6';
-        self.fd = socket(self.type);
+        try {
+          self.fd = socket(self.type, self.reusePort);
+        } catch (e) {
+          self.emit('error', e);
+          return;
+        }
         self._doListen(port, ip);
       }
     });
@@ -1057,9 +1164,6 @@ Server.prototype._startWatcher = function() {
 Server.prototype._doListen = function() {
   var self = this;
 
-  // Ensure we have a dummy fd for EMFILE conditions.
-  getDummyFD();
-
   try {
     bind(self.fd, arguments[0], arguments[1]);
   } catch (err) {
@@ -1118,32 +1222,12 @@ Server.prototype.close = function() {
 };
 
 
-var dummyFD = null;
 var lastEMFILEWarning = 0;
-// Ensures to have at least on free file-descriptor free.
-// callback should only use 1 file descriptor and close it before end of call
-function rescueEMFILE(callback) {
-  // Output a warning, but only at most every 5 seconds.
+// Output a warning, but only at most every 5 seconds.
+function warnEMFILE() {
   var now = new Date();
   if (now - lastEMFILEWarning > 5000) {
     console.error('(node) Hit max file limit. Increase "ulimit - n"');
     lastEMFILEWarning = now;
   }
-
-  if (dummyFD) {
-    close(dummyFD);
-    dummyFD = null;
-    callback();
-    getDummyFD();
-  }
-}
-
-function getDummyFD() {
-  if (!dummyFD) {
-    try {
-      dummyFD = socket('tcp');
-    } catch (e) {
-      dummyFD = null;
-    }
-  }
 }
@@ -0,0 +1,567 @@
+// Pre-forking servers.
+//
+// A master process spawns a fixed number of copies of a worker script. Each
+// worker either binds its own listening socket with SO_REUSEPORT, letting
+// the kernel spread new connections between the processes, or - where the
+// platform lacks SO_REUSEPORT - receives a duplicate of one listening socket
+// created by the master.
+//
+// Master and worker talk over a UNIX socketpair that the worker gets as its
+// stdin. Messages are newline delimited JSON; a message flagged with
+// 'hasFd' carries a file descriptor (SCM_RIGHTS) alongside it.
+
+var events = require('events');
+var util = require('util');
+var net = require('net');
+var spawn = require('child_process').spawn;
+var binding = process.binding('net');
+
+var WORKER_ENV = 'NODE_PREFORK_WORKER';
+
+// A worker that dies within QUICK_DEATH ms of being spawned is probably
+// crashing on startup. Each further quick death of the same worker id
+// doubles the delay before the next respawn, up to RESPAWN_MAX.
+var QUICK_DEATH = 1000;
+var RESPAWN_MIN = 100;
+var RESPAWN_MAX = 30000;
+
+exports.isWorker = process.env[WORKER_ENV] !== undefined;
+exports.isMaster = !exports.isWorker;
+
+
+function Channel(fd) {
+  events.EventEmitter.call(this);
+  var self = this;
+
+  this._buffer = '';
+  this._queue = [];
+  this._fds = [];
+
+  this.stream = new net.Stream(fd, 'unix');
+  this.stream.setEncoding('utf8');
+
+  this.stream.on('data', function(d) {
+    var lines = (self._buffer + d).split('\n');
+    self._buffer = lines.pop();
+    for (var i = 0; i < lines.length; i++) {
+      if (lines[i].length == 0) continue;
+      try {
+        var msg = JSON.parse(lines[i]);
+      } catch (e) {
+        // Not from a well behaved peer; drop it and let the owner decide.
+        self.emit('invalid', lines[i]);
+        continue;
+      }
+      self._queue.push(msg);
+    }
+    self._flush();
+  });
+
+  // The 'fd' event is emitted on the next tick, after the 'data' event of
+  // the message it arrived with, so messages wait here for their fd.
+  this.stream.on('fd', function(fd) {
+    self._fds.push(fd);
+    self._flush();
+  });
+
+  this.stream.on('error', function(err) {
+    self.emit('error', err);
+  });
+
+  this.stream.on('close', function() {
+    self.emit('close');
+  });
+
+  this.stream.resume();
+}
+util.inherits(Channel, events.EventEmitter);
+
+
+Channel.prototype._flush = function() {
+  while (this._queue.length) {
+    var msg = this._queue[0];
+    if (msg.hasFd) {
+      if (this._fds.length == 0) return;
+      msg.fd = this._fds.shift();
+    }
+    this._queue.shift();
+    this.emit('message', msg);
+  }
+};
+
+
+Channel.prototype.send = function(msg, fd) {
+  if (!this.stream.writable) return false;
+  if (fd !== undefined) msg.hasFd = true;
+  return this.stream.write(JSON.stringify(msg) + '\n', 'utf8', fd);
+};
+
+
+Channel.prototype.close = function() {
+  this.stream.destroy();
+};
+
+
+// Master
+
+function Master(options) {
+  if (!(this instanceof Master)) return new Master(options);
+  events.EventEmitter.call(this);
+
+  if (!options || !options.exec) {
+    throw new Error('prefork: options.exec is required');
+  }
+
+  this.exec = options.exec;
+  this.args = options.args || [];
+  this.env = options.env || process.env;
+  this.size = options.workers || require('os').cpus().length || 1;
+  this.port = options.port;
+  this.host = options.host;
+  this.statsInterval = options.statsInterval || 5000;
+  this.shutdownTimeout = options.shutdownTimeout || 30000;
+
+  this.mode = options.mode || (net.hasReusePort ? 'reuseport' : 'sendfd');
+  if (this.mode != 'reuseport' && this.mode != 'sendfd') {
+    throw new Error('prefork: unknown mode ' + this.mode);
+  }
+  if (this.mode == 'reuseport' && !net.hasReusePort) {
+    throw new Error('prefork: SO_REUSEPORT is not supported on this platform');
+  }
+
+  this.workers = {};
+  this._quickDeaths = {};
+  this._respawnTimers = {};
+  this.fd = null;
+  this.type = null;
+  this.stopping = false;
+  this._listening = false;
+  this._healthTimer = null;
+}
+util.inherits(Master, events.EventEmitter);
+exports.Master = Master;
+
+
+exports.createMaster = function(options) {
+  return new Master(options);
+};
+
+
+// master.start([callback])
+// Spawns the workers. 'listening' is emitted (and callback called) once
+// every worker is accepting connections.
+Master.prototype.start = function(callback) {
+  var self = this;
+
+  if (callback) self.once('listening', callback);
+
+  if (self.mode == 'sendfd') {
+    try {
+      self._listen();
+    } catch (e) {
+      self.emit('error', e);
+      return;
+    }
+  }
+
+  for (var id = 0; id < self.size; id++) {
+    self._spawn(id);
+  }
+
+  self._healthTimer = setInterval(function() {
+    self._checkHealth();
+  }, self.statsInterval);
+};
+
+
+// Listening socket shared by every worker in 'sendfd' mode.
+Master.prototype._listen = function() {
+  var port = this.port, host = this.host;
+
+  if (typeof port == 'string' && !/^[0-9]+$/.test(port)) {
+    this.type = 'unix';
+    this.fd = binding.socket('unix');
+    binding.bind(this.fd, port);
+  } else {
+    this.type = host && binding.isIP(host) == 6 ? 'tcp6' : 'tcp4';
+    this.fd = binding.socket(this.type);
+    binding.bind(this.fd, parseInt(port, 10), host);
+  }
+
+  binding.listen(this.fd, 128);
+};
+
+
+Master.prototype._spawn = function(id) {
+  var self = this;
+
+  var pair = binding.socketpair();
+  var env = {};
+  for (var key in self.env) env[key] = self.env[key];
+  env[WORKER_ENV] = String(id);
+
+  var child = spawn(process.execPath,
+                    [self.exec].concat(self.args),
+                    { env: env, customFds: [pair[1], 1, 2] });
+  binding.close(pair[1]);
+
+  var worker = {
+    id: id,
+    pid: child.pid,
+    process: child,
+    channel: new Channel(pair[0]),
+    state: 'starting',
+    started: Date.now(),
+    lastSeen: Date.now(),
+    stats: null
+  };
+
+  worker.channel.on('message', function(msg) {
+    self._onMessage(worker, msg);
+  });
+
+  // Garbage on the channel means the worker can no longer be trusted to
+  // follow the protocol; the exit handler replaces it.
+  worker.channel.on('invalid', function(line) {
+    self.emit('unhealthy', worker);
+    worker.process.kill('SIGKILL');
+  });
+
+  // A worker that dies takes its end of the socketpair with it.
+  worker.channel.on('error', function() {});
+
+  child.on('exit', function(code, signal) {
+    self._onExit(worker, code, signal);
+  });
+
+  self.workers[child.pid] = worker;
+  self._sendListen(worker);
+  return worker;
+};
+
+
+Master.prototype._sendListen = function(worker) {
+  var msg = { cmd: 'listen',
+              id: worker.id,
+              statsInterval: this.statsInterval };
+
+  if (this.mode == 'sendfd') {
+    msg.type = this.type;
+    worker.channel.send(msg, this.fd);
+  } else {
+    msg.port = this.port;
+    msg.host = this.host;
+    worker.channel.send(msg);
+  }
+};
+
+
+Master.prototype._onMessage = function(worker, msg) {
+  worker.lastSeen = Date.now();
+
+  switch (msg.cmd) {
+    case 'listening':
+      worker.state = 'listening';
+      this.emit('worker', worker);
+      if (this._countState('listening') == this.size && !this._listening) {
+        this._listening = true;
+        this.emit('listening');
+      }
+      break;
+
+    case 'stats':
+      worker.stats = msg.stats;
+      this.emit('stats', worker, msg.stats);
+      break;
+
+    case 'error':
+      this.emit('error', new Error('worker ' + worker.pid + ': ' + msg.message));
+      break;
+  }
+};
+
+
+Master.prototype._onExit = function(worker, code, signal) {
+  worker.state = 'dead';
+  worker.channel.close();
+  delete this.workers[worker.pid];
+
+  this.emit('exit', worker, code, signal);
+
+  if (worker.replaced || this.stopping) {
+    if (worker.onExit) worker.onExit();
+    return;
+  }
+
+  // Unexpected death: keep the pool at full size, backing off while the
+  // worker keeps dying straight after it starts.
+  var id = worker.id;
+  var deaths = 0;
+  if (Date.now() - worker.started < QUICK_DEATH) {
+    deaths = (this._quickDeaths[id] || 0) + 1;
+  }
+  this._quickDeaths[id] = deaths;
+
+  if (deaths == 0) {
+    this._spawn(id);
+    return;
+  }
+
+  var self = this;
+  var delay = Math.min(RESPAWN_MIN * Math.pow(2, deaths - 1), RESPAWN_MAX);
+  this._respawnTimers[id] = setTimeout(function() {
+    delete self._respawnTimers[id];
+    if (!self.stopping) self._spawn(id);
+  }, delay);
+};
+
+
+Master.prototype._countState = function(state) {
+  var n = 0;
+  for (var pid in this.workers) {
+    if (this.workers[pid].state == state) n++;
+  }
+  return n;
+};
+
+
+// A worker which has not reported stats for three intervals is considered
+// wedged: it is killed and the exit handler starts a replacement.
+Master.prototype._checkHealth = function() {
+  var now = Date.now();
+  var limit = this.statsInterval * 3;
+
+  for (var pid in this.workers) {
+    var worker = this.workers[pid];
+    if (worker.state == 'closing') continue;
+    if (now - worker.lastSeen > limit) {
+      this.emit('unhealthy', worker);
+      worker.process.kill('SIGKILL');
+    }
+  }
+};
+
+
+// Ask a worker to stop accepting, finish its connections and exit.
+Master.prototype._retire = function(worker, callback) {
+  worker.state = 'closing';
+  worker.replaced = true;
+  worker.onExit = callback;
+
+  if (!worker.channel.send({ cmd: 'shutdown',
+                             timeout: this.shutdownTimeout })) {
+    worker.process.kill();
+    return;
+  }
+
+  // Last resort if the worker ignores the request.
+  var timer = setTimeout(function() {
+    worker.process.kill('SIGKILL');
+  }, this.shutdownTimeout + 1000);
+
+  worker.process.on('exit', function() {
+    clearTimeout(timer);
+  });
+};
+
+
+// master.restart([callback])
+// Replaces the workers one at a time. The replacement is listening before
+// the old worker is told to shut down, so capacity never drops by more than
+// one process and no connection is refused. If a replacement exits before
+// it is listening the restart stops there, leaving the remaining old
+// workers serving, and callback gets an error.
+Master.prototype.restart = function(callback) {
+  var self = this;
+  var old = [];
+  for (var pid in self.workers) old.push(self.workers[pid]);
+
+  function next() {
+    var worker = old.shift();
+    if (!worker) {
+      self.emit('restart');
+      if (callback) callback();
+      return;
+    }
+    if (worker.state == 'dead') return next();
+
+    var fresh = self._spawn(worker.id);
+
+    function onWorker(w) {
+      if (w !== fresh) return;
+      self.removeListener('worker', onWorker);
+      self.removeListener('exit', onExit);
+      self._retire(worker, next);
+    }
+
+    // Runs inside _onExit() before it looks at `replaced`, so the old
+    // worker is not joined by a respawn of the failed one.
+    function onExit(w, code, signal) {
+      if (w !== fresh) return;
+      self.removeListener('worker', onWorker);
+      self.removeListener('exit', onExit);
+      fresh.replaced = true;
+
+      var err = new Error('prefork: worker ' + fresh.pid +
+                          ' exited before listening (' +
+                          (signal || 'code ' + code) + ')');
+      if (callback) {
+        callback(err);
+      } else {
+        self.emit('error', err);
+      }
+    }
+
+    self.on('worker', onWorker);
+    self.on('exit', onExit);
+  }
+
+  next();
+};
+
+
+// master.stop([callback])
+// Gracefully shuts every worker down and closes the shared socket.
+Master.prototype.stop = function(callback) {
+  var self = this;
+  var pending = 0;
+
+  self.stopping = true;
+  if (self._healthTimer) {
+    clearInterval(self._healthTimer);
+    self._healthTimer = null;
+  }
+  for (var id in self._respawnTimers) {
+    clearTimeout(self._respawnTimers[id]);
+  }
+  self._respawnTimers = {};
+
+  function done() {
+    if (--pending > 0) return;
+    if (self.fd !== null) {
+      binding.close(self.fd);
+      self.fd = null;
+    }
+    self.emit('close');
+    if (callback) callback();
+  }
+
+  for (var pid in self.workers) {
+    pending++;
+    self._retire(self.workers[pid], done);
+  }
+
+  if (pending == 0) {
+    pending = 1;
+    done();
+  }
+};
+
+
+// master.stats()
+// Latest report of every worker, keyed by pid.
+Master.prototype.stats = function() {
+  var result = {};
+  for (var pid in this.workers) {
+    var worker = this.workers[pid];
+    result[pid] = { id: worker.id,
+                    state: worker.state,
+                    started: worker.started,
+                    lastSeen: worker.lastSeen,
+                    stats: worker.stats };
+  }
+  return result;
+};
+
+
+// Worker
+
+var channel = null;
+var counters = {};
+
+
+// prefork.count(name, [n])
+// Bumps a custom counter reported to the master with the worker stats.
+exports.count = function(name, n) {
+  counters[name] = (counters[name] || 0) + (n === undefined ? 1 : n);
+};
+
+
+// prefork.serve(server)
+// Called by the worker script instead of server.listen(). The master
+// decides how the server listens.
+exports.serve = function(server) {
+  if (!exports.isWorker) {
+    throw new Error('prefork.serve() must be called from a worker process');
+  }
+  if (channel) throw new Error('prefork.serve() already called');
+
+  var statsTimer = null;
+  var started = Date.now();
+  channel = new Channel(0);
+
+  function report() {
+    channel.send({ cmd: 'stats',
+                   stats: { connections: server.connections,
+                            memory: process.memoryUsage(),
+                            uptime: Date.now() - started,
+                            counters: counters } });
+  }
+
+  server.on('listening', function() {
+    channel.send({ cmd: 'listening' });
+  });
+
+  server.on('error', function(err) {
+    channel.send({ cmd: 'error', message: err.message });
+  });
+
+  channel.on('message', function(msg) {
+    switch (msg.cmd) {
+      case 'listen':
+        exports.id = msg.id;
+        statsTimer = setInterval(report, msg.statsInterval);
+        if (msg.hasFd) {
+          server.listenFD(msg.fd, msg.type);
+        } else {
+          server.reusePort = true;
+          if (msg.host) {
+            server.listen(msg.port, msg.host);
+          } else {
+            server.listen(msg.port);
+          }
+        }
+        break;
+
+      case 'shutdown':
+        clearInterval(statsTimer);
+        shutdown(server, msg.timeout);
+        break;
+    }
+  });
+
+  // The master went away; nobody is left to restart us.
+  channel.on('close', function() {
+    clearInterval(statsTimer);
+    shutdown(server, 0);
+  });
+};
+
+
+var shuttingDown = false;
+
+function shutdown(server, timeout) {
+  if (shuttingDown) return;
+  shuttingDown = true;
+
+  if (server.fd) server.close();
+  channel.close();
+
+  var deadline = Date.now() + (timeout || 0);
+  (function check() {
+    if (server.connections == 0 || Date.now() >= deadline) {
+      process.exit(0);
+    }
+    setTimeout(check, 100);
+  })();
+}
@@ -1,84 +1,23 @@
 // Query String Utilities
 
 var QueryString = exports;
-var urlDecode = process.binding('http_parser').urlDecode;
-
-
-function charCode(c) {
-  return c.charCodeAt(0);
-}
+var binding = process.binding('url');
 
 
 // a safe fast alternative to decodeURIComponent
-QueryString.unescapeBuffer = function(s, decodeSpaces) {
-  var out = new Buffer(s.length);
-  var state = 'CHAR'; // states: CHAR, HEX0, HEX1
-  var n, m, hexchar;
-
-  for (var inIndex = 0, outIndex = 0; inIndex <= s.length; inIndex++) {
-    var c = s.charCodeAt(inIndex);
-    switch (state) {
-      case 'CHAR':
-        switch (c) {
-          case charCode('%'):
-            n = 0;
-            m = 0;
-            state = 'HEX0';
-            break;
-          case charCode('+'):
-            if (decodeSpaces) c = charCode(' ');
-            // pass thru
-          default:
-            out[outIndex++] = c;
-            break;
-        }
-        break;
-
-      case 'HEX0':
-        state = 'HEX1';
-        hexchar = c;
-        if (charCode('0') <= c && c <= charCode('9')) {
-          n = c - charCode('0');
-        } else if (charCode('a') <= c && c <= charCode('f')) {
-          n = c - charCode('a') + 10;
-        } else if (charCode('A') <= c && c <= charCode('F')) {
-          n = c - charCode('A') + 10;
-        } else {
-          out[outIndex++] = charCode('%');
-          out[outIndex++] = c;
-          state = 'CHAR';
-          break;
-        }
-        break;
-
-      case 'HEX1':
-        state = 'CHAR';
-        if (charCode('0') <= c && c <= charCode('9')) {
-          m = c - charCode('0');
-        } else if (charCode('a') <= c && c <= charCode('f')) {
-          m = c - charCode('a') + 10;
-        } else if (charCode('A') <= c && c <= charCode('F')) {
-          m = c - charCode('A') + 10;
-        } else {
-          out[outIndex++] = charCode('%');
-          out[outIndex++] = hexchar;
-          out[outIndex++] = c;
-          break;
-        }
-        out[outIndex++] = 16 * n + m;
-        break;
-    }
-  }
-
-  // TODO support returning arbitrary buffers.
-
-  return out.slice(0, outIndex - 1);
-};
+// Accepts a string or a Buffer. Strings are taken as UTF-8.
+function unescapeBuffer(s, decodeSpaces) {
+  if (!Buffer.isBuffer(s)) s = String(s);
+  var out = new Buffer(Buffer.isBuffer(s) ? s.length : Buffer.byteLength(s));
+  return out.slice(0, binding.unescapeBuffer(s, decodeSpaces, out));
+}
+QueryString.unescapeBuffer = unescapeBuffer;
 
 
-QueryString.unescape = function(s, decodeSpaces) {
+function unescape(s, decodeSpaces) {
   return QueryString.unescapeBuffer(s, decodeSpaces).toString();
-};
+}
+QueryString.unescape = unescape;
 
 
 QueryString.escape = function(str) {
@@ -134,12 +73,27 @@ QueryString.stringify = QueryString.encode = function(obj, sep, eq, name) {
 QueryString.parse = QueryString.decode = function(qs, sep, eq) {
   sep = sep || '&';
   eq = eq || '=';
-  var obj = {};
 
-  if (typeof qs !== 'string' || qs.length === 0) {
-    return obj;
+  if (!Buffer.isBuffer(qs) && (typeof qs !== 'string' || qs.length === 0)) {
+    return {};
   }
 
+  // A replaced unescape() has to see every key and value, which the
+  // native parser would bypass.
+  if (QueryString.unescape !== unescape ||
+      QueryString.unescapeBuffer !== unescapeBuffer) {
+    return parseWithUnescape(String(qs), sep, eq);
+  }
+
+  // Splitting, decoding and collecting duplicate keys into arrays all
+  // happen in one native pass.
+  return binding.parseQueryString(qs, String(sep), String(eq));
+};
+
+
+function parseWithUnescape(qs, sep, eq) {
+  var obj = {};
+
   qs.split(sep).forEach(function(kvp) {
     var x = kvp.split(eq);
     var k = QueryString.unescape(x[0], true);
@@ -155,4 +109,4 @@ QueryString.parse = QueryString.decode = function(qs, sep, eq) {
   });
 
   return obj;
-};
+}
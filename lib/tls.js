@@ -14,6 +14,9 @@ if (process.env.NODE_DEBUG && /tls/.test(process.env.NODE_DEBUG)) {
 }
 
 
+var netBinding = process.binding('net');
+var EINPROGRESS = process.binding('constants').EINPROGRESS;
+
 var Connection = null;
 try {
   Connection = process.binding('crypto').Connection;
@@ -122,9 +125,9 @@ function parseCertString(s) {
 }
 
 
-CryptoStream.prototype.getPeerCertificate = function() {
-  if (this.pair._ssl) {
-    var c = this.pair._ssl.getPeerCertificate();
+function getPeerCertificate(ssl) {
+  if (ssl) {
+    var c = ssl.getPeerCertificate();
 
     if (c) {
       if (c.issuer) c.issuer = parseCertString(c.issuer);
@@ -134,6 +137,11 @@ CryptoStream.prototype.getPeerCertificate = function() {
   }
 
   return null;
+}
+
+
+CryptoStream.prototype.getPeerCertificate = function() {
+  return getPeerCertificate(this.pair._ssl);
 };
 
 
@@ -146,6 +154,26 @@ CryptoStream.prototype.getCipher = function(err) {
 };
 
 
+// Opaque Buffer which can be passed as the 'session' option of a later
+// tls.connect() to the same server to resume this session.
+CryptoStream.prototype.getSession = function() {
+  if (this.pair._ssl) {
+    return this.pair._ssl.getSession();
+  } else {
+    return null;
+  }
+};
+
+
+CryptoStream.prototype.isSessionReused = function() {
+  if (this.pair._ssl) {
+    return this.pair._ssl.isSessionReused();
+  } else {
+    return false;
+  }
+};
+
+
 CryptoStream.prototype.end = function(d) {
   if (!this.writable) {
     throw new Error('CryptoStream is not writable');
@@ -420,6 +448,8 @@ function SecurePair(credentials, isServer, requestCert, rejectUnauthorized) {
 
   this._secureEstablished = false;
   this._isServer = isServer ? true : false;
+  this._asyncHandshake = false;
+  this._handshaking = false;
   this._encWriteState = true;
   this._clearWriteState = true;
   this._done = false;
@@ -509,6 +539,9 @@ SecurePair.prototype._cycle = function() {
     return;
   }
 
+  // The thread pool owns the SSL object until the handshake step is done.
+  if (this._handshaking) return;
+
   // Make this function reentrant.
   if (this._cycleLock) return;
   this._cycleLock = true;
@@ -516,6 +549,15 @@ SecurePair.prototype._cycle = function() {
 
   var established = this._secureEstablished;
 
+  if (this._asyncHandshake && !established) {
+    var fed = this.encrypted._pending.length > 0;
+    this.encrypted._pull();
+    if (fed && this._ssl && this._handshake()) {
+      this._cycleLock = false;
+      return;
+    }
+  }
+
   this.encrypted._pull();
   this.cleartext._pull();
   this.cleartext._push();
@@ -535,6 +577,30 @@ SecurePair.prototype._cycle = function() {
 };
 
 
+// Feeds what the peer sent so far to OpenSSL on the thread pool. The next
+// step starts when more handshake data arrives. Returns false if there was
+// no handshake left to do.
+SecurePair.prototype._handshake = function() {
+  var self = this;
+
+  this._handshaking = this._ssl.handshake(function() {
+    self._handshaking = false;
+    if (self._done) return;
+
+    if (self._ssl.error) {
+      self._error();
+      return;
+    }
+
+    self.encrypted._push();
+    self._maybeInitFinished();
+    self._cycle();
+  });
+
+  return this._handshaking;
+};
+
+
 SecurePair.prototype._maybeInitFinished = function() {
   if (this._ssl && !this._secureEstablished && this._ssl.isInitFinished()) {
     this._secureEstablished = true;
@@ -589,6 +655,158 @@ SecurePair.prototype._error = function() {
   }
 };
 
+
+// Native mode
+//
+// With { nativeTLS: true } the Connection is bound to the socket fd and
+// runs SSL_read/SSL_write from inside the net.Socket read and write paths
+// (see Connection::ReadFd in src/node_crypto.cc). The net.Socket itself is
+// the cleartext stream; there is no SecurePair and no CryptoStream pump.
+//
+// While the handshake runs the socket stays in the connecting state, so
+// net.Socket queues anything written to it until the handshake is done.
+//
+// onerror(e), if given, takes the errors raised before the handshake
+// completes, when the socket has not been handed to the user yet.
+// Otherwise they are emitted on the socket like any other socket error.
+function startNative(socket, ssl, onsecure, onerror) {
+  var secure = false;
+  var readWantsWrite = false;
+  var paused = false;
+  var drainScheduled = false;
+
+  function established() {
+    if (secure || !ssl.isInitFinished()) return;
+    secure = true;
+    socket._connecting = false;
+    if (onerror) socket.removeListener('error', onerror);
+    onsecure();
+    // Flush whatever was written during the handshake.
+    socket._onWritable();
+  }
+
+  function waitFor() {
+    if (ssl.wantWrite) {
+      socket._writeWatcher.start();
+    } else {
+      socket._writeWatcher.stop();
+    }
+  }
+
+  function handshake() {
+    try {
+      if (ssl.handshakeFd() === null) return waitFor();
+    } catch (e) {
+      socket.destroy(e);
+      return;
+    }
+    socket._writeWatcher.stop();
+    established();
+  }
+
+  ssl.setFd(socket.fd);
+  socket.ssl = ssl;
+  socket._connecting = true;
+  if (onerror) socket.on('error', onerror);
+
+  // The write watcher calls _onConnect() while the socket is connecting.
+  socket._onConnect = handshake;
+
+  socket._readImpl = function(buf, off, len) {
+    var bytesRead = ssl.readFd(buf, off, len);
+    if (!secure) {
+      if (bytesRead === null) waitFor();
+      established();
+    } else if (bytesRead === null && ssl.wantWrite) {
+      // A renegotiation: SSL_read() has to send something first.
+      readWantsWrite = true;
+      socket._writeWatcher.start();
+    } else if (bytesRead > 0) {
+      drainPending();
+    }
+    return bytesRead;
+  };
+
+  // Decrypted data that did not fit into the read buffer stays inside
+  // OpenSSL, where the read watcher cannot see it. Read it on the next tick
+  // instead of waiting for the peer to send more.
+  function drainPending() {
+    if (drainScheduled || paused || !ssl || ssl.clearPending() == 0) return;
+    drainScheduled = true;
+    process.nextTick(function() {
+      drainScheduled = false;
+      if (!paused && ssl && socket.readable) socket._onReadable();
+    });
+  }
+
+  socket.pause = function() {
+    paused = true;
+    net.Socket.prototype.pause.call(this);
+  };
+
+  socket.resume = function() {
+    paused = false;
+    net.Socket.prototype.resume.call(this);
+    if (secure) drainPending();
+  };
+
+  // Retries a read that was waiting for the socket to become writable
+  // before flushing the write queue as usual.
+  socket._onWritable = function() {
+    if (readWantsWrite) {
+      readWantsWrite = false;
+      this._onReadable();
+      if (readWantsWrite || !ssl) return;
+      if (!this._writeQueue || !this._writeQueue.length) {
+        this._writeWatcher.stop();
+        return;
+      }
+    }
+    net.Socket.prototype._onWritable.call(this);
+  };
+
+  socket._writeImpl = function(buf, off, len) {
+    return ssl.writeFd(buf, off, len);
+  };
+
+  // Everything written has to go through SSL_write().
+  socket._writevImpl = null;
+
+  socket._shutdown = function() {
+    // close_notify goes out before the FIN.
+    if (secure && ssl) {
+      ssl.shutdown();
+      ssl.error = null;
+    }
+    net.Socket.prototype._shutdown.call(this);
+  };
+
+  socket.on('close', function() {
+    ssl.error = null;
+    ssl.close();
+    ssl = null;
+  });
+
+  socket.getPeerCertificate = function() {
+    return getPeerCertificate(ssl);
+  };
+
+  socket.getCipher = function() {
+    return ssl ? ssl.getCurrentCipher() : null;
+  };
+
+  socket.getSession = function() {
+    return ssl ? ssl.getSession() : null;
+  };
+
+  socket.isSessionReused = function() {
+    return ssl ? ssl.isSessionReused() : false;
+  };
+
+  handshake();
+}
+
+
 // TODO: support anonymous (nocert) and PSK
 
 
@@ -680,18 +898,13 @@ function Server(/* [options], listener */) {
 
   // constructor call
   net.Server.call(this, function(socket) {
-    var creds = crypto.createCredentials({
-      key: self.key,
-      cert: self.cert,
-      ca: self.ca,
-      crl: self.crl
-    });
-    //creds.context.setCiphers('RC4-SHA:AES128-SHA:AES256-SHA');
+    if (self.nativeTLS) return self._nativeConnection(socket);
 
-    var pair = new SecurePair(creds,
+    var pair = new SecurePair(self._getCredentials(),
                               true,
                               self.requestCert,
                               self.rejectUnauthorized);
+    pair._asyncHandshake = self.asyncHandshake;
 
     var cleartext = pipe(pair, socket);
     cleartext._controlReleased = false;
@@ -737,6 +950,68 @@ exports.createServer = function(options, listener) {
 };
 
 
+// One SSL_CTX serves every connection, so that OpenSSL's session cache
+// actually gets hits. Rebuilt after setOptions().
+Server.prototype._getCredentials = function() {
+  if (this._credentials) return this._credentials;
+
+  var creds = crypto.createCredentials({
+    key: this.key,
+    cert: this.cert,
+    ca: this.ca,
+    crl: this.crl
+  });
+  //creds.context.setCiphers('RC4-SHA:AES128-SHA:AES256-SHA');
+
+  var context = creds.context;
+
+  // Sessions are only resumed by servers with the same id context. The
+  // default matches between workers started with the same command line.
+  context.setSessionIdContext(this.sessionIdContext ||
+      crypto.createHash('md5').update(process.argv.join(' ')).digest('hex'));
+
+  if (this.sessionTimeout) context.setSessionTimeout(this.sessionTimeout);
+  if (this.sessionCache) {
+    context.setSessionCache(this.sessionCache, this.sessionCacheSize);
+  }
+  if (this.ticketKeys) context.setTicketKeys(this.ticketKeys);
+
+  this._credentials = creds;
+  return creds;
+};
+
+
+Server.prototype._nativeConnection = function(socket) {
+  var self = this;
+
+  var ssl = new Connection(self._getCredentials().context,
+                           true,
+                           self.requestCert,
+                           self.rejectUnauthorized);
+
+  socket.authorized = false;
+
+  startNative(socket, ssl, function() {
+    if (self.requestCert) {
+      var verifyError = ssl.verifyError();
+      if (verifyError) {
+        socket.authorizationError = verifyError;
+        if (self.rejectUnauthorized) {
+          socket.destroy();
+          return;
+        }
+      } else {
+        socket.authorized = true;
+      }
+    }
+    self.emit('secureConnection', socket);
+  }, function(e) {
+    debug('native handshake failed: ' + e.message);
+    self.emit('clientError', e);
+  });
+};
+
+
 Server.prototype.setOptions = function(options) {
   if (typeof options.requestCert == 'boolean') {
     this.requestCert = options.requestCert;
@@ -750,10 +1025,24 @@ Server.prototype.setOptions = function(options) {
     this.rejectUnauthorized = false;
   }
 
+  this.nativeTLS = options.nativeTLS ? true : false;
+  this.asyncHandshake = options.asyncHandshake ? true : false;
+
   if (options.key) this.key = options.key;
   if (options.cert) this.cert = options.cert;
   if (options.ca) this.ca = options.ca;
   if (options.crl) this.crl = options.crl;
+  if (options.sessionIdContext) {
+    this.sessionIdContext = options.sessionIdContext;
+  }
+  if (options.sessionTimeout) this.sessionTimeout = options.sessionTimeout;
+  if (options.sessionCache) this.sessionCache = options.sessionCache;
+  if (options.sessionCacheSize) {
+    this.sessionCacheSize = options.sessionCacheSize;
+  }
+  if (options.ticketKeys) this.ticketKeys = options.ticketKeys;
+
+  this._credentials = null;
 };
 
 
@@ -797,7 +1086,12 @@ exports.connect = function(port /* host, options, cb */) {
   var sslcontext = crypto.createCredentials(options);
   //sslcontext.context.setCiphers('RC4-SHA:AES128-SHA:AES256-SHA');
 
+  if (options.nativeTLS) {
+    return connectNative(socket, sslcontext, port, host, options.session, cb);
+  }
+
   var pair = new SecurePair(sslcontext, false);
+  if (options.session) pair._ssl.setSession(options.session);
 
   var cleartext = pipe(pair, socket);
 
@@ -821,6 +1115,42 @@ exports.connect = function(port /* host, options, cb */) {
 };
 
 
+function connectNative(socket, sslcontext, port, host, session, cb) {
+  var ssl = new Connection(sslcontext.context, false, true, false);
+  if (session) ssl.setSession(session);
+
+  socket.authorized = false;
+
+  // Replaces net.Socket's own TCP connect handling; startNative() takes
+  // _onConnect over for the TLS handshake.
+  socket._onConnect = function() {
+    var errno = netBinding.socketError(socket.fd);
+    if (errno == 0) {
+      socket.readable = socket.writable = true;
+      socket.resume();
+      startNative(socket, ssl, function() {
+        var verifyError = ssl.verifyError();
+
+        if (verifyError) {
+          socket.authorized = false;
+          socket.authorizationError = verifyError;
+        } else {
+          socket.authorized = true;
+        }
+
+        socket.emit('secureConnect');
+        if (cb) cb();
+      });
+    } else if (errno != EINPROGRESS) {
+      socket.destroy(netBinding.errnoException(errno, 'connect'));
+    }
+  };
+
+  socket.connect(port, host);
+  return socket;
+}
+
+
 function pipe(pair, socket) {
   pair.encrypted.pipe(socket);
   socket.pipe(pair.encrypted);
@@ -0,0 +1,320 @@
+// Streaming compression on top of the zlib binding (src/node_zlib.cc).
+//
+// Every stream owns one native z_stream which is reused for the whole
+// stream. Input Buffers are fed to it in order and the output is emitted
+// as 'data' in slices of chunkSize sized Buffers.
+
+var binding = process.binding('zlib');
+var util = require('util');
+var Stream = require('stream').Stream;
+
+Object.keys(binding).forEach(function(key) {
+  if (/^Z_/.test(key)) exports[key] = binding[key];
+});
+exports.ZLIB_VERSION = binding.ZLIB_VERSION;
+
+var kDefaultChunkSize = 16 * 1024;
+var kEmpty = new Buffer(0);
+
+
+function Zlib(mode, options) {
+  Stream.call(this);
+
+  options = options || {};
+
+  this._chunkSize = options.chunkSize || kDefaultChunkSize;
+
+  // Input chunks at least this large are compressed on the thread pool
+  // rather than on the main thread. 0 means never.
+  this._threadPoolThreshold = options.threadPoolThreshold || 0;
+
+  this._handle = new binding.Zlib(mode);
+  this._handle.init(options.level === undefined ?
+                        binding.Z_DEFAULT_COMPRESSION : options.level,
+                    options.windowBits || 15,
+                    options.memLevel || 8,
+                    options.strategy || binding.Z_DEFAULT_STRATEGY);
+
+  this._buffer = new Buffer(this._chunkSize);
+  this._offset = 0;
+  this._queue = [];
+  this._processing = false;
+  this._paused = false;
+  this._pausedData = [];
+  this._needDrain = false;
+  this._finished = false;
+  this._closed = false;
+
+  this.readable = true;
+  this.writable = true;
+}
+util.inherits(Zlib, Stream);
+
+
+// zlib.write(chunk, [encoding])
+Zlib.prototype.write = function(chunk, encoding) {
+  if (!this.writable) {
+    throw new Error('Cannot write after end');
+  }
+
+  if (!Buffer.isBuffer(chunk)) chunk = new Buffer(chunk, encoding);
+
+  this._queue.push([chunk, binding.Z_NO_FLUSH]);
+  this._next();
+
+  if (this._processing || this._paused) {
+    this._needDrain = true;
+    return false;
+  }
+  return true;
+};
+
+
+// zlib.flush()
+// Emits everything written so far, at some cost in compression.
+Zlib.prototype.flush = function() {
+  this._queue.push([kEmpty, binding.Z_SYNC_FLUSH]);
+  this._next();
+};
+
+
+// zlib.end([chunk], [encoding])
+Zlib.prototype.end = function(chunk, encoding) {
+  if (chunk) this.write(chunk, encoding);
+  this.writable = false;
+  this._queue.push([kEmpty, binding.Z_FINISH]);
+  this._next();
+};
+
+
+// zlib.reset()
+// Starts over with a fresh stream, as if newly created.
+Zlib.prototype.reset = function() {
+  this._handle.reset();
+};
+
+
+Zlib.prototype.destroy = function() {
+  this._close();
+};
+
+
+Zlib.prototype.pause = function() {
+  this._paused = true;
+};
+
+
+Zlib.prototype.resume = function() {
+  this._paused = false;
+
+  while (!this._paused && this._pausedData.length) {
+    this.emit('data', this._pausedData.shift());
+  }
+
+  this._maybeEnd();
+  this._maybeDrain();
+};
+
+
+Zlib.prototype._next = function() {
+  if (this._closed) return;
+
+  while (!this._processing && this._queue.length) {
+    var item = this._queue.shift();
+
+    if (this._threadPoolThreshold > 0 &&
+        item[0].length >= this._threadPoolThreshold) {
+      this._processing = true;
+      this._transformAsync(item[0], item[1]);
+      return;
+    }
+
+    if (!this._transform(item[0], item[1])) return;
+    if (item[1] === binding.Z_FINISH) this._finish();
+  }
+
+  this._maybeDrain();
+};
+
+
+// Runs chunk through the stream on the main thread. The output buffer
+// filling up completely means there may be more to come.
+Zlib.prototype._transform = function(chunk, flush) {
+  var inOffset = 0, availIn = chunk.length, availOut;
+
+  do {
+    var availOutBefore = this._chunkSize - this._offset;
+    try {
+      var r = this._handle.write(flush, chunk, inOffset, availIn,
+                                 this._buffer, this._offset, availOutBefore);
+    } catch (e) {
+      this._error(e);
+      return false;
+    }
+
+    inOffset += availIn - r[0];
+    availIn = r[0];
+    availOut = r[1];
+    this._output(availOutBefore - availOut, availOut);
+    if (this._closed) return false;
+  } while (availOut === 0);
+
+  return true;
+};
+
+
+// Same as _transform(), on the thread pool.
+Zlib.prototype._transformAsync = function(chunk, flush) {
+  var self = this;
+  var inOffset = 0, availIn = chunk.length;
+
+  (function run() {
+    var availOutBefore = self._chunkSize - self._offset;
+
+    self._handle.write(flush, chunk, inOffset, availIn,
+                       self._buffer, self._offset, availOutBefore,
+                       function(err, availInAfter, availOut) {
+      self._processing = false;
+
+      if (self._closed) {
+        self._handle.close();
+        return;
+      }
+
+      if (err) {
+        self._error(err);
+        return;
+      }
+
+      inOffset += availIn - availInAfter;
+      availIn = availInAfter;
+      self._output(availOutBefore - availOut, availOut);
+      if (self._closed) return;
+
+      if (availOut === 0) {
+        self._processing = true;
+        return run();
+      }
+
+      if (flush === binding.Z_FINISH) self._finish();
+      self._next();
+    });
+  })();
+};
+
+
+Zlib.prototype._output = function(have, availOut) {
+  if (have > 0) {
+    var out = this._buffer.slice(this._offset, this._offset + have);
+    this._offset += have;
+
+    if (this._paused) {
+      this._pausedData.push(out);
+    } else {
+      this.emit('data', out);
+    }
+  }
+
+  // Slices already handed out keep the old buffer alive.
+  if (availOut === 0 || this._offset >= this._chunkSize) {
+    this._buffer = new Buffer(this._chunkSize);
+    this._offset = 0;
+  }
+};
+
+
+Zlib.prototype._finish = function() {
+  this._finished = true;
+  this._maybeEnd();
+};
+
+
+Zlib.prototype._maybeEnd = function() {
+  if (!this._finished || this._paused || this._pausedData.length) return;
+  this._finished = false;
+  this._close();
+  this.emit('end');
+  this.emit('close');
+};
+
+
+Zlib.prototype._maybeDrain = function() {
+  if (this._needDrain && !this._processing && !this._paused) {
+    this._needDrain = false;
+    this.emit('drain');
+  }
+};
+
+
+Zlib.prototype._error = function(err) {
+  this._close();
+  this.emit('error', err);
+};
+
+
+Zlib.prototype._close = function() {
+  this.readable = this.writable = false;
+  this._queue = [];
+  if (this._closed) return;
+  this._closed = true;
+  // A thread pool request still holds the stream; it is closed once the
+  // request comes back.
+  if (!this._processing) this._handle.close();
+};
+
+
+function define(name, mode) {
+  var ctor = exports[name] = function(options) {
+    if (!(this instanceof ctor)) return new ctor(options);
+    Zlib.call(this, mode, options);
+  };
+  util.inherits(ctor, Zlib);
+
+  exports['create' + name] = function(options) {
+    return new ctor(options);
+  };
+
+  // zlib.gzip(buffer, [options], callback) and friends
+  var fn = name.charAt(0).toLowerCase() + name.slice(1);
+  exports[fn] = function(buffer, options, callback) {
+    if (typeof options === 'function') {
+      callback = options;
+      options = {};
+    }
+    zlibBuffer(new ctor(options), buffer, callback);
+  };
+}
+
+define('Deflate', binding.DEFLATE);
+define('Inflate', binding.INFLATE);
+define('Gzip', binding.GZIP);
+define('Gunzip', binding.GUNZIP);
+define('DeflateRaw', binding.DEFLATERAW);
+define('InflateRaw', binding.INFLATERAW);
+define('Unzip', binding.UNZIP);
+
+
+function zlibBuffer(engine, buffer, callback) {
+  var buffers = [];
+  var length = 0;
+
+  engine.on('data', function(chunk) {
+    buffers.push(chunk);
+    length += chunk.length;
+  });
+
+  engine.on('error', function(err) {
+    callback(err);
+  });
+
+  engine.on('end', function() {
+    var result = new Buffer(length);
+    for (var i = 0, offset = 0; i < buffers.length; i++) {
+      buffers[i].copy(result, offset, 0);
+      offset += buffers[i].length;
+    }
+    callback(null, result);
+  });
+
+  engine.end(buffer);
+}
@@ -30,6 +30,7 @@
 
 #include <platform.h>
 #include <node_buffer.h>
+#include <node_buffer_codec.h>
 #include <node_io_watcher.h>
 #include <node_net.h>
 #include <node_events.h>
@@ -1084,6 +1085,8 @@ enum encoding ParseEncoding(Handle<Value> encoding_v, enum encoding _default) {
     return UCS2;
   } else if (strcasecmp(*encoding, "binary") == 0) {
     return BINARY;
+  } else if (strcasecmp(*encoding, "hex") == 0) {
+    return HEX;
   } else if (strcasecmp(*encoding, "raw") == 0) {
     fprintf(stderr, "'raw' (array of integers) has been removed. "
                     "Use 'binary'.\n");
@@ -1114,11 +1117,36 @@ Local<Value> Encode(const void *buf, size_t len, enum encoding encoding) {
     return scope.Close(chunk);
   }
 
+  if (encoding == HEX) {
+    char *hex = new char[len * 2];
+    Codec::HexEncode(static_cast<const char*>(buf), len, hex);
+    Local<String> chunk = String::New(hex, len * 2);
+    delete [] hex;
+    return scope.Close(chunk);
+  }
+
   // utf8 or ascii encoding
   Local<String> chunk = String::New((const char*)buf, len);
   return scope.Close(chunk);
 }
 
+static inline bool IsHexDigit(uint16_t c) {
+  return (c >= '0' && c <= '9') ||
+         (c >= 'a' && c <= 'f') ||
+         (c >= 'A' && c <= 'F');
+}
+
+// Bytes in a hex string, -1 if it has a character that is not a hex digit.
+// A trailing odd digit is ignored, as Buffer#write() does.
+static ssize_t HexDecodedLength(Local<String> str) {
+  String::Value hex(str);
+  size_t len = hex.length() & ~1;
+  for (size_t i = 0; i < len; i++) {
+    if (!IsHexDigit((*hex)[i])) return -1;
+  }
+  return len / 2;
+}
+
 // Returns -1 if the handle was not valid for decoding
 ssize_t DecodeBytes(v8::Handle<v8::Value> val, enum encoding encoding) {
   HandleScope scope;
@@ -1134,6 +1162,7 @@ ssize_t DecodeBytes(v8::Handle<v8::Value> val, enum encoding encoding) {
 
   if (encoding == UTF8) return str->Utf8Length();
   else if (encoding == UCS2) return str->Length() * 2;
+  else if (encoding == HEX) return HexDecodedLength(str);
 
   return str->Length();
 }
@@ -1174,6 +1203,16 @@ ssize_t DecodeWrite(char *buf,
     return buflen;
   }
 
+  if (encoding == HEX) {
+    // Callers have checked the digits with DecodeBytes().
+    size_t hexlen = MIN(static_cast<size_t>(str->Length()), buflen * 2);
+    char *hex = new char[hexlen + 1];
+    str->WriteAscii(hex, 0, hexlen, String::HINT_MANY_WRITES_EXPECTED);
+    ssize_t written = Codec::HexDecode(hex, hexlen, buf, buflen);
+    delete [] hex;
+    return written;
+  }
+
   // THIS IS AWFUL!!! FIXME
 
   assert(encoding == BINARY);
@@ -1251,6 +1290,9 @@ static void ReportException(TryCatch &try_catch, bool show_line) {
   HandleScope scope;
   Handle<Message> message = try_catch.Message();
 
+  // Let buffered console output come out before the exception.
+  Stdio::Drain();
+
   if (show_line) DisplayExceptionLine(try_catch);
 
   String::Utf8Value trace(try_catch.StackTrace());
@@ -128,6 +128,58 @@
   startup.processStdio = function() {
     var stdout, stdin;
 
+    // A write-only stream over stdout. Writes are copied into a bounded
+    // native buffer which a helper thread drains into the fd, so they never
+    // block the event loop on a slow pipe and are flushed on exit. While
+    // the buffer is full writes are discarded; setPolicy('block') waits for
+    // room instead.
+    function createWriter(fd) {
+      var binding = process.binding('stdio'),
+          Stream = NativeModule.require('stream').Stream;
+
+      var writer = new Stream();
+      writer.fd = fd;
+      writer.writable = true;
+      writer.readable = false;
+
+      writer.write = function(data, encoding) {
+        if (!writer.writable) throw new Error('Stream is not writable');
+
+        if (typeof data == 'string') data = new Buffer(data, encoding);
+
+        try {
+          binding.writeBuffered(fd, data);
+        } catch (e) {
+          // EPIPE and friends: stop writing and report it the way
+          // net.Stream does.
+          writer.writable = false;
+          process.nextTick(function() {
+            writer.emit('error', e);
+          });
+          return false;
+        }
+        return true;
+      };
+
+      writer.end = function(data, encoding) {
+        if (data) writer.write(data, encoding);
+      };
+
+      writer.destroy = writer.destroySoon = function() { };
+
+      // writer.setPolicy('drop' | 'block', [bufferSize])
+      writer.setPolicy = function(policy, size) {
+        binding.setWriterPolicy(fd, policy, size);
+      };
+
+      // { policy, size, buffered, dropped }
+      writer.__defineGetter__('stats', function() {
+        return binding.getWriterStats(fd);
+      });
+
+      return writer;
+    }
+
     process.__defineGetter__('stdout', function() {
       if (stdout) return stdout;
 
@@ -139,6 +191,8 @@
 
       if (binding.isatty(fd)) {
         stdout = new tty.WriteStream(fd);
+      } else if (binding.writeBuffered) {
+        stdout = createWriter(fd);
       } else if (binding.isStdoutBlocking()) {
         stdout = new fs.WriteStream(null, {fd: fd});
       } else {
@@ -153,6 +207,8 @@
       return stdout;
     });
 
+    // stderr stays synchronous so that nothing is lost if the process
+    // aborts.
     var events = NativeModule.require('events');
     var stderr = process.stderr = new events.EventEmitter();
     stderr.writable = true;
@@ -1,10 +1,12 @@
 
 #include <node.h>
 #include <node_buffer.h>
+#include <node_buffer_codec.h>
 
 #include <v8.h>
 
 #include <assert.h>
+#include <math.h> // isfinite, fmod
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcpy
 
@@ -51,6 +53,197 @@ static Persistent<String> write_sym;
 Persistent<FunctionTemplate> Buffer::constructor_template;
 
 
+pthread_mutex_t BufferPool::mutex_ = PTHREAD_MUTEX_INITIALIZER;
+BufferPool::FreeChunk* BufferPool::free_lists_[BufferPool::kClassCount];
+size_t BufferPool::free_counts_[BufferPool::kClassCount];
+size_t BufferPool::max_cached_bytes_ = 16 * 1024 * 1024;
+size_t BufferPool::cached_bytes_ = 0;
+ssize_t BufferPool::external_delta_ = 0;
+double BufferPool::allocs_ = 0;
+double BufferPool::hits_ = 0;
+double BufferPool::misses_ = 0;
+double BufferPool::frees_ = 0;
+double BufferPool::releases_ = 0;
+size_t BufferPool::live_bytes_ = 0;
+size_t BufferPool::reserved_bytes_ = 0;
+
+
+// Returns the size class index for length or -1 if it is not pooled.
+int BufferPool::SizeClass(size_t length) {
+  if (length < kMinSize || length > kMaxSize) return -1;
+
+  int shift = kMinShift;
+  while (((size_t)1 << shift) < length) shift++;
+
+  return shift - kMinShift;
+}
+
+
+char* BufferPool::Alloc(size_t length) {
+  int cls = SizeClass(length);
+  size_t size = cls < 0 ? length : (size_t)1 << (cls + kMinShift);
+  char* data = NULL;
+
+  pthread_mutex_lock(&mutex_);
+
+  allocs_++;
+  live_bytes_ += length;
+  reserved_bytes_ += size;
+
+  if (cls >= 0 && free_lists_[cls]) {
+    FreeChunk* chunk = free_lists_[cls];
+    free_lists_[cls] = chunk->next;
+    free_counts_[cls]--;
+    cached_bytes_ -= size;
+    data = reinterpret_cast<char*>(chunk);
+    hits_++;
+  } else {
+    misses_++;
+    external_delta_ += size;
+  }
+
+  pthread_mutex_unlock(&mutex_);
+
+  if (data == NULL) data = new char[size];
+
+  return data;
+}
+
+
+void BufferPool::Free(char* data, size_t length) {
+  int cls = SizeClass(length);
+  size_t size = cls < 0 ? length : (size_t)1 << (cls + kMinShift);
+  bool release = true;
+
+  pthread_mutex_lock(&mutex_);
+
+  frees_++;
+  live_bytes_ -= length;
+  reserved_bytes_ -= size;
+
+  if (cls >= 0 && cached_bytes_ + size <= max_cached_bytes_) {
+    FreeChunk* chunk = reinterpret_cast<FreeChunk*>(data);
+    chunk->next = free_lists_[cls];
+    free_lists_[cls] = chunk;
+    free_counts_[cls]++;
+    cached_bytes_ += size;
+    release = false;
+  } else {
+    releases_++;
+    external_delta_ -= size;
+  }
+
+  pthread_mutex_unlock(&mutex_);
+
+  if (release) delete [] data;
+}
+
+
+ssize_t BufferPool::TakeExternalDelta() {
+  pthread_mutex_lock(&mutex_);
+  ssize_t delta = external_delta_;
+  external_delta_ = 0;
+  pthread_mutex_unlock(&mutex_);
+  return delta;
+}
+
+
+// var stats = SlowBuffer.poolStats();
+Handle<Value> BufferPool::Stats(const Arguments &args) {
+  HandleScope scope;
+
+  Local<Object> stats = Object::New();
+  Local<Array> classes = Array::New(kClassCount);
+
+  pthread_mutex_lock(&mutex_);
+
+  stats->Set(String::NewSymbol("allocs"), Number::New(allocs_));
+  stats->Set(String::NewSymbol("hits"), Number::New(hits_));
+  stats->Set(String::NewSymbol("misses"), Number::New(misses_));
+  stats->Set(String::NewSymbol("frees"), Number::New(frees_));
+  stats->Set(String::NewSymbol("releases"), Number::New(releases_));
+  stats->Set(String::NewSymbol("hitRate"),
+             Number::New(allocs_ > 0 ? hits_ / allocs_ : 0));
+  stats->Set(String::NewSymbol("liveBytes"), Number::New(live_bytes_));
+  stats->Set(String::NewSymbol("reservedBytes"),
+             Number::New(reserved_bytes_));
+  // Share of the reserved bytes that is lost to size class rounding.
+  stats->Set(String::NewSymbol("fragmentation"),
+             Number::New(reserved_bytes_ > 0
+                 ? 1 - (double)live_bytes_ / reserved_bytes_ : 0));
+  stats->Set(String::NewSymbol("cachedBytes"), Number::New(cached_bytes_));
+  stats->Set(String::NewSymbol("maxCachedBytes"),
+             Number::New(max_cached_bytes_));
+
+  for (int i = 0; i < kClassCount; i++) {
+    Local<Object> cls = Object::New();
+    cls->Set(String::NewSymbol("size"), Integer::New(1 << (i + kMinShift)));
+    cls->Set(String::NewSymbol("cached"), Number::New(free_counts_[i]));
+    classes->Set(Integer::New(i), cls);
+  }
+
+  pthread_mutex_unlock(&mutex_);
+
+  stats->Set(String::NewSymbol("classes"), classes);
+
+  return scope.Close(stats);
+}
+
+
+// SlowBuffer.setPoolCacheSize(bytes);
+Handle<Value> BufferPool::SetCacheSize(const Arguments &args) {
+  HandleScope scope;
+
+  if (!args[0]->IsNumber() || args[0]->NumberValue() < 0) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Argument must be a non-negative number")));
+  }
+
+  FreeChunk* released = NULL;
+
+  pthread_mutex_lock(&mutex_);
+
+  max_cached_bytes_ = (size_t)args[0]->NumberValue();
+
+  // Trim the largest classes first until we fit into the new limit.
+  for (int i = kClassCount - 1; i >= 0 && cached_bytes_ > max_cached_bytes_;
+       i--) {
+    size_t size = (size_t)1 << (i + kMinShift);
+    while (free_lists_[i] && cached_bytes_ > max_cached_bytes_) {
+      FreeChunk* chunk = free_lists_[i];
+      free_lists_[i] = chunk->next;
+      free_counts_[i]--;
+      cached_bytes_ -= size;
+      external_delta_ -= size;
+      releases_++;
+      chunk->next = released;
+      released = chunk;
+    }
+  }
+
+  pthread_mutex_unlock(&mutex_);
+
+  while (released) {
+    FreeChunk* next = released->next;
+    delete [] reinterpret_cast<char*>(released);
+    released = next;
+  }
+
+  ssize_t delta = TakeExternalDelta();
+  if (delta) V8::AdjustAmountOfExternalAllocatedMemory(delta);
+
+  return Undefined();
+}
+
+
+void BufferPool::Initialize(Handle<Object> target) {
+  HandleScope scope;
+
+  NODE_SET_METHOD(target, "poolStats", BufferPool::Stats);
+  NODE_SET_METHOD(target, "setPoolCacheSize", BufferPool::SetCacheSize);
+}
+
+
 static inline size_t base64_decoded_size(const char *src, size_t size) {
   const char *const end = src + size;
   const int remainder = size % 4;
@@ -86,6 +279,8 @@ static size_t ByteLength (Handle<String> string, enum encoding enc) {
     return base64_decoded_size(*v, v.length());
   } else if (enc == UCS2) {
     return string->Length() * 2;
+  } else if (enc == HEX) {
+    return string->Length() / 2;
   } else {
     return string->Length();
   }
@@ -186,8 +381,7 @@ void Buffer::Replace(char *data, size_t length,
   if (callback_) {
     callback_(data_, callback_hint_);
   } else if (length_) {
-    delete [] data_;
-    V8::AdjustAmountOfExternalAllocatedMemory(-(sizeof(Buffer) + length_));
+    BufferPool::Free(data_, length_);
   }
 
   length_ = length;
@@ -197,14 +391,18 @@ void Buffer::Replace(char *data, size_t length,
   if (callback_) {
     data_ = data;
   } else if (length_) {
-    data_ = new char[length_];
+    data_ = BufferPool::Alloc(length_);
     if (data)
       memcpy(data_, data, length_);
-    V8::AdjustAmountOfExternalAllocatedMemory(sizeof(Buffer) + length_);
   } else {
     data_ = NULL;
   }
 
+  // Only chunks that actually came from (or went back to) the system count
+  // against the external memory limit; recycled ones are already accounted.
+  ssize_t delta = BufferPool::TakeExternalDelta();
+  if (delta) V8::AdjustAmountOfExternalAllocatedMemory(delta);
+
   handle_->SetIndexedPropertiesToExternalArrayData(data_,
                                                    kExternalUnsignedByteArray,
                                                    length_);
@@ -226,13 +424,53 @@ Handle<Value> Buffer::BinarySlice(const Arguments &args) {
 }
 
 
+// Backing store for large slices that turned out to be pure ASCII. V8
+// uses the bytes as they are instead of running its UTF-8 decoder over
+// them. The memory comes from BufferPool so that it is accounted for
+// without calling into V8 from the GC.
+class ExternalAsciiSlice : public String::ExternalAsciiStringResource {
+ public:
+  static const size_t kMinLength = BufferPool::kMinSize;
+
+  ExternalAsciiSlice(const char *data, size_t length) : length_(length) {
+    data_ = BufferPool::Alloc(length_);
+    memcpy(data_, data, length_);
+  }
+
+  ~ExternalAsciiSlice() {
+    BufferPool::Free(data_, length_);
+  }
+
+  const char* data() const { return data_; }
+  size_t length() const { return length_; }
+
+ private:
+  char *data_;
+  size_t length_;
+};
+
+
+static Local<String> NewUtf8String(const char *data, size_t length) {
+  if (length >= ExternalAsciiSlice::kMinLength &&
+      Codec::IsAscii(data, length)) {
+    Local<String> string =
+      String::NewExternal(new ExternalAsciiSlice(data, length));
+    ssize_t delta = BufferPool::TakeExternalDelta();
+    if (delta) V8::AdjustAmountOfExternalAllocatedMemory(delta);
+    return string;
+  }
+
+  return String::New(data, length);
+}
+
+
 Handle<Value> Buffer::AsciiSlice(const Arguments &args) {
   HandleScope scope;
   Buffer *parent = ObjectWrap::Unwrap<Buffer>(args.This());
   SLICE_ARGS(args[0], args[1])
 
   char* data = parent->data_ + start;
-  Local<String> string = String::New(data, end - start);
+  Local<String> string = NewUtf8String(data, end - start);
 
   return scope.Close(string);
 }
@@ -243,7 +481,7 @@ Handle<Value> Buffer::Utf8Slice(const Arguments &args) {
   Buffer *parent = ObjectWrap::Unwrap<Buffer>(args.This());
   SLICE_ARGS(args[0], args[1])
   char *data = parent->data_ + start;
-  Local<String> string = String::New(data, end - start);
+  Local<String> string = NewUtf8String(data, end - start);
   return scope.Close(string);
 }
 
@@ -256,95 +494,31 @@ Handle<Value> Buffer::Ucs2Slice(const Arguments &args) {
   return scope.Close(string);
 }
 
-static const char *base64_table = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                                  "abcdefghijklmnopqrstuvwxyz"
-                                  "0123456789+/";
-static const int unbase64_table[] =
-  {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2,-1,-1,-2,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63
-  ,52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1
-  ,-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14
-  ,15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1
-  ,-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40
-  ,41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-  };
-#define unbase64(x) unbase64_table[(uint8_t)(x)]
-
-
 Handle<Value> Buffer::Base64Slice(const Arguments &args) {
   HandleScope scope;
   Buffer *parent = ObjectWrap::Unwrap<Buffer>(args.This());
   SLICE_ARGS(args[0], args[1])
 
-  int n = end - start;
-  int out_len = (n + 2 - ((n + 2) % 3)) / 3 * 4;
+  size_t out_len = Codec::Base64EncodedSize(end - start);
   char *out = new char[out_len];
 
-  uint8_t bitbuf[3];
-  int i = start; // data() index
-  int j = 0; // out index
-  char c;
-  bool b1_oob, b2_oob;
-
-  while (i < end) {
-    bitbuf[0] = parent->data_[i++];
-
-    if (i < end) {
-      bitbuf[1] = parent->data_[i];
-      b1_oob = false;
-    }  else {
-      bitbuf[1] = 0;
-      b1_oob = true;
-    }
-    i++;
-
-    if (i < end) {
-      bitbuf[2] = parent->data_[i];
-      b2_oob = false;
-    }  else {
-      bitbuf[2] = 0;
-      b2_oob = true;
-    }
-    i++;
+  Codec::Base64Encode(parent->data_ + start, end - start, out);
 
+  Local<String> string = String::New(out, out_len);
+  delete [] out;
+  return scope.Close(string);
+}
 
-    c = bitbuf[0] >> 2;
-    assert(c < 64);
-    out[j++] = base64_table[(int)c];
-    assert(j < out_len);
 
-    c = ((bitbuf[0] & 0x03) << 4) | (bitbuf[1] >> 4);
-    assert(c < 64);
-    out[j++] = base64_table[(int)c];
-    assert(j < out_len);
+Handle<Value> Buffer::HexSlice(const Arguments &args) {
+  HandleScope scope;
+  Buffer *parent = ObjectWrap::Unwrap<Buffer>(args.This());
+  SLICE_ARGS(args[0], args[1])
 
-    if (b1_oob) {
-      out[j++] = '=';
-    } else {
-      c = ((bitbuf[1] & 0x0F) << 2) | (bitbuf[2] >> 6);
-      assert(c < 64);
-      out[j++] = base64_table[(int)c];
-    }
-    assert(j < out_len);
+  size_t out_len = (end - start) * 2;
+  char *out = new char[out_len];
 
-    if (b2_oob) {
-      out[j++] = '=';
-    } else {
-      c = bitbuf[2] & 0x3F;
-      assert(c < 64);
-      out[j++]  = base64_table[(int)c];
-    }
-    assert(j <= out_len);
-  }
+  Codec::HexEncode(parent->data_ + start, end - start, out);
 
   Local<String> string = String::New(out, out_len);
   delete [] out;
@@ -411,6 +585,211 @@ Handle<Value> Buffer::Copy(const Arguments &args) {
 }
 
 
+// var bytesCopied = SlowBuffer.concat(list, target);
+// Copies every buffer in list back to back into target and zero fills
+// whatever is left of target.
+Handle<Value> Buffer::Concat(const Arguments &args) {
+  HandleScope scope;
+
+  if (!args[0]->IsArray()) {
+    return ThrowException(Exception::TypeError(String::New(
+            "First arg should be an Array of Buffers")));
+  }
+
+  if (!Buffer::HasInstance(args[1])) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Second arg should be a Buffer")));
+  }
+
+  Local<Array> list = Local<Array>::Cast(args[0]);
+  Local<Object> target = args[1]->ToObject();
+  char *target_data = Buffer::Data(target);
+  size_t target_length = Buffer::Length(target);
+  size_t offset = 0;
+
+  uint32_t n = list->Length();
+  for (uint32_t i = 0; i < n && offset < target_length; i++) {
+    Local<Value> item = list->Get(i);
+    if (!Buffer::HasInstance(item)) {
+      return ThrowException(Exception::TypeError(String::New(
+              "List should only contain Buffers")));
+    }
+
+    Local<Object> chunk = item->ToObject();
+    size_t to_copy = MIN(Buffer::Length(chunk), target_length - offset);
+    memcpy(target_data + offset, Buffer::Data(chunk), to_copy);
+    offset += to_copy;
+  }
+
+  if (offset < target_length) {
+    memset(target_data + offset, 0, target_length - offset);
+  }
+
+  return scope.Close(Integer::NewFromUnsigned(offset));
+}
+
+
+// Needles shorter than this, or haystacks shorter than kHorspoolMinHaystack,
+// are searched with memchr on the first byte; the skip table would not pay
+// for itself.
+static const size_t kHorspoolMinNeedle = 4;
+static const size_t kHorspoolMinHaystack = 256;
+
+
+static const char* SearchForward(const char *hay, size_t hlen,
+                                 const char *needle, size_t nlen) {
+  if (nlen > hlen) return NULL;
+
+  if (nlen == 1) {
+    return static_cast<const char*>(memchr(hay, needle[0], hlen));
+  }
+
+  const char *last = hay + hlen - nlen;
+
+  if (nlen < kHorspoolMinNeedle || hlen < kHorspoolMinHaystack) {
+    const char *p = hay;
+    while (p <= last) {
+      p = static_cast<const char*>(memchr(p, needle[0], last - p + 1));
+      if (p == NULL) return NULL;
+      if (memcmp(p + 1, needle + 1, nlen - 1) == 0) return p;
+      p++;
+    }
+    return NULL;
+  }
+
+  // Boyer-Moore-Horspool
+  size_t skip[256];
+  for (int i = 0; i < 256; i++) skip[i] = nlen;
+  for (size_t i = 0; i < nlen - 1; i++) skip[(uint8_t)needle[i]] = nlen - 1 - i;
+
+  const char tail = needle[nlen - 1];
+  for (const char *p = hay; p <= last; ) {
+    char c = p[nlen - 1];
+    if (c == tail && memcmp(p, needle, nlen - 1) == 0) return p;
+    p += skip[(uint8_t)c];
+  }
+
+  return NULL;
+}
+
+
+static const char* SearchBackward(const char *hay, size_t hlen,
+                                  const char *needle, size_t nlen) {
+  if (nlen > hlen) return NULL;
+
+  const char *p = hay + hlen - nlen;
+
+  if (nlen < kHorspoolMinNeedle || hlen < kHorspoolMinHaystack) {
+    for (;; p--) {
+      if (*p == needle[0] && memcmp(p + 1, needle + 1, nlen - 1) == 0) {
+        return p;
+      }
+      if (p == hay) return NULL;
+    }
+  }
+
+  // Horspool mirrored: the window moves left and is keyed on its first
+  // byte, which must line up with the nearest equal byte in needle[1..].
+  size_t skip[256];
+  for (int i = 0; i < 256; i++) skip[i] = nlen;
+  for (size_t i = nlen - 1; i > 0; i--) skip[(uint8_t)needle[i]] = i;
+
+  const char head = needle[0];
+  for (;;) {
+    char c = *p;
+    if (c == head && memcmp(p + 1, needle + 1, nlen - 1) == 0) return p;
+    size_t s = skip[(uint8_t)c];
+    if ((size_t)(p - hay) < s) return NULL;
+    p -= s;
+  }
+}
+
+
+// The needle of indexOf/lastIndexOf as a byte range: a byte value, a
+// string (searched as utf8) or a Buffer.
+class SearchNeedle {
+ public:
+  explicit SearchNeedle(Handle<Value> value)
+      : data_(NULL), length_(0), valid_(true), utf8_(NULL) {
+    if (value->IsNumber()) {
+      byte_ = (char)(value->Int32Value() & 255);
+      data_ = &byte_;
+      length_ = 1;
+    } else if (value->IsString()) {
+      utf8_ = new String::Utf8Value(value);
+      data_ = **utf8_;
+      length_ = utf8_->length();
+    } else if (Buffer::HasInstance(value)) {
+      Local<Object> obj = value->ToObject();
+      data_ = Buffer::Data(obj);
+      length_ = Buffer::Length(obj);
+    } else {
+      valid_ = false;
+    }
+  }
+
+  ~SearchNeedle() {
+    delete utf8_;
+  }
+
+  bool IsValid() const { return valid_; }
+  const char* data() const { return data_; }
+  size_t length() const { return length_; }
+
+ private:
+  const char *data_;
+  size_t length_;
+  bool valid_;
+  char byte_;
+  String::Utf8Value *utf8_;
+};
+
+
+// buffer.indexOf(needle, [start], [end]) and buffer.lastIndexOf(...)
+// Only matches lying entirely inside [start, end) are reported.
+static Handle<Value> Search(const Arguments &args, char *data, size_t length,
+                            bool backward) {
+  HandleScope scope;
+
+  SearchNeedle needle(args[0]);
+  if (!needle.IsValid()) {
+    return ThrowException(Exception::TypeError(String::New(
+            "needle must be a number, string or Buffer")));
+  }
+
+  size_t start = args[1]->IsUndefined() ? 0 : args[1]->Uint32Value();
+  size_t end = args[2]->IsUndefined() ? length : args[2]->Uint32Value();
+  if (end > length) end = length;
+  if (start > end) return scope.Close(Integer::New(-1));
+
+  // An empty needle matches at the edge of the window.
+  if (needle.length() == 0) {
+    return scope.Close(Integer::New(backward ? end : start));
+  }
+
+  const char *match = backward
+    ? SearchBackward(data + start, end - start, needle.data(), needle.length())
+    : SearchForward(data + start, end - start, needle.data(), needle.length());
+
+  if (match == NULL) return scope.Close(Integer::New(-1));
+  return scope.Close(Integer::New(match - data));
+}
+
+
+// var index = buffer.indexOf(needle, [start], [end]);
+Handle<Value> Buffer::IndexOf(const Arguments &args) {
+  Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
+  return Search(args, buffer->data_, buffer->length_, false);
+}
+
+
+// var index = buffer.lastIndexOf(needle, [start], [end]);
+Handle<Value> Buffer::LastIndexOf(const Arguments &args) {
+  Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
+  return Search(args, buffer->data_, buffer->length_, true);
+}
+
+
 // var charsWritten = buffer.utf8Write(string, offset, [maxLength]);
 Handle<Value> Buffer::Utf8Write(const Arguments &args) {
   HandleScope scope;
@@ -523,17 +902,6 @@ Handle<Value> Buffer::AsciiWrite(const Arguments &args) {
 Handle<Value> Buffer::Base64Write(const Arguments &args) {
   HandleScope scope;
 
-  assert(unbase64('/') == 63);
-  assert(unbase64('+') == 62);
-  assert(unbase64('T') == 19);
-  assert(unbase64('Z') == 25);
-  assert(unbase64('t') == 45);
-  assert(unbase64('z') == 51);
-
-  assert(unbase64(' ') == -2);
-  assert(unbase64('\n') == -2);
-  assert(unbase64('\r') == -2);
-
   Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
 
   if (!args[0]->IsString()) {
@@ -561,48 +929,46 @@ Handle<Value> Buffer::Base64Write(const Arguments &args) {
             "Buffer too small")));
   }
 
-  char a, b, c, d;
-  char* start = buffer->data_ + offset;
-  char* dst = start;
-  const char *src = *s;
-  const char *const srcEnd = src + s.length();
+  size_t written = Codec::Base64Decode(*s, s.length(),
+                                       buffer->data_ + offset,
+                                       buffer->length_ - offset);
 
-  while (src < srcEnd) {
-    int remaining = srcEnd - src;
+  return scope.Close(Integer::New(written));
+}
 
-    while (unbase64(*src) < 0 && src < srcEnd) {
-      src++;
-      remaining--;
-    }
-    if (remaining == 0 || *src == '=') break;
-    a = unbase64(*src++);
 
-    while (unbase64(*src) < 0 && src < srcEnd) {
-      src++;
-      remaining--;
-    }
-    if (remaining <= 1 || *src == '=') break;
-    b = unbase64(*src++);
-    *dst++ = (a << 2) | ((b & 0x30) >> 4);
+// var bytesWritten = buffer.hexWrite(string, offset, [maxLength]);
+// A trailing odd digit is ignored, as in DecodeWrite().
+Handle<Value> Buffer::HexWrite(const Arguments &args) {
+  HandleScope scope;
 
-    while (unbase64(*src) < 0 && src < srcEnd) {
-      src++;
-      remaining--;
-    }
-    if (remaining <= 2 || *src == '=') break;
-    c = unbase64(*src++);
-    *dst++ = ((b & 0x0F) << 4) | ((c & 0x3C) >> 2);
+  Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
 
-    while (unbase64(*src) < 0 && src < srcEnd) {
-      src++;
-      remaining--;
-    }
-    if (remaining <= 3 || *src == '=') break;
-    d = unbase64(*src++);
-    *dst++ = ((c & 0x03) << 6) | (d & 0x3F);
+  if (!args[0]->IsString()) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Argument must be a string")));
+  }
+
+  String::AsciiValue s(args[0]->ToString());
+  size_t offset = args[1]->Uint32Value();
+
+  if (s.length() >= 2 && offset >= buffer->length_) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Offset is out of bounds")));
   }
 
-  return scope.Close(Integer::New(dst - start));
+  size_t max_length = args[2]->IsUndefined() ? buffer->length_ - offset
+                                             : args[2]->Uint32Value();
+  max_length = MIN(buffer->length_ - offset, max_length);
+
+  ssize_t written = Codec::HexDecode(*s, s.length(),
+                                     buffer->data_ + offset, max_length);
+  if (written < 0) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Invalid hex string")));
+  }
+
+  return scope.Close(Integer::New(written));
 }
 
 
@@ -650,6 +1016,123 @@ Handle<Value> Buffer::ByteLength(const Arguments &args) {
 }
 
 
+// Buffer.isAscii(buffer) / Buffer.isUtf8(buffer)
+Handle<Value> Buffer::IsAscii(const Arguments &args) {
+  HandleScope scope;
+
+  if (!Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Argument should be a Buffer")));
+  }
+
+  Local<Object> obj = args[0]->ToObject();
+  bool r = Codec::IsAscii(Buffer::Data(obj), Buffer::Length(obj));
+
+  return scope.Close(Boolean::New(r));
+}
+
+
+Handle<Value> Buffer::IsUtf8(const Arguments &args) {
+  HandleScope scope;
+
+  if (!Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Argument should be a Buffer")));
+  }
+
+  Local<Object> obj = args[0]->ToObject();
+  bool r = Codec::IsUtf8(Buffer::Data(obj), Buffer::Length(obj));
+
+  return scope.Close(Boolean::New(r));
+}
+
+
+static inline bool IsBigEndianHost() {
+  const uint16_t probe = 1;
+  return *reinterpret_cast<const uint8_t*>(&probe) == 0;
+}
+
+
+// Copies sizeof(T) bytes, reversing them if the requested byte order
+// differs from the host's. memcpy keeps unaligned offsets safe.
+template <typename T>
+static inline void CopyOrdered(void *dst, const void *src, bool big_endian) {
+  if (big_endian == IsBigEndianHost()) {
+    memcpy(dst, src, sizeof(T));
+  } else {
+    const uint8_t *s = static_cast<const uint8_t*>(src);
+    uint8_t *d = static_cast<uint8_t*>(dst);
+    for (size_t i = 0; i < sizeof(T); i++) d[i] = s[sizeof(T) - 1 - i];
+  }
+}
+
+
+// Integer conversion wraps around like a C cast but stays defined for
+// values that do not fit into 64 bits.
+template <typename T>
+static inline T NumberTo(double d) {
+  if (!isfinite(d)) return 0;
+  return static_cast<T>(static_cast<int64_t>(fmod(d, 4294967296.0)));
+}
+
+template <>
+inline float NumberTo<float>(double d) {
+  return static_cast<float>(d);
+}
+
+template <>
+inline double NumberTo<double>(double d) {
+  return d;
+}
+
+
+#define NUMBER_OFFSET_ARG(a, size)                                    \
+  if (!(a)->IsNumber() || (a)->NumberValue() < 0) {                   \
+    return ThrowException(Exception::TypeError(                       \
+          String::New("Offset must be a non-negative number")));      \
+  }                                                                   \
+  size_t offset = (a)->Uint32Value();                                 \
+  if (offset + (size) > buffer->length_) {                            \
+    return ThrowException(Exception::RangeError(                      \
+          String::New("Trying to access beyond buffer length")));     \
+  }
+
+
+// var value = buffer.readUInt32BE(offset);
+template <typename T, bool big_endian>
+Handle<Value> Buffer::ReadNumber(const Arguments &args) {
+  HandleScope scope;
+  Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
+  NUMBER_OFFSET_ARG(args[0], sizeof(T))
+
+  T value;
+  CopyOrdered<T>(&value, buffer->data_ + offset, big_endian);
+
+  return scope.Close(Number::New(static_cast<double>(value)));
+}
+
+
+// buffer.writeUInt32BE(value, offset);
+// Range checks for the value live in buffer.js.
+template <typename T, bool big_endian>
+Handle<Value> Buffer::WriteNumber(const Arguments &args) {
+  HandleScope scope;
+  Buffer *buffer = ObjectWrap::Unwrap<Buffer>(args.This());
+
+  if (!args[0]->IsNumber()) {
+    return ThrowException(Exception::TypeError(String::New(
+            "Value must be a number")));
+  }
+
+  NUMBER_OFFSET_ARG(args[1], sizeof(T))
+
+  T value = NumberTo<T>(args[0]->NumberValue());
+  CopyOrdered<T>(buffer->data_ + offset, &value, big_endian);
+
+  return Undefined();
+}
+
+
 Handle<Value> Buffer::MakeFastBuffer(const Arguments &args) {
   HandleScope scope;
 
@@ -684,6 +1167,8 @@ bool Buffer::HasInstance(v8::Handle<v8::Value> val) {
 void Buffer::Initialize(Handle<Object> target) {
   HandleScope scope;
 
+  Codec::Initialize();
+
   length_symbol = Persistent<String>::New(String::NewSymbol("length"));
   chars_written_sym = Persistent<String>::New(String::NewSymbol("_charsWritten"));
 
@@ -697,6 +1182,7 @@ void Buffer::Initialize(Handle<Object> target) {
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "asciiSlice", Buffer::AsciiSlice);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "base64Slice", Buffer::Base64Slice);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "ucs2Slice", Buffer::Ucs2Slice);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "hexSlice", Buffer::HexSlice);
   // TODO NODE_SET_PROTOTYPE_METHOD(t, "utf16Slice", Utf16Slice);
   // copy
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "utf8Slice", Buffer::Utf8Slice);
@@ -706,7 +1192,61 @@ void Buffer::Initialize(Handle<Object> target) {
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "binaryWrite", Buffer::BinaryWrite);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "base64Write", Buffer::Base64Write);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "ucs2Write", Buffer::Ucs2Write);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "hexWrite", Buffer::HexWrite);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "copy", Buffer::Copy);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "indexOf", Buffer::IndexOf);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "lastIndexOf",
+                            Buffer::LastIndexOf);
+
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readUInt16LE",
+                            (Buffer::ReadNumber<uint16_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readUInt16BE",
+                            (Buffer::ReadNumber<uint16_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readInt16LE",
+                            (Buffer::ReadNumber<int16_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readInt16BE",
+                            (Buffer::ReadNumber<int16_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readUInt32LE",
+                            (Buffer::ReadNumber<uint32_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readUInt32BE",
+                            (Buffer::ReadNumber<uint32_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readInt32LE",
+                            (Buffer::ReadNumber<int32_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readInt32BE",
+                            (Buffer::ReadNumber<int32_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readFloatLE",
+                            (Buffer::ReadNumber<float, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readFloatBE",
+                            (Buffer::ReadNumber<float, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readDoubleLE",
+                            (Buffer::ReadNumber<double, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "readDoubleBE",
+                            (Buffer::ReadNumber<double, true>));
+
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeUInt16LE",
+                            (Buffer::WriteNumber<uint16_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeUInt16BE",
+                            (Buffer::WriteNumber<uint16_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeInt16LE",
+                            (Buffer::WriteNumber<int16_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeInt16BE",
+                            (Buffer::WriteNumber<int16_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeUInt32LE",
+                            (Buffer::WriteNumber<uint32_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeUInt32BE",
+                            (Buffer::WriteNumber<uint32_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeInt32LE",
+                            (Buffer::WriteNumber<int32_t, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeInt32BE",
+                            (Buffer::WriteNumber<int32_t, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeFloatLE",
+                            (Buffer::WriteNumber<float, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeFloatBE",
+                            (Buffer::WriteNumber<float, true>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeDoubleLE",
+                            (Buffer::WriteNumber<double, false>));
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "writeDoubleBE",
+                            (Buffer::WriteNumber<double, true>));
 
   NODE_SET_METHOD(constructor_template->GetFunction(),
                   "byteLength",
@@ -715,6 +1255,20 @@ void Buffer::Initialize(Handle<Object> target) {
                   "makeFastBuffer",
                   Buffer::MakeFastBuffer);
 
+  NODE_SET_METHOD(constructor_template->GetFunction(),
+                  "concat",
+                  Buffer::Concat);
+  NODE_SET_METHOD(constructor_template->GetFunction(),
+                  "isAscii",
+                  Buffer::IsAscii);
+  NODE_SET_METHOD(constructor_template->GetFunction(),
+                  "isUtf8",
+                  Buffer::IsUtf8);
+  constructor_template->GetFunction()->Set(String::NewSymbol("codecKernel"),
+                                           String::New(Codec::Kernel()));
+
+  BufferPool::Initialize(constructor_template->GetFunction());
+
   target->Set(String::NewSymbol("SlowBuffer"), constructor_template->GetFunction());
 }
 
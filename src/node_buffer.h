@@ -5,9 +5,67 @@
 #include <node_object_wrap.h>
 #include <v8.h>
 #include <assert.h>
+#include <pthread.h>
 
 namespace node {
 
+/* Slab allocator for SlowBuffer backing stores.
+ *
+ * Chunks between kMinSize and kMaxSize bytes are rounded up to a power of
+ * two and recycled through per-size-class free lists instead of going back
+ * to malloc. Anything smaller or larger is allocated directly. Alloc() and
+ * Free() take a lock and may be called from eio threads.
+ *
+ * The pool does not talk to V8 itself. Bytes obtained from or returned to
+ * the system are accumulated and handed to the main thread through
+ * TakeExternalDelta(), so recycled chunks never trigger
+ * AdjustAmountOfExternalAllocatedMemory().
+ */
+class BufferPool {
+ public:
+  static const int kMinShift = 10;  // 1kb
+  static const int kMaxShift = 20;  // 1mb
+  static const int kClassCount = kMaxShift - kMinShift + 1;
+  static const size_t kMinSize = 1 << kMinShift;
+  static const size_t kMaxSize = 1 << kMaxShift;
+
+  static char* Alloc(size_t length);
+  static void Free(char* data, size_t length);
+
+  // Bytes allocated from the system minus bytes returned to it since the
+  // last call. Only call this from the main thread.
+  static ssize_t TakeExternalDelta();
+
+  static void Initialize(v8::Handle<v8::Object> target);
+
+ private:
+  static v8::Handle<v8::Value> Stats(const v8::Arguments &args);
+  static v8::Handle<v8::Value> SetCacheSize(const v8::Arguments &args);
+
+  static int SizeClass(size_t length);
+
+  struct FreeChunk {
+    FreeChunk* next;
+  };
+
+  static pthread_mutex_t mutex_;
+  static FreeChunk* free_lists_[kClassCount];
+  static size_t free_counts_[kClassCount];
+  static size_t max_cached_bytes_;
+  static size_t cached_bytes_;
+  static ssize_t external_delta_;
+
+  // statistics
+  static double allocs_;
+  static double hits_;
+  static double misses_;
+  static double frees_;
+  static double releases_;
+  static size_t live_bytes_;
+  static size_t reserved_bytes_;
+};
+
+
 /* A buffer is a chunk of memory stored outside the V8 heap, mirrored by an
  * object in javascript. The object is not totally opaque, one can access
  * individual bytes with [] and slice it into substrings or sub-buffers
@@ -89,14 +147,26 @@ class Buffer : public ObjectWrap {
   static v8::Handle<v8::Value> Base64Slice(const v8::Arguments &args);
   static v8::Handle<v8::Value> Utf8Slice(const v8::Arguments &args);
   static v8::Handle<v8::Value> Ucs2Slice(const v8::Arguments &args);
+  static v8::Handle<v8::Value> HexSlice(const v8::Arguments &args);
   static v8::Handle<v8::Value> BinaryWrite(const v8::Arguments &args);
   static v8::Handle<v8::Value> Base64Write(const v8::Arguments &args);
   static v8::Handle<v8::Value> AsciiWrite(const v8::Arguments &args);
   static v8::Handle<v8::Value> Utf8Write(const v8::Arguments &args);
   static v8::Handle<v8::Value> Ucs2Write(const v8::Arguments &args);
+  static v8::Handle<v8::Value> HexWrite(const v8::Arguments &args);
   static v8::Handle<v8::Value> ByteLength(const v8::Arguments &args);
   static v8::Handle<v8::Value> MakeFastBuffer(const v8::Arguments &args);
+  static v8::Handle<v8::Value> IsAscii(const v8::Arguments &args);
+  static v8::Handle<v8::Value> IsUtf8(const v8::Arguments &args);
+
+  template <typename T, bool big_endian>
+  static v8::Handle<v8::Value> ReadNumber(const v8::Arguments &args);
+  template <typename T, bool big_endian>
+  static v8::Handle<v8::Value> WriteNumber(const v8::Arguments &args);
   static v8::Handle<v8::Value> Copy(const v8::Arguments &args);
+  static v8::Handle<v8::Value> Concat(const v8::Arguments &args);
+  static v8::Handle<v8::Value> IndexOf(const v8::Arguments &args);
+  static v8::Handle<v8::Value> LastIndexOf(const v8::Arguments &args);
 
   Buffer(v8::Handle<v8::Object> wrapper, size_t length);
   void Replace(char *data, size_t length, free_callback callback, void *hint);
@@ -0,0 +1,552 @@
+#include <node_buffer_codec.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h> // memcpy
+
+#if defined(__x86_64__) || defined(__i386__)
+# if defined(__SSE2__)
+#  define NODE_CODEC_SSE2 1
+#  include <emmintrin.h>
+# endif
+// target("avx2") together with the AVX2 intrinsics needs gcc 4.9 or clang.
+# if defined(__SSE2__) && defined(__GNUC__) && \
+     (defined(__clang__) || __GNUC__ > 4 || \
+      (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define NODE_CODEC_AVX2 1
+#  include <immintrin.h>
+#  include <cpuid.h>
+#  define AVX2_TARGET __attribute__((target("avx2")))
+# endif
+#endif
+
+
+namespace node {
+
+
+static const char base64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                   "abcdefghijklmnopqrstuvwxyz"
+                                   "0123456789+/";
+
+static const int8_t unbase64_table[256] =
+  {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2,-1,-1,-2,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63
+  ,52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1
+  ,-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14
+  ,15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1
+  ,-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40
+  ,41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  ,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+  };
+#define unbase64(x) unbase64_table[(uint8_t)(x)]
+
+static const char hex_table[] = "0123456789abcdef";
+
+static inline int unhex(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+
+/* Block kernels. Each one handles as much of the input as its vector
+ * width allows and returns the number of input bytes it consumed; the
+ * portable code below finishes the rest.
+ */
+struct CodecKernels {
+  const char* name;
+  // Consumes a multiple of 3 bytes, writes 4 characters for each 3 bytes.
+  size_t (*base64_encode)(const uint8_t* src, size_t len, char* dst);
+  // Consumes a multiple of 4 characters, all of which must be in the
+  // alphabet, and writes 3 bytes for each 4 characters.
+  size_t (*base64_decode)(const char* src, size_t len,
+                          uint8_t* dst, size_t dstlen);
+  size_t (*hex_encode)(const uint8_t* src, size_t len, char* dst);
+  // Consumes an even number of valid hex digits.
+  size_t (*hex_decode)(const char* src, size_t len, uint8_t* dst);
+  // Length of the leading run of bytes < 0x80.
+  size_t (*ascii_prefix)(const uint8_t* src, size_t len);
+};
+
+
+// Scalar kernels
+
+static size_t Base64EncodeScalar(const uint8_t* src, size_t len, char* dst) {
+  size_t i = 0;
+
+  for (; i + 3 <= len; i += 3) {
+    uint32_t v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+    *dst++ = base64_table[v >> 18];
+    *dst++ = base64_table[(v >> 12) & 0x3F];
+    *dst++ = base64_table[(v >> 6) & 0x3F];
+    *dst++ = base64_table[v & 0x3F];
+  }
+
+  return i;
+}
+
+
+static size_t Base64DecodeScalar(const char* src, size_t len,
+                                 uint8_t* dst, size_t dstlen) {
+  size_t i = 0;
+
+  for (; i + 4 <= len && dstlen >= 3; i += 4, dstlen -= 3) {
+    int a = unbase64(src[i]);
+    int b = unbase64(src[i + 1]);
+    int c = unbase64(src[i + 2]);
+    int d = unbase64(src[i + 3]);
+    if ((a | b | c | d) < 0) break;
+
+    uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+    *dst++ = v >> 16;
+    *dst++ = v >> 8;
+    *dst++ = v;
+  }
+
+  return i;
+}
+
+
+static size_t HexEncodeScalar(const uint8_t* src, size_t len, char* dst) {
+  for (size_t i = 0; i < len; i++) {
+    *dst++ = hex_table[src[i] >> 4];
+    *dst++ = hex_table[src[i] & 0x0F];
+  }
+  return len;
+}
+
+
+static size_t HexDecodeScalar(const char* src, size_t len, uint8_t* dst) {
+  size_t i = 0;
+
+  for (; i + 2 <= len; i += 2) {
+    int a = unhex(src[i]);
+    int b = unhex(src[i + 1]);
+    if ((a | b) < 0) break;
+    *dst++ = (a << 4) | b;
+  }
+
+  return i;
+}
+
+
+static size_t AsciiPrefixScalar(const uint8_t* src, size_t len) {
+  size_t i = 0;
+
+  // Eight bytes at a time; memcpy keeps this safe on strict-alignment CPUs.
+  for (; i + 8 <= len; i += 8) {
+    uint64_t v;
+    memcpy(&v, src + i, sizeof(v));
+    if (v & 0x8080808080808080ULL) break;
+  }
+
+  while (i < len && src[i] < 0x80) i++;
+
+  return i;
+}
+
+
+static const CodecKernels scalar_kernels = {
+  "scalar",
+  Base64EncodeScalar,
+  Base64DecodeScalar,
+  HexEncodeScalar,
+  HexDecodeScalar,
+  AsciiPrefixScalar
+};
+
+
+#ifdef NODE_CODEC_SSE2
+
+static size_t HexEncodeSSE2(const uint8_t* src, size_t len, char* dst) {
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zero = _mm_set1_epi8('0');
+  // distance between '9' + 1 and 'a'
+  const __m128i alpha = _mm_set1_epi8('a' - '0' - 10);
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    __m128i lo = _mm_and_si128(v, mask);
+
+    hi = _mm_add_epi8(_mm_add_epi8(hi, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+    lo = _mm_add_epi8(_mm_add_epi8(lo, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+    dst += 32;
+  }
+
+  return i + HexEncodeScalar(src + i, len - i, dst);
+}
+
+
+static size_t HexDecodeSSE2(const char* src, size_t len, uint8_t* dst) {
+  const __m128i digit0 = _mm_set1_epi8('0');
+  const __m128i alpha0 = _mm_set1_epi8('a');
+  const __m128i lower = _mm_set1_epi8(0x20);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i five = _mm_set1_epi8(5);
+  const __m128i ten = _mm_set1_epi8(10);
+  const __m128i low_byte = _mm_set1_epi16(0x00FF);
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+    // Unsigned "x <= n" is min(x, n) == x.
+    __m128i d = _mm_sub_epi8(v, digit0);
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+    __m128i a = _mm_sub_epi8(_mm_or_si128(v, lower), alpha0);
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(a, five), a);
+
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF) break;
+
+    __m128i n = _mm_or_si128(_mm_and_si128(is_digit, d),
+                             _mm_and_si128(is_alpha, _mm_add_epi8(a, ten)));
+
+    // Each 16 bit lane holds (low nibble << 8) | high nibble.
+    __m128i packed = _mm_or_si128(_mm_slli_epi16(n, 4), _mm_srli_epi16(n, 8));
+    packed = _mm_packus_epi16(_mm_and_si128(packed, low_byte),
+                              _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packed);
+    dst += 8;
+  }
+
+  return i + HexDecodeScalar(src + i, len - i, dst);
+}
+
+
+static size_t AsciiPrefixSSE2(const uint8_t* src, size_t len) {
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(v)) break;
+  }
+
+  return i + AsciiPrefixScalar(src + i, len - i);
+}
+
+
+static const CodecKernels sse2_kernels = {
+  "sse2",
+  Base64EncodeScalar,
+  Base64DecodeScalar,
+  HexEncodeSSE2,
+  HexDecodeSSE2,
+  AsciiPrefixSSE2
+};
+
+#endif  // NODE_CODEC_SSE2
+
+
+#ifdef NODE_CODEC_AVX2
+
+// Base64 kernels after Wojciech Muła and Daniel Lemire, "Faster Base64
+// Encoding and Decoding using AVX2 Instructions".
+
+AVX2_TARGET
+static size_t Base64EncodeAVX2(const uint8_t* src, size_t len, char* dst) {
+  const __m256i shuf = _mm256_set_epi8(
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m256i shift_lut = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+      '/' - 63, 'A', 0, 0,
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+      '/' - 63, 'A', 0, 0);
+  size_t i = 0;
+
+  // Each lane reads 16 bytes and uses 12 of them, so stay 4 bytes away
+  // from the end of the input.
+  for (; i + 28 <= len; i += 24) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i hi = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + i + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+    // Spread every 3 bytes over a 32 bit lane, then isolate the sextets.
+    in = _mm256_shuffle_epi8(in, shuf);
+    __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00));
+    __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0));
+    __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(t1, t3);
+
+    // Map 0..63 to the alphabet with one table lookup.
+    __m256i r = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    r = _mm256_or_si256(r, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    r = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, r), indices);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), r);
+    dst += 32;
+  }
+
+  return i + Base64EncodeScalar(src + i, len - i, dst);
+}
+
+
+AVX2_TARGET
+static size_t Base64DecodeAVX2(const char* src, size_t len,
+                               uint8_t* dst, size_t dstlen) {
+  const __m256i lut_lo = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i lut_hi = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+  const __m256i pack_shuf = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i pack_perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+  size_t i = 0;
+
+  // 32 characters give 24 bytes but the store writes 32.
+  for (; i + 32 <= len && dstlen >= 32; i += 32, dstlen -= 24) {
+    __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+    __m256i lo_nibbles = _mm256_and_si256(in, mask_2f);
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+    // Whitespace, padding or garbage: leave the block to the scalar code.
+    if (!_mm256_testz_si256(lo, hi)) break;
+
+    __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+    __m256i roll = _mm256_shuffle_epi8(lut_roll,
+                                       _mm256_add_epi8(eq_2f, hi_nibbles));
+    in = _mm256_add_epi8(in, roll);
+
+    // Merge four sextets into three bytes per 32 bit lane.
+    __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, pack_shuf);
+    merged = _mm256_permutevar8x32_epi32(merged, pack_perm);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), merged);
+    dst += 24;
+  }
+
+  return i + Base64DecodeScalar(src + i, len - i, dst, dstlen);
+}
+
+
+AVX2_TARGET
+static size_t AsciiPrefixAVX2(const uint8_t* src, size_t len) {
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    if (_mm256_movemask_epi8(v)) break;
+  }
+
+  return i + AsciiPrefixSSE2(src + i, len - i);
+}
+
+
+static const CodecKernels avx2_kernels = {
+  "avx2",
+  Base64EncodeAVX2,
+  Base64DecodeAVX2,
+  HexEncodeSSE2,
+  HexDecodeSSE2,
+  AsciiPrefixAVX2
+};
+
+
+static bool CpuHasAVX2() {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+
+  // The OS must save the YMM registers: OSXSAVE and AVX, then XCR0.
+  if ((ecx & (1 << 27)) == 0 || (ecx & (1 << 28)) == 0) return false;
+
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"  // xgetbv
+                       : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+  if ((xcr0_lo & 6) != 6) return false;
+
+  if (__get_cpuid_max(0, NULL) < 7) return false;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  return (ebx & (1 << 5)) != 0;
+}
+
+#endif  // NODE_CODEC_AVX2
+
+
+static const CodecKernels* kernels = &scalar_kernels;
+
+
+void Codec::Initialize() {
+#ifdef NODE_CODEC_SSE2
+  kernels = &sse2_kernels;
+#endif
+#ifdef NODE_CODEC_AVX2
+  if (CpuHasAVX2()) kernels = &avx2_kernels;
+#endif
+}
+
+
+const char* Codec::Kernel() {
+  return kernels->name;
+}
+
+
+size_t Codec::Base64Encode(const char* src, size_t len, char* dst) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+  size_t i = kernels->base64_encode(in, len, dst);
+  char* out = dst + i / 3 * 4;
+
+  if (i < len) {
+    uint8_t a = in[i];
+    uint8_t b = i + 1 < len ? in[i + 1] : 0;
+
+    *out++ = base64_table[a >> 2];
+    *out++ = base64_table[((a & 0x03) << 4) | (b >> 4)];
+    *out++ = i + 1 < len ? base64_table[(b & 0x0F) << 2] : '=';
+    *out++ = '=';
+  }
+
+  assert((size_t)(out - dst) == Base64EncodedSize(len));
+  return out - dst;
+}
+
+
+size_t Codec::Base64Decode(const char* src, size_t len,
+                           char* dst, size_t dstlen) {
+  const char* end = src + len;
+  uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+  uint8_t* out_end = out + dstlen;
+
+  for (;;) {
+    // Fast path over runs of clean 4 character groups.
+    size_t consumed = kernels->base64_decode(src, end - src,
+                                             out, out_end - out);
+    src += consumed;
+    out += consumed / 4 * 3;
+
+    // Slow path: collect one group, skipping anything outside the alphabet.
+    // Padding ends the data; nothing after the first '=' is decoded.
+    int sextets[4];
+    int n = 0;
+    while (n < 4 && src < end) {
+      if (*src == '=') {
+        src = end;
+        break;
+      }
+      int v = unbase64(*src++);
+      if (v >= 0) sextets[n++] = v;
+    }
+
+    if (n >= 2 && out < out_end) {
+      *out++ = (sextets[0] << 2) | (sextets[1] >> 4);
+    }
+    if (n >= 3 && out < out_end) {
+      *out++ = ((sextets[1] & 0x0F) << 4) | (sextets[2] >> 2);
+    }
+    if (n == 4 && out < out_end) {
+      *out++ = ((sextets[2] & 0x03) << 6) | sextets[3];
+    }
+
+    if (n < 4 || out == out_end) break;
+  }
+
+  return out - reinterpret_cast<uint8_t*>(dst);
+}
+
+
+size_t Codec::HexEncode(const char* src, size_t len, char* dst) {
+  kernels->hex_encode(reinterpret_cast<const uint8_t*>(src), len, dst);
+  return len * 2;
+}
+
+
+ssize_t Codec::HexDecode(const char* src, size_t len,
+                         char* dst, size_t dstlen) {
+  if (len > dstlen * 2) len = dstlen * 2;
+  len &= ~(size_t)1;
+
+  size_t i = kernels->hex_decode(src, len, reinterpret_cast<uint8_t*>(dst));
+  if (i != len) return -1;
+
+  return len / 2;
+}
+
+
+bool Codec::IsAscii(const char* src, size_t len) {
+  return kernels->ascii_prefix(reinterpret_cast<const uint8_t*>(src), len)
+      == len;
+}
+
+
+// Strict validation: no overlong forms, no surrogates, nothing above
+// U+10FFFF. ASCII runs are skipped with the vector kernel.
+bool Codec::IsUtf8(const char* src, size_t len) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+  size_t i = 0;
+
+  while (i < len) {
+    i += kernels->ascii_prefix(s + i, len - i);
+    if (i == len) break;
+
+    uint8_t c = s[i];
+    int n;
+    uint8_t lo = 0x80, hi = 0xBF;  // bounds of the second byte
+
+    if (c >= 0xC2 && c <= 0xDF) {
+      n = 1;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      n = 2;
+      if (c == 0xE0) lo = 0xA0;
+      if (c == 0xED) hi = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      n = 3;
+      if (c == 0xF0) lo = 0x90;
+      if (c == 0xF4) hi = 0x8F;
+    } else {
+      return false;
+    }
+
+    if (len - i <= (size_t)n) return false;
+    if (s[i + 1] < lo || s[i + 1] > hi) return false;
+    for (int k = 2; k <= n; k++) {
+      if ((s[i + k] & 0xC0) != 0x80) return false;
+    }
+
+    i += n + 1;
+  }
+
+  return true;
+}
+
+
+}  // namespace node
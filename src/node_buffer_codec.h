@@ -0,0 +1,49 @@
+#ifndef NODE_BUFFER_CODEC_H_
+#define NODE_BUFFER_CODEC_H_
+
+#include <sys/types.h>
+#include <stddef.h>
+
+namespace node {
+
+/* Byte-level encoders used by Buffer.
+ *
+ * Each routine has a portable scalar implementation plus SSE2 and AVX2
+ * kernels where they pay off. The fastest kernel set supported by the CPU
+ * is picked once at startup (see Codec::Initialize), so callers never have
+ * to care which one runs.
+ */
+class Codec {
+ public:
+  static void Initialize();
+
+  // Name of the kernel set in use: "avx2", "sse2" or "scalar".
+  static const char* Kernel();
+
+  static inline size_t Base64EncodedSize(size_t len) {
+    return (len + 2) / 3 * 4;
+  }
+
+  // Writes Base64EncodedSize(len) characters, padding included.
+  static size_t Base64Encode(const char* src, size_t len, char* dst);
+
+  // Characters outside the base64 alphabet (whitespace, '=') are skipped.
+  // Never writes more than dstlen bytes. Returns bytes written.
+  static size_t Base64Decode(const char* src, size_t len,
+                             char* dst, size_t dstlen);
+
+  // Writes 2 * len lower case hex digits.
+  static size_t HexEncode(const char* src, size_t len, char* dst);
+
+  // Decodes pairs of hex digits. Returns bytes written or -1 if a non hex
+  // character is met. A trailing odd digit is ignored.
+  static ssize_t HexDecode(const char* src, size_t len,
+                           char* dst, size_t dstlen);
+
+  static bool IsAscii(const char* src, size_t len);
+  static bool IsUtf8(const char* src, size_t len);
+};
+
+}  // namespace node
+
+#endif  // NODE_BUFFER_CODEC_H_
@@ -9,6 +9,19 @@
 #include <stdlib.h>
 
 #include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef __MINGW32__
+# include <platform_win32.h> /* GetCurrentThreadId() */
+#endif
+
+#ifdef __POSIX__
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
 
 #if OPENSSL_VERSION_NUMBER >= 0x10000000L
 # define OPENSSL_CONST const
@@ -16,6 +29,12 @@
 # define OPENSSL_CONST
 #endif
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+# define SESSION_ID_CONST const
+#else
+# define SESSION_ID_CONST
+#endif
+
 namespace node {
 namespace crypto {
 
@@ -31,6 +50,277 @@ static Persistent<String> fingerprint_symbol;
 static Persistent<String> name_symbol;
 static Persistent<String> version_symbol;
 static Persistent<String> ext_key_usage_symbol;
+static Persistent<String> want_write_symbol;
+
+
+// SessionCache
+
+#define SESSION_CACHE_MAGIC "nodesc01"
+#define SESSION_CACHE_HEADER 4096
+#define SESSION_SLOT_SIZE 4096
+
+struct SessionCache::Slot {
+  uint32_t id_length;
+  uint32_t data_length;
+  int64_t expires;
+  unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+  unsigned char data[SESSION_SLOT_SIZE - 16 - SSL_MAX_SSL_SESSION_ID_LENGTH];
+};
+
+
+struct SessionCacheHeader {
+  char magic[8];
+  uint32_t slots;
+  uint32_t slot_size;
+};
+
+
+#ifdef __POSIX__
+
+static int LockRange(int fd, int type, off_t start, off_t len) {
+  struct flock fl;
+  memset(&fl, 0, sizeof fl);
+  fl.l_type = type;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = start;
+  fl.l_len = len;
+
+  int r;
+  do {
+    r = fcntl(fd, F_SETLKW, &fl);
+  } while (r == -1 && errno == EINTR);
+  return r;
+}
+
+
+// Every cache open in this process, one per file.
+static SessionCache* open_caches = NULL;
+
+
+SessionCache* SessionCache::Open(const char* path, uint32_t slots) {
+  // Looked up before opening: closing a second descriptor of the file
+  // would drop the locks the open instance holds.
+  struct stat st;
+  if (stat(path, &st) == 0) {
+    for (SessionCache* c = open_caches; c != NULL; c = c->next_) {
+      if (c->dev_ != st.st_dev || c->ino_ != st.st_ino) continue;
+      if (c->slots_ != slots) {
+        // Resetting the file would pull it from under the other user.
+        errno = EBUSY;
+        return NULL;
+      }
+      c->refs_++;
+      return c;
+    }
+  }
+
+  int fd = open(path, O_RDWR | O_CREAT, 0600);
+  if (fd == -1) return NULL;
+
+  if (fstat(fd, &st) == -1) {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return NULL;
+  }
+
+  size_t size = SESSION_CACHE_HEADER + (size_t) slots * SESSION_SLOT_SIZE;
+
+  // The first process to get here lays the file out; the others find the
+  // header already written. A file with a different geometry is reset.
+  if (LockRange(fd, F_WRLCK, 0, SESSION_CACHE_HEADER) == -1) {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return NULL;
+  }
+
+  SessionCacheHeader header;
+  ssize_t n = pread(fd, &header, sizeof header, 0);
+  bool valid = n == (ssize_t) sizeof header &&
+               memcmp(header.magic, SESSION_CACHE_MAGIC, 8) == 0 &&
+               header.slots == slots &&
+               header.slot_size == SESSION_SLOT_SIZE;
+
+  if (!valid) {
+    memcpy(header.magic, SESSION_CACHE_MAGIC, 8);
+    header.slots = slots;
+    header.slot_size = SESSION_SLOT_SIZE;
+    // Truncating to zero first leaves every slot zero filled (empty).
+    if (ftruncate(fd, 0) == -1 ||
+        ftruncate(fd, size) == -1 ||
+        pwrite(fd, &header, sizeof header, 0) != (ssize_t) sizeof header) {
+      int saved = errno;
+      close(fd);
+      errno = saved;
+      return NULL;
+    }
+  }
+
+  void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  LockRange(fd, F_UNLCK, 0, SESSION_CACHE_HEADER);
+
+  if (base == MAP_FAILED) {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return NULL;
+  }
+
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+  SessionCache* cache = new SessionCache();
+  cache->fd_ = fd;
+  cache->base_ = static_cast<char*>(base);
+  cache->size_ = size;
+  cache->slots_ = slots;
+  cache->dev_ = st.st_dev;
+  cache->ino_ = st.st_ino;
+  cache->next_ = open_caches;
+  open_caches = cache;
+  return cache;
+}
+
+
+// Open() and Release() only run on the main thread.
+void SessionCache::Release() {
+  if (--refs_ > 0) return;
+
+  for (SessionCache** p = &open_caches; *p != NULL; p = &(*p)->next_) {
+    if (*p == this) {
+      *p = next_;
+      break;
+    }
+  }
+
+  delete this;
+}
+
+
+SessionCache::~SessionCache() {
+  if (base_) munmap(base_, size_);
+  if (fd_ >= 0) close(fd_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+
+SessionCache::Slot* SessionCache::Lock(const unsigned char* id,
+                                       unsigned int length,
+                                       off_t* offset) {
+  // FNV-1a
+  uint32_t h = 2166136261U;
+  for (unsigned int i = 0; i < length; i++) {
+    h ^= id[i];
+    h *= 16777619U;
+  }
+
+  *offset = SESSION_CACHE_HEADER + (off_t) (h % slots_) * SESSION_SLOT_SIZE;
+
+  // fcntl() locks do not exclude other threads of this process.
+  pthread_mutex_lock(&mutex_);
+  if (LockRange(fd_, F_WRLCK, *offset, SESSION_SLOT_SIZE) == -1) {
+    pthread_mutex_unlock(&mutex_);
+    return NULL;
+  }
+  return reinterpret_cast<Slot*>(base_ + *offset);
+}
+
+
+void SessionCache::Unlock(off_t offset) {
+  LockRange(fd_, F_UNLCK, offset, SESSION_SLOT_SIZE);
+  pthread_mutex_unlock(&mutex_);
+}
+
+
+void SessionCache::Put(SSL_SESSION* sess) {
+  unsigned int id_length;
+  const unsigned char* id = SSL_SESSION_get_id(sess, &id_length);
+  if (id_length == 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH) return;
+
+  int data_length = i2d_SSL_SESSION(sess, NULL);
+  // Sessions carrying a large peer certificate chain are not shared.
+  if (data_length <= 0 || data_length > (int) sizeof(((Slot*) 0)->data)) {
+    return;
+  }
+
+  off_t offset;
+  Slot* slot = Lock(id, id_length, &offset);
+  if (slot == NULL) return;
+
+  unsigned char* p = slot->data;
+  i2d_SSL_SESSION(sess, &p);
+  memcpy(slot->id, id, id_length);
+  slot->id_length = id_length;
+  slot->data_length = data_length;
+  slot->expires = (int64_t) SSL_SESSION_get_time(sess) +
+                  SSL_SESSION_get_timeout(sess);
+
+  Unlock(offset);
+}
+
+
+SSL_SESSION* SessionCache::Get(const unsigned char* id, int length) {
+  if (length <= 0 || length > SSL_MAX_SSL_SESSION_ID_LENGTH) return NULL;
+
+  off_t offset;
+  Slot* slot = Lock(id, length, &offset);
+  if (slot == NULL) return NULL;
+
+  SSL_SESSION* sess = NULL;
+
+  if (slot->id_length == (uint32_t) length &&
+      memcmp(slot->id, id, length) == 0) {
+    if (slot->expires > (int64_t) time(NULL)) {
+      const unsigned char* p = slot->data;
+      sess = d2i_SSL_SESSION(NULL, &p, slot->data_length);
+    } else {
+      slot->id_length = 0;
+    }
+  }
+
+  Unlock(offset);
+  return sess;
+}
+
+
+void SessionCache::Remove(SSL_SESSION* sess) {
+  unsigned int id_length;
+  const unsigned char* id = SSL_SESSION_get_id(sess, &id_length);
+  if (id_length == 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH) return;
+
+  off_t offset;
+  Slot* slot = Lock(id, id_length, &offset);
+  if (slot == NULL) return;
+
+  if (slot->id_length == id_length && memcmp(slot->id, id, id_length) == 0) {
+    slot->id_length = 0;
+  }
+
+  Unlock(offset);
+}
+
+#else  // __MINGW32__
+
+SessionCache* SessionCache::Open(const char* path, uint32_t slots) {
+  errno = ENOSYS;
+  return NULL;
+}
+
+void SessionCache::Release() {
+  if (--refs_ == 0) delete this;
+}
+
+SessionCache::~SessionCache() {
+  pthread_mutex_destroy(&mutex_);
+}
+
+void SessionCache::Put(SSL_SESSION* sess) { }
+SSL_SESSION* SessionCache::Get(const unsigned char* id, int length) {
+  return NULL;
+}
+void SessionCache::Remove(SSL_SESSION* sess) { }
+
+#endif  // __POSIX__
 
 
 void SecureContext::Initialize(Handle<Object> target) {
@@ -47,6 +337,13 @@ void SecureContext::Initialize(Handle<Object> target) {
   NODE_SET_PROTOTYPE_METHOD(t, "addCRL", SecureContext::AddCRL);
   NODE_SET_PROTOTYPE_METHOD(t, "addRootCerts", SecureContext::AddRootCerts);
   NODE_SET_PROTOTYPE_METHOD(t, "setCiphers", SecureContext::SetCiphers);
+  NODE_SET_PROTOTYPE_METHOD(t, "setSessionIdContext",
+                            SecureContext::SetSessionIdContext);
+  NODE_SET_PROTOTYPE_METHOD(t, "setSessionTimeout",
+                            SecureContext::SetSessionTimeout);
+  NODE_SET_PROTOTYPE_METHOD(t, "setSessionCache",
+                            SecureContext::SetSessionCache);
+  NODE_SET_PROTOTYPE_METHOD(t, "setTicketKeys", SecureContext::SetTicketKeys);
   NODE_SET_PROTOTYPE_METHOD(t, "close", SecureContext::Close);
 
   target->Set(String::NewSymbol("SecureContext"), t->GetFunction());
@@ -107,6 +404,9 @@ Handle<Value> SecureContext::Init(const Arguments& args) {
 
   sc->ca_store_ = X509_STORE_new();
   SSL_CTX_set_cert_store(sc->ctx_, sc->ca_store_);
+
+  // Lets the session cache callbacks find their way back to us.
+  SSL_CTX_set_app_data(sc->ctx_, sc);
   return True();
 }
 
@@ -382,15 +682,154 @@ Handle<Value> SecureContext::SetCiphers(const Arguments& args) {
 }
 
 
+Handle<Value> SecureContext::SetSessionIdContext(const Arguments& args) {
+  HandleScope scope;
+
+  SecureContext *sc = ObjectWrap::Unwrap<SecureContext>(args.Holder());
+
+  if (args.Length() != 1 || !args[0]->IsString()) {
+    return ThrowException(Exception::TypeError(String::New("Bad parameter")));
+  }
+
+  String::Utf8Value sid_ctx(args[0]->ToString());
+  int len = sid_ctx.length();
+  if (len > SSL_MAX_SID_CTX_LENGTH) len = SSL_MAX_SID_CTX_LENGTH;
+
+  if (!SSL_CTX_set_session_id_context(sc->ctx_,
+                                      (const unsigned char*) *sid_ctx,
+                                      len)) {
+    return ThrowException(Exception::Error(
+          String::New("Failed to set the session id context")));
+  }
+
+  return True();
+}
+
+
+Handle<Value> SecureContext::SetSessionTimeout(const Arguments& args) {
+  HandleScope scope;
+
+  SecureContext *sc = ObjectWrap::Unwrap<SecureContext>(args.Holder());
+
+  if (args.Length() != 1 || !args[0]->IsInt32()) {
+    return ThrowException(Exception::TypeError(String::New("Bad parameter")));
+  }
+
+  SSL_CTX_set_timeout(sc->ctx_, args[0]->Int32Value());
+
+  return True();
+}
+
+
+// Session cache callbacks. OpenSSL keeps using its own in-process cache as
+// the first level; these only run on a miss there.
+
+static int NewSessionCallback(SSL *ssl, SSL_SESSION *sess) {
+  SecureContext *sc = static_cast<SecureContext*>(
+      SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  if (sc && sc->session_cache_) sc->session_cache_->Put(sess);
+  // We did not keep a reference to sess.
+  return 0;
+}
+
+
+static SSL_SESSION* GetSessionCallback(SSL *ssl,
+                                       SESSION_ID_CONST unsigned char *id,
+                                       int length,
+                                       int *copy) {
+  SecureContext *sc = static_cast<SecureContext*>(
+      SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  // The session comes straight from d2i_SSL_SESSION(); OpenSSL owns the
+  // only reference.
+  *copy = 0;
+  if (!sc || !sc->session_cache_) return NULL;
+  return sc->session_cache_->Get(id, length);
+}
+
+
+static void RemoveSessionCallback(SSL_CTX *ctx, SSL_SESSION *sess) {
+  SecureContext *sc = static_cast<SecureContext*>(SSL_CTX_get_app_data(ctx));
+  if (sc && sc->session_cache_) sc->session_cache_->Remove(sess);
+}
+
+
+// context.setSessionCache(path, [slots])
+Handle<Value> SecureContext::SetSessionCache(const Arguments& args) {
+  HandleScope scope;
+
+  SecureContext *sc = ObjectWrap::Unwrap<SecureContext>(args.Holder());
+
+  if (args.Length() < 1 || !args[0]->IsString()) {
+    return ThrowException(Exception::TypeError(String::New("Bad parameter")));
+  }
+
+  uint32_t slots = 1024;
+  if (args.Length() > 1 && args[1]->IsUint32()) slots = args[1]->Uint32Value();
+  if (slots == 0) {
+    return ThrowException(Exception::RangeError(
+          String::New("Session cache needs at least one slot")));
+  }
+
+  String::Utf8Value path(args[0]->ToString());
+  SessionCache *cache = SessionCache::Open(*path, slots);
+  if (cache == NULL) return ThrowException(ErrnoException(errno, "open"));
+
+  if (sc->session_cache_) sc->session_cache_->Release();
+  sc->session_cache_ = cache;
+
+  SSL_CTX_sess_set_new_cb(sc->ctx_, NewSessionCallback);
+  SSL_CTX_sess_set_get_cb(sc->ctx_, GetSessionCallback);
+  SSL_CTX_sess_set_remove_cb(sc->ctx_, RemoveSessionCallback);
+
+  return True();
+}
+
+
+// context.setTicketKeys(buffer)
+// 48 bytes: 16 byte key name, 16 byte HMAC secret, 16 byte AES key. Every
+// process given the same keys accepts the others' session tickets.
+Handle<Value> SecureContext::SetTicketKeys(const Arguments& args) {
+  HandleScope scope;
+
+  SecureContext *sc = ObjectWrap::Unwrap<SecureContext>(args.Holder());
+
+  if (args.Length() != 1 || !Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(
+          String::New("Ticket keys must be a buffer")));
+  }
+
+  Local<Object> keys = args[0]->ToObject();
+  if (Buffer::Length(keys) != 48) {
+    return ThrowException(Exception::RangeError(
+          String::New("Ticket keys must be 48 bytes long")));
+  }
+
+#ifdef SSL_CTRL_SET_TLSEXT_TICKET_KEYS
+  if (SSL_CTX_set_tlsext_ticket_keys(sc->ctx_, Buffer::Data(keys), 48) != 1) {
+    return ThrowException(Exception::Error(
+          String::New("Failed to set ticket keys")));
+  }
+  return True();
+#else
+  return ThrowException(Exception::Error(
+        String::New("OpenSSL was built without session ticket support")));
+#endif
+}
+
+
 Handle<Value> SecureContext::Close(const Arguments& args) {
   HandleScope scope;
 
   SecureContext *sc = ObjectWrap::Unwrap<SecureContext>(args.Holder());
 
   if (sc->ctx_ != NULL) {
+    // Keep the flushed sessions in the shared cache, see ~SecureContext().
+    SSL_CTX_sess_set_remove_cb(sc->ctx_, NULL);
     SSL_CTX_free(sc->ctx_);
     sc->ctx_ = NULL;
     sc->ca_store_ = NULL;
+    if (sc->session_cache_) sc->session_cache_->Release();
+    sc->session_cache_ = NULL;
     return True();
   }
 
@@ -510,6 +949,14 @@ void Connection::Initialize(Handle<Object> target) {
   NODE_SET_PROTOTYPE_METHOD(t, "shutdown", Connection::Shutdown);
   NODE_SET_PROTOTYPE_METHOD(t, "receivedShutdown", Connection::ReceivedShutdown);
   NODE_SET_PROTOTYPE_METHOD(t, "close", Connection::Close);
+  NODE_SET_PROTOTYPE_METHOD(t, "getSession", Connection::GetSession);
+  NODE_SET_PROTOTYPE_METHOD(t, "setSession", Connection::SetSession);
+  NODE_SET_PROTOTYPE_METHOD(t, "isSessionReused", Connection::IsSessionReused);
+  NODE_SET_PROTOTYPE_METHOD(t, "handshake", Connection::HandshakeAsync);
+  NODE_SET_PROTOTYPE_METHOD(t, "setFd", Connection::SetFd);
+  NODE_SET_PROTOTYPE_METHOD(t, "readFd", Connection::ReadFd);
+  NODE_SET_PROTOTYPE_METHOD(t, "writeFd", Connection::WriteFd);
+  NODE_SET_PROTOTYPE_METHOD(t, "handshakeFd", Connection::HandshakeFd);
 
   target->Set(String::NewSymbol("Connection"), t->GetFunction());
 }
@@ -714,6 +1161,11 @@ Handle<Value> Connection::ClearPending(const Arguments& args) {
 
   Connection *ss = Connection::Unwrap(args);
 
+  // In native mode, the decrypted bytes OpenSSL holds on to.
+  if (ss->fd_mode_) {
+    int bytes_pending = ss->ssl_ ? SSL_pending(ss->ssl_) : 0;
+    return scope.Close(Integer::New(bytes_pending));
+  }
   int bytes_pending = BIO_pending(ss->bio_read_);
   return scope.Close(Integer::New(bytes_pending));
 }
@@ -724,6 +1176,7 @@ Handle<Value> Connection::EncPending(const Arguments& args) {
 
   Connection *ss = Connection::Unwrap(args);
 
+  if (ss->fd_mode_) return scope.Close(Integer::New(0));
   int bytes_pending = BIO_pending(ss->bio_write_);
   return scope.Close(Integer::New(bytes_pending));
 }
@@ -1118,11 +1571,83 @@ Handle<Value> Connection::GetCurrentCipher(const Arguments& args) {
   return scope.Close(info);
 }
 
+
+// Client side session resumption: getSession() after the handshake,
+// setSession() on a new connection to the same server before it starts.
+Handle<Value> Connection::GetSession(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (ss->ssl_ == NULL) return Undefined();
+
+  SSL_SESSION* sess = SSL_get_session(ss->ssl_);
+  if (sess == NULL) return Undefined();
+
+  int slen = i2d_SSL_SESSION(sess, NULL);
+  if (slen <= 0) return Undefined();
+
+  Buffer* buf = Buffer::New(slen);
+  unsigned char* p = reinterpret_cast<unsigned char*>(Buffer::Data(buf));
+  i2d_SSL_SESSION(sess, &p);
+
+  return scope.Close(buf->handle_);
+}
+
+
+Handle<Value> Connection::SetSession(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (args.Length() < 1 || !Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(
+          String::New("Session must be a buffer")));
+  }
+
+  if (ss->ssl_ == NULL) return False();
+
+  Local<Object> buf = args[0]->ToObject();
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(Buffer::Data(buf));
+  SSL_SESSION* sess = d2i_SSL_SESSION(NULL, &p, Buffer::Length(buf));
+  if (sess == NULL) return False();
+
+  int r = SSL_set_session(ss->ssl_, sess);
+  SSL_SESSION_free(sess);
+
+  if (!r) {
+    return ThrowException(Exception::Error(
+          String::New("SSL_set_session error")));
+  }
+
+  return True();
+}
+
+
+Handle<Value> Connection::IsSessionReused(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (ss->ssl_ == NULL || SSL_session_reused(ss->ssl_) == 0) {
+    return False();
+  }
+
+  return True();
+}
+
 Handle<Value> Connection::Close(const Arguments& args) {
   HandleScope scope;
 
   Connection *ss = Connection::Unwrap(args);
 
+  // A handshake step still owns the SSL object; AfterHandshake frees it.
+  if (ss->busy_) {
+    ss->close_pending_ = true;
+    return True();
+  }
+
   if (ss->ssl_ != NULL) {
     SSL_free(ss->ssl_);
     ss->ssl_ = NULL;
@@ -1131,6 +1656,313 @@ Handle<Value> Connection::Close(const Arguments& args) {
 }
 
 
+// Asynchronous handshake
+//
+// SSL_accept()/SSL_connect() are where the private key operations of a
+// handshake happen: a 2048 bit RSA decrypt costs milliseconds, during which
+// the event loop would otherwise serve nobody. In memory BIO mode the SSL
+// object touches nothing but its own buffers, so the step can run on the
+// eio pool while JS holds off on the connection.
+
+struct handshake_request {
+  Connection* conn;
+  Persistent<Function> cb;
+  int rv;
+  int err;
+  unsigned long ssl_err;
+};
+
+
+int Connection::EIO_Handshake(eio_req* req) {
+  handshake_request* hr = static_cast<handshake_request*>(req->data);
+  Connection* ss = hr->conn;
+
+  hr->rv = ss->is_server_ ? SSL_accept(ss->ssl_) : SSL_connect(ss->ssl_);
+  hr->err = hr->rv < 0 ? SSL_get_error(ss->ssl_, hr->rv) : SSL_ERROR_NONE;
+  // The error queue is per thread; carry the reason back with us.
+  hr->ssl_err = ERR_get_error();
+  ERR_clear_error();
+
+  return 0;
+}
+
+
+int Connection::AfterHandshake(eio_req* req) {
+  ev_unref(EV_DEFAULT_UC);
+
+  HandleScope scope;
+
+  handshake_request* hr = static_cast<handshake_request*>(req->data);
+  Connection* ss = hr->conn;
+
+  ss->busy_ = false;
+
+  if (ss->close_pending_) {
+    ss->close_pending_ = false;
+    SSL_free(ss->ssl_);
+    ss->ssl_ = NULL;
+  } else if (hr->err != SSL_ERROR_NONE &&
+             hr->err != SSL_ERROR_WANT_READ &&
+             hr->err != SSL_ERROR_WANT_WRITE) {
+    char ssl_error_buf[512];
+    if (hr->ssl_err) {
+      ERR_error_string_n(hr->ssl_err, ssl_error_buf, sizeof(ssl_error_buf));
+    } else {
+      // Nothing was queued; hr->err is an SSL_ERROR_* code, not a
+      // packed error, so say what we know instead of decoding it.
+      snprintf(ssl_error_buf, sizeof(ssl_error_buf),
+               "%s failed (SSL_get_error() returned %d)",
+               ss->is_server_ ? "SSL_accept" : "SSL_connect", hr->err);
+    }
+    ss->handle_->Set(String::New("error"),
+                     Exception::Error(String::New(ssl_error_buf)));
+    DEBUG_PRINT("[%p] SSL: handshake failed: (%d:%d) %s\n",
+                ss->ssl_, hr->err, hr->rv, ssl_error_buf);
+  }
+
+  if (ss->ssl_ != NULL) ss->SetShutdownFlags();
+
+  TryCatch try_catch;
+
+  hr->cb->Call(ss->handle_, 0, NULL);
+
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+
+  hr->cb.Dispose();
+  ss->Unref();
+  delete hr;
+
+  return 0;
+}
+
+
+// connection.handshake(callback)
+// Returns false, without calling back, if the handshake is already done.
+Handle<Value> Connection::HandshakeAsync(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (!args[0]->IsFunction()) {
+    return ThrowException(Exception::TypeError(
+          String::New("First argument must be a callback")));
+  }
+
+  if (ss->busy_) {
+    return ThrowException(Exception::Error(
+          String::New("Handshake already in progress")));
+  }
+
+  if (ss->ssl_ == NULL || ss->fd_mode_ || SSL_is_init_finished(ss->ssl_)) {
+    return False();
+  }
+
+  handshake_request* hr = new handshake_request;
+  hr->conn = ss;
+  hr->cb = Persistent<Function>::New(Local<Function>::Cast(args[0]));
+
+  ss->busy_ = true;
+  ss->Ref();
+
+  eio_custom(EIO_Handshake, EIO_PRI_DEFAULT, AfterHandshake, hr);
+  ev_ref(EV_DEFAULT_UC);
+
+  return True();
+}
+
+
+// Native mode
+//
+// Instead of shuttling records through the memory BIOs and the
+// CryptoStream pump in lib/tls.js, the SSL object is bound to the socket
+// fd and the net.Socket read/write implementation calls readFd()/writeFd()
+// directly. JS only ever sees cleartext.
+//
+// The calls follow the net binding conventions: a byte count, 0 on end of
+// stream, null when the operation would block (check the 'wantWrite'
+// property to know whether to wait for the fd to become writable or
+// readable) and an exception on errors.
+
+
+Handle<Value> Connection::HandleFdResult(const char* func, int rv) {
+  HandleScope scope;
+
+  int err = SSL_get_error(ssl_, rv);
+
+  switch (err) {
+    case SSL_ERROR_WANT_WRITE:
+      handle_->Set(want_write_symbol, True());
+      return scope.Close(Null());
+
+    case SSL_ERROR_WANT_READ:
+      handle_->Set(want_write_symbol, False());
+      return scope.Close(Null());
+
+    case SSL_ERROR_ZERO_RETURN:
+      SetShutdownFlags();
+      return scope.Close(Integer::New(0));
+
+    case SSL_ERROR_SYSCALL:
+      if (ERR_peek_error() == 0) {
+        // rv == 0 is an EOF that violates the protocol; treat it like the
+        // peer closing the connection.
+        if (rv == 0) return scope.Close(Integer::New(0));
+        if (errno == EAGAIN || errno == EINTR) {
+          handle_->Set(want_write_symbol, False());
+          return scope.Close(Null());
+        }
+        return ThrowException(ErrnoException(errno, func));
+      }
+      // fall through
+
+    default: {
+      static char ssl_error_buf[512];
+      ERR_error_string_n(ERR_get_error(), ssl_error_buf,
+                         sizeof(ssl_error_buf));
+      ERR_clear_error();
+
+      DEBUG_PRINT("[%p] SSL: %s failed: (%d:%d) %s\n", ssl_, func, err, rv,
+                  ssl_error_buf);
+
+      return ThrowException(Exception::Error(String::New(ssl_error_buf)));
+    }
+  }
+}
+
+
+// ssl.setFd(fd)
+// Binds the connection to a socket. Must be called before any data has
+// gone through encIn/encOut.
+Handle<Value> Connection::SetFd(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (!args[0]->IsInt32()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Bad file descriptor argument")));
+  }
+
+  if (ss->ssl_ == NULL) {
+    return ThrowException(Exception::Error(
+          String::New("Connection is closed")));
+  }
+
+  // Replaces (and frees) the memory BIOs with a socket BIO that does not
+  // own the fd; net.Socket still closes it.
+  if (!SSL_set_fd(ss->ssl_, args[0]->Int32Value())) {
+    return ThrowException(Exception::Error(
+          String::New("SSL_set_fd failed")));
+  }
+
+  ss->bio_read_ = ss->bio_write_ = NULL;
+  ss->fd_mode_ = true;
+
+  // net.Socket retries a short write from a different slice of its queue.
+  SSL_set_mode(ss->ssl_, SSL_get_mode(ss->ssl_) |
+                         SSL_MODE_ENABLE_PARTIAL_WRITE |
+                         SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+  return True();
+}
+
+
+// ssl.handshakeFd()
+// Returns 1 once the handshake is complete, null while it is in progress.
+Handle<Value> Connection::HandshakeFd(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  if (ss->ssl_ == NULL || !ss->fd_mode_) {
+    return ThrowException(Exception::Error(
+          String::New("Connection is not bound to a socket")));
+  }
+
+  if (SSL_is_init_finished(ss->ssl_)) return scope.Close(Integer::New(1));
+
+  int rv = SSL_do_handshake(ss->ssl_);
+  if (rv > 0) return scope.Close(Integer::New(1));
+
+  return scope.Close(ss->HandleFdResult("SSL_do_handshake", rv));
+}
+
+
+#define FD_MODE_BUFFER_ARGS(args)                                     \
+  if (ss->ssl_ == NULL || !ss->fd_mode_) {                            \
+    return ThrowException(Exception::Error(                           \
+          String::New("Connection is not bound to a socket")));       \
+  }                                                                   \
+  if (!Buffer::HasInstance(args[0])) {                                \
+    return ThrowException(Exception::TypeError(                       \
+          String::New("First argument should be a buffer")));         \
+  }                                                                   \
+  Local<Object> buffer_obj = args[0]->ToObject();                     \
+  char *buffer_data = Buffer::Data(buffer_obj);                       \
+  size_t buffer_length = Buffer::Length(buffer_obj);                  \
+  size_t off = args[1]->Uint32Value();                                \
+  size_t len = args[2]->Uint32Value();                                \
+  if (off > buffer_length || off + len > buffer_length) {             \
+    return ThrowException(Exception::Error(                           \
+          String::New("Length is extends beyond buffer")));           \
+  }
+
+
+// ssl.readFd(buffer, offset, length)
+// SSL_read() from the socket, driving the handshake first if needed.
+// SSL_read() returns at most one record; records already decrypted inside
+// OpenSSL are read as well while there is room. Whatever still does not
+// fit is reported by clearPending().
+Handle<Value> Connection::ReadFd(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  FD_MODE_BUFFER_ARGS(args)
+
+  if (len == 0) return scope.Close(Null());
+
+  size_t total = 0;
+  for (;;) {
+    int rv = SSL_read(ss->ssl_, buffer_data + off + total, len - total);
+    if (rv <= 0) {
+      if (total == 0) return scope.Close(ss->HandleFdResult("SSL_read", rv));
+      // Hand out what we have; the condition comes back on the next call.
+      ERR_clear_error();
+      break;
+    }
+    total += rv;
+    if (total == len || SSL_pending(ss->ssl_) == 0) break;
+  }
+
+  return scope.Close(Integer::New(total));
+}
+
+
+// ssl.writeFd(buffer, offset, length)
+// SSL_write() to the socket. Partial writes are enabled, so the result may
+// be less than length.
+Handle<Value> Connection::WriteFd(const Arguments& args) {
+  HandleScope scope;
+
+  Connection *ss = Connection::Unwrap(args);
+
+  FD_MODE_BUFFER_ARGS(args)
+
+  // SSL_write() with 0 bytes is undefined.
+  if (len == 0) return scope.Close(Integer::New(0));
+
+  int rv = SSL_write(ss->ssl_, buffer_data + off, len);
+  if (rv > 0) return scope.Close(Integer::New(rv));
+
+  return scope.Close(ss->HandleFdResult("SSL_write", rv));
+}
+
+#undef FD_MODE_BUFFER_ARGS
+
+
 static void HexEncode(unsigned char *md_value,
                       int md_len,
                       char** md_hexdigest,
@@ -1312,6 +2144,155 @@ int local_EVP_DecryptFinal_ex(EVP_CIPHER_CTX *ctx,
 }
 
 
+// Buffer-in/Buffer-out support shared by Cipher, Decipher, Hmac and Hash.
+//
+// The *Into() methods take the input as a (buffer, [offset], [length])
+// range and write the result straight into a caller supplied (buffer,
+// offset), so neither side goes through a 'binary' string or a temporary
+// copy. Given a trailing callback the work runs on the eio thread pool;
+// the object refuses other calls until the callback has fired.
+
+// Reads a (buffer, [offset], [length]) range starting at args[i]. Length
+// defaults to the rest of the buffer.
+static bool GetBufferRange(const Arguments& args, int i,
+                           char** data, size_t* length) {
+  if (!Buffer::HasInstance(args[i])) return false;
+
+  Local<Object> buffer_obj = args[i]->ToObject();
+  size_t buffer_length = Buffer::Length(buffer_obj);
+
+  size_t off = args[i + 1]->IsNumber() ? args[i + 1]->Uint32Value() : 0;
+  if (off > buffer_length) return false;
+
+  size_t len = args[i + 2]->IsNumber() ? args[i + 2]->Uint32Value()
+                                       : buffer_length - off;
+  if (len > buffer_length - off) return false;
+
+  *data = Buffer::Data(buffer_obj) + off;
+  *length = len;
+  return true;
+}
+
+
+// Room left in the output buffer args[i] after the offset args[i + 1].
+static bool GetOutputRange(const Arguments& args, int i,
+                           char** data, size_t* room) {
+  if (!Buffer::HasInstance(args[i])) return false;
+
+  Local<Object> buffer_obj = args[i]->ToObject();
+  size_t buffer_length = Buffer::Length(buffer_obj);
+
+  size_t off = args[i + 1]->IsNumber() ? args[i + 1]->Uint32Value() : 0;
+  if (off > buffer_length) return false;
+
+  *data = Buffer::Data(buffer_obj) + off;
+  *room = buffer_length - off;
+  return true;
+}
+
+
+struct update_request {
+  int (*work)(update_request* ur);
+  void* self;
+  bool* pending;
+  char* in;
+  int in_len;
+  unsigned char* out;
+  int out_len;
+  int r;
+  Persistent<Object> handle;  // the crypto object
+  Persistent<Value> input;    // keeps the Buffers alive
+  Persistent<Value> output;
+  Persistent<Function> cb;
+};
+
+
+static int EIO_Update(eio_req* req) {
+  update_request* ur = static_cast<update_request*>(req->data);
+  ur->r = ur->work(ur);
+  return 0;
+}
+
+
+static int AfterUpdate(eio_req* req) {
+  ev_unref(EV_DEFAULT_UC);
+
+  HandleScope scope;
+
+  update_request* ur = static_cast<update_request*>(req->data);
+  *ur->pending = false;
+
+  Local<Value> argv[2];
+
+  if (ur->r) {
+    argv[0] = Local<Value>::New(Null());
+    argv[1] = Integer::New(ur->out_len);
+  } else {
+    argv[0] = Exception::Error(String::New("Update failed"));
+    argv[1] = Local<Value>::New(Undefined());
+  }
+
+  TryCatch try_catch;
+
+  ur->cb->Call(ur->handle, 2, argv);
+
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+
+  ur->handle.Dispose();
+  ur->input.Dispose();
+  ur->output.Dispose();
+  ur->cb.Dispose();
+  delete ur;
+
+  return 0;
+}
+
+
+// Queues ur->work() on the thread pool. The input Buffer is args[0], the
+// callback the last argument.
+static Handle<Value> QueueUpdate(const Arguments& args,
+                                 update_request* ur,
+                                 Handle<Value> output) {
+  ur->handle = Persistent<Object>::New(args.This());
+  ur->input = Persistent<Value>::New(args[0]);
+  ur->output = Persistent<Value>::New(output);
+  ur->cb = Persistent<Function>::New(
+      Local<Function>::Cast(args[args.Length() - 1]));
+  ur->out_len = 0;
+  *ur->pending = true;
+
+  eio_custom(EIO_Update, EIO_PRI_DEFAULT, AfterUpdate, ur);
+  ev_ref(EV_DEFAULT_UC);
+
+  return Undefined();
+}
+
+
+static inline bool HasCallback(const Arguments& args) {
+  return args.Length() > 0 && args[args.Length() - 1]->IsFunction();
+}
+
+
+static Handle<Value> ThrowBusy() {
+  return ThrowException(Exception::Error(
+        String::New("An asynchronous operation is in progress")));
+}
+
+
+static Handle<Value> ThrowBadRange() {
+  return ThrowException(Exception::RangeError(
+        String::New("Bad buffer, offset or length")));
+}
+
+
+static Handle<Value> ThrowNoRoom() {
+  return ThrowException(Exception::RangeError(
+        String::New("Output buffer is too small")));
+}
+
+
 class Cipher : public ObjectWrap {
  public:
   static void Initialize (v8::Handle<v8::Object> target) {
@@ -1325,6 +2306,8 @@ class Cipher : public ObjectWrap {
     NODE_SET_PROTOTYPE_METHOD(t, "initiv", CipherInitIv);
     NODE_SET_PROTOTYPE_METHOD(t, "update", CipherUpdate);
     NODE_SET_PROTOTYPE_METHOD(t, "final", CipherFinal);
+    NODE_SET_PROTOTYPE_METHOD(t, "updateInto", CipherUpdateInto);
+    NODE_SET_PROTOTYPE_METHOD(t, "finalInto", CipherFinalInto);
 
     target->Set(String::NewSymbol("Cipher"), t->GetFunction());
   }
@@ -1379,7 +2362,7 @@ class Cipher : public ObjectWrap {
 
 
   int CipherUpdate(char* data, int len, unsigned char** out, int* out_len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     *out_len=len+EVP_CIPHER_CTX_block_size(&ctx);
     *out= new unsigned char[*out_len];
 
@@ -1388,7 +2371,7 @@ class Cipher : public ObjectWrap {
   }
 
   int CipherFinal(unsigned char** out, int *out_len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     *out = new unsigned char[EVP_CIPHER_CTX_block_size(&ctx)];
     EVP_CipherFinal(&ctx,*out,out_len);
     EVP_CIPHER_CTX_cleanup(&ctx);
@@ -1604,34 +2587,127 @@ class Cipher : public ObjectWrap {
       return scope.Close(String::New(""));
     }
 
-    if (args.Length() == 0 || !args[0]->IsString()) {
-      // Binary
-      outString = Encode(out_value, out_len, BINARY);
-    } else {
-      String::Utf8Value encoding(args[0]->ToString());
-      if (strcasecmp(*encoding, "hex") == 0) {
-        // Hex encoding
-        HexEncode(out_value, out_len, &out_hexdigest, &out_hex_len);
-        outString = Encode(out_hexdigest, out_hex_len, BINARY);
-        delete [] out_hexdigest;
-      } else if (strcasecmp(*encoding, "base64") == 0) {
-        base64(out_value, out_len, &out_hexdigest, &out_hex_len);
-        outString = Encode(out_hexdigest, out_hex_len, BINARY);
-        delete [] out_hexdigest;
-      } else if (strcasecmp(*encoding, "binary") == 0) {
-        outString = Encode(out_value, out_len, BINARY);
-      } else {
-        fprintf(stderr, "node-crypto : Cipher .final encoding "
-                        "can be binary, hex or base64\n");
-      }
+    if (args.Length() == 0 || !args[0]->IsString()) {
+      // Binary
+      outString = Encode(out_value, out_len, BINARY);
+    } else {
+      String::Utf8Value encoding(args[0]->ToString());
+      if (strcasecmp(*encoding, "hex") == 0) {
+        // Hex encoding
+        HexEncode(out_value, out_len, &out_hexdigest, &out_hex_len);
+        outString = Encode(out_hexdigest, out_hex_len, BINARY);
+        delete [] out_hexdigest;
+      } else if (strcasecmp(*encoding, "base64") == 0) {
+        base64(out_value, out_len, &out_hexdigest, &out_hex_len);
+        outString = Encode(out_hexdigest, out_hex_len, BINARY);
+        delete [] out_hexdigest;
+      } else if (strcasecmp(*encoding, "binary") == 0) {
+        outString = Encode(out_value, out_len, BINARY);
+      } else {
+        fprintf(stderr, "node-crypto : Cipher .final encoding "
+                        "can be binary, hex or base64\n");
+      }
+    }
+    delete [] out_value;
+    return scope.Close(outString);
+  }
+
+  // cipher.updateInto(input, inOffset, inLength, output, outOffset, [cb])
+  // Returns the number of bytes written to output, or passes it to cb.
+  // output needs inLength plus one block of room.
+  static Handle<Value> CipherUpdateInto(const Arguments& args) {
+    HandleScope scope;
+
+    Cipher *cipher = ObjectWrap::Unwrap<Cipher>(args.This());
+
+    if (cipher->pending_) return ThrowBusy();
+    if (!cipher->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* in;
+    size_t in_len;
+    char* out;
+    size_t room;
+
+    if (args.Length() < 5 ||
+        !GetBufferRange(args, 0, &in, &in_len) ||
+        !GetOutputRange(args, 3, &out, &room)) {
+      return ThrowBadRange();
+    }
+
+    if (room < in_len + EVP_CIPHER_CTX_block_size(&cipher->ctx)) {
+      return ThrowNoRoom();
+    }
+
+    if (HasCallback(args)) {
+      update_request* ur = new update_request;
+      ur->work = UpdateWork;
+      ur->self = cipher;
+      ur->pending = &cipher->pending_;
+      ur->in = in;
+      ur->in_len = in_len;
+      ur->out = reinterpret_cast<unsigned char*>(out);
+      return QueueUpdate(args, ur, args[3]);
+    }
+
+    int out_len = 0;
+    EVP_CipherUpdate(&cipher->ctx,
+                     reinterpret_cast<unsigned char*>(out),
+                     &out_len,
+                     reinterpret_cast<unsigned char*>(in),
+                     in_len);
+
+    return scope.Close(Integer::New(out_len));
+  }
+
+  static int UpdateWork(update_request* ur) {
+    Cipher* cipher = static_cast<Cipher*>(ur->self);
+    return EVP_CipherUpdate(&cipher->ctx, ur->out, &ur->out_len,
+                            reinterpret_cast<unsigned char*>(ur->in),
+                            ur->in_len);
+  }
+
+  // cipher.finalInto(output, [offset])
+  // Writes the last block; output needs one block of room.
+  static Handle<Value> CipherFinalInto(const Arguments& args) {
+    HandleScope scope;
+
+    Cipher *cipher = ObjectWrap::Unwrap<Cipher>(args.This());
+
+    if (cipher->pending_) return ThrowBusy();
+    if (!cipher->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* out;
+    size_t room;
+
+    if (!GetOutputRange(args, 0, &out, &room)) return ThrowBadRange();
+
+    if (room < (size_t) EVP_CIPHER_CTX_block_size(&cipher->ctx)) {
+      return ThrowNoRoom();
+    }
+
+    int out_len = 0;
+    int r = EVP_CipherFinal(&cipher->ctx,
+                            reinterpret_cast<unsigned char*>(out),
+                            &out_len);
+    EVP_CIPHER_CTX_cleanup(&cipher->ctx);
+    cipher->initialised_ = false;
+
+    if (!r) {
+      return ThrowException(Exception::Error(
+            String::New("CipherFinalInto error")));
     }
-    delete [] out_value;
-    return scope.Close(outString);
+
+    return scope.Close(Integer::New(out_len));
   }
 
   Cipher () : ObjectWrap ()
   {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Cipher ()
@@ -1643,6 +2719,7 @@ class Cipher : public ObjectWrap {
   EVP_CIPHER_CTX ctx; /* coverity[member_decl] */
   const EVP_CIPHER *cipher; /* coverity[member_decl] */
   bool initialised_;
+  bool pending_;
   char* incomplete_base64; /* coverity[member_decl] */
   int incomplete_base64_len; /* coverity[member_decl] */
 
@@ -1665,6 +2742,8 @@ class Decipher : public ObjectWrap {
     NODE_SET_PROTOTYPE_METHOD(t, "initiv", DecipherInitIv);
     NODE_SET_PROTOTYPE_METHOD(t, "update", DecipherUpdate);
     NODE_SET_PROTOTYPE_METHOD(t, "final", DecipherFinal);
+    NODE_SET_PROTOTYPE_METHOD(t, "updateInto", DecipherUpdateInto);
+    NODE_SET_PROTOTYPE_METHOD(t, "finalInto", DecipherFinalInto);
     NODE_SET_PROTOTYPE_METHOD(t, "finaltol", DecipherFinalTolerate);
 
     target->Set(String::NewSymbol("Decipher"), t->GetFunction());
@@ -1734,7 +2813,7 @@ class Decipher : public ObjectWrap {
   }
 
   int DecipherUpdate(char* data, int len, unsigned char** out, int* out_len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     *out_len=len+EVP_CIPHER_CTX_block_size(&ctx);
     *out= new unsigned char[*out_len];
 
@@ -1744,7 +2823,7 @@ class Decipher : public ObjectWrap {
 
   // coverity[alloc_arg]
   int DecipherFinal(unsigned char** out, int *out_len, bool tolerate_padding) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     *out = new unsigned char[EVP_CIPHER_CTX_block_size(&ctx)];
     if (tolerate_padding) {
       local_EVP_DecryptFinal_ex(&ctx,*out,out_len);
@@ -2074,8 +3153,101 @@ class Decipher : public ObjectWrap {
     return scope.Close(outString);
   }
 
+  // decipher.updateInto(input, inOffset, inLength, output, outOffset, [cb])
+  // Returns the number of bytes written to output, or passes it to cb.
+  // output needs inLength plus one block of room.
+  static Handle<Value> DecipherUpdateInto(const Arguments& args) {
+    HandleScope scope;
+
+    Decipher *cipher = ObjectWrap::Unwrap<Decipher>(args.This());
+
+    if (cipher->pending_) return ThrowBusy();
+    if (!cipher->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* in;
+    size_t in_len;
+    char* out;
+    size_t room;
+
+    if (args.Length() < 5 ||
+        !GetBufferRange(args, 0, &in, &in_len) ||
+        !GetOutputRange(args, 3, &out, &room)) {
+      return ThrowBadRange();
+    }
+
+    if (room < in_len + EVP_CIPHER_CTX_block_size(&cipher->ctx)) {
+      return ThrowNoRoom();
+    }
+
+    if (HasCallback(args)) {
+      update_request* ur = new update_request;
+      ur->work = UpdateWork;
+      ur->self = cipher;
+      ur->pending = &cipher->pending_;
+      ur->in = in;
+      ur->in_len = in_len;
+      ur->out = reinterpret_cast<unsigned char*>(out);
+      return QueueUpdate(args, ur, args[3]);
+    }
+
+    int out_len = 0;
+    EVP_CipherUpdate(&cipher->ctx,
+                     reinterpret_cast<unsigned char*>(out),
+                     &out_len,
+                     reinterpret_cast<unsigned char*>(in),
+                     in_len);
+
+    return scope.Close(Integer::New(out_len));
+  }
+
+  static int UpdateWork(update_request* ur) {
+    Decipher* cipher = static_cast<Decipher*>(ur->self);
+    return EVP_CipherUpdate(&cipher->ctx, ur->out, &ur->out_len,
+                            reinterpret_cast<unsigned char*>(ur->in),
+                            ur->in_len);
+  }
+
+  // decipher.finalInto(output, [offset])
+  // Writes the last block; output needs one block of room.
+  static Handle<Value> DecipherFinalInto(const Arguments& args) {
+    HandleScope scope;
+
+    Decipher *cipher = ObjectWrap::Unwrap<Decipher>(args.This());
+
+    if (cipher->pending_) return ThrowBusy();
+    if (!cipher->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* out;
+    size_t room;
+
+    if (!GetOutputRange(args, 0, &out, &room)) return ThrowBadRange();
+
+    if (room < (size_t) EVP_CIPHER_CTX_block_size(&cipher->ctx)) {
+      return ThrowNoRoom();
+    }
+
+    int out_len = 0;
+    int r = EVP_CipherFinal(&cipher->ctx,
+                            reinterpret_cast<unsigned char*>(out),
+                            &out_len);
+    EVP_CIPHER_CTX_cleanup(&cipher->ctx);
+    cipher->initialised_ = false;
+
+    if (!r) {
+      return ThrowException(Exception::Error(
+            String::New("DecipherFinalInto error")));
+    }
+
+    return scope.Close(Integer::New(out_len));
+  }
+
   Decipher () : ObjectWrap () {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Decipher () { }
@@ -2085,6 +3257,7 @@ class Decipher : public ObjectWrap {
   EVP_CIPHER_CTX ctx;
   const EVP_CIPHER *cipher_;
   bool initialised_;
+  bool pending_;
   unsigned char* incomplete_utf8;
   int incomplete_utf8_len;
   char incomplete_hex;
@@ -2106,6 +3279,7 @@ class Hmac : public ObjectWrap {
     NODE_SET_PROTOTYPE_METHOD(t, "init", HmacInit);
     NODE_SET_PROTOTYPE_METHOD(t, "update", HmacUpdate);
     NODE_SET_PROTOTYPE_METHOD(t, "digest", HmacDigest);
+    NODE_SET_PROTOTYPE_METHOD(t, "digestInto", HmacDigestInto);
 
     target->Set(String::NewSymbol("Hmac"), t->GetFunction());
   }
@@ -2124,13 +3298,13 @@ class Hmac : public ObjectWrap {
   }
 
   int HmacUpdate(char* data, int len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     HMAC_Update(&ctx, (unsigned char*)data, len);
     return 1;
   }
 
   int HmacDigest(unsigned char** md_value, unsigned int *md_len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     *md_value = new unsigned char[EVP_MAX_MD_SIZE];
     HMAC_Final(&ctx, *md_value, md_len);
     HMAC_CTX_cleanup(&ctx);
@@ -2188,6 +3362,27 @@ class Hmac : public ObjectWrap {
 
     HandleScope scope;
 
+    if (hmac->pending_) return ThrowBusy();
+
+    // update(buffer, [offset], [length], callback)
+    if (HasCallback(args)) {
+      char* in;
+      size_t in_len;
+      if (!GetBufferRange(args, 0, &in, &in_len)) return ThrowBadRange();
+      if (!hmac->initialised_) {
+        return ThrowException(Exception::Error(String::New("Not initialized")));
+      }
+
+      update_request* ur = new update_request;
+      ur->work = UpdateWork;
+      ur->self = hmac;
+      ur->pending = &hmac->pending_;
+      ur->in = in;
+      ur->in_len = in_len;
+      ur->out = NULL;
+      return QueueUpdate(args, ur, Undefined());
+    }
+
     enum encoding enc = ParseEncoding(args[1]);
     ssize_t len = DecodeBytes(args[0], enc);
 
@@ -2253,6 +3448,9 @@ class Hmac : public ObjectWrap {
         delete [] md_hexdigest;
       } else if (strcasecmp(*encoding, "binary") == 0) {
         outString = Encode(md_value, md_len, BINARY);
+      } else if (strcasecmp(*encoding, "buffer") == 0) {
+        Buffer* buf = Buffer::New(reinterpret_cast<char*>(md_value), md_len);
+        outString = Local<Object>::New(buf->handle_);
       } else {
         fprintf(stderr, "node-crypto : Hmac .digest encoding "
                         "can be binary, hex or base64\n");
@@ -2262,8 +3460,43 @@ class Hmac : public ObjectWrap {
     return scope.Close(outString);
   }
 
+  // Runs on the thread pool while pending_ is set, so it cannot go through
+  // HmacUpdate(), which refuses to touch a busy context.
+  static int UpdateWork(update_request* ur) {
+    Hmac* hmac = static_cast<Hmac*>(ur->self);
+    HMAC_Update(&hmac->ctx, reinterpret_cast<unsigned char*>(ur->in),
+                ur->in_len);
+    return 1;
+  }
+
+  // hmac.digestInto(buffer, [offset])
+  // Returns the number of bytes written.
+  static Handle<Value> HmacDigestInto(const Arguments& args) {
+    HandleScope scope;
+
+    Hmac *hmac = ObjectWrap::Unwrap<Hmac>(args.This());
+
+    if (hmac->pending_) return ThrowBusy();
+    if (!hmac->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* out;
+    size_t room;
+    if (!GetOutputRange(args, 0, &out, &room)) return ThrowBadRange();
+    if (room < (size_t) EVP_MD_size(hmac->md)) return ThrowNoRoom();
+
+    unsigned int md_len = 0;
+    HMAC_Final(&hmac->ctx, reinterpret_cast<unsigned char*>(out), &md_len);
+    HMAC_CTX_cleanup(&hmac->ctx);
+    hmac->initialised_ = false;
+
+    return scope.Close(Integer::New(md_len));
+  }
+
   Hmac () : ObjectWrap () {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Hmac () { }
@@ -2273,6 +3506,7 @@ class Hmac : public ObjectWrap {
   HMAC_CTX ctx; /* coverity[member_decl] */
   const EVP_MD *md; /* coverity[member_decl] */
   bool initialised_;
+  bool pending_;
 };
 
 
@@ -2287,6 +3521,7 @@ class Hash : public ObjectWrap {
 
     NODE_SET_PROTOTYPE_METHOD(t, "update", HashUpdate);
     NODE_SET_PROTOTYPE_METHOD(t, "digest", HashDigest);
+    NODE_SET_PROTOTYPE_METHOD(t, "digestInto", HashDigestInto);
 
     target->Set(String::NewSymbol("Hash"), t->GetFunction());
   }
@@ -2304,7 +3539,7 @@ class Hash : public ObjectWrap {
   }
 
   int HashUpdate(char* data, int len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     EVP_DigestUpdate(&mdctx, data, len);
     return 1;
   }
@@ -2335,6 +3570,27 @@ class Hash : public ObjectWrap {
 
     Hash *hash = ObjectWrap::Unwrap<Hash>(args.This());
 
+    if (hash->pending_) return ThrowBusy();
+
+    // update(buffer, [offset], [length], callback)
+    if (HasCallback(args)) {
+      char* in;
+      size_t in_len;
+      if (!GetBufferRange(args, 0, &in, &in_len)) return ThrowBadRange();
+      if (!hash->initialised_) {
+        return ThrowException(Exception::Error(String::New("Not initialized")));
+      }
+
+      update_request* ur = new update_request;
+      ur->work = UpdateWork;
+      ur->self = hash;
+      ur->pending = &hash->pending_;
+      ur->in = in;
+      ur->in_len = in_len;
+      ur->out = NULL;
+      return QueueUpdate(args, ur, Undefined());
+    }
+
     enum encoding enc = ParseEncoding(args[1]);
     ssize_t len = DecodeBytes(args[0], enc);
 
@@ -2371,6 +3627,7 @@ class Hash : public ObjectWrap {
 
     Hash *hash = ObjectWrap::Unwrap<Hash>(args.This());
 
+    if (hash->pending_) return ThrowBusy();
     if (!hash->initialised_) {
       return ThrowException(Exception::Error(String::New("Not initialized")));
     }
@@ -2408,6 +3665,9 @@ class Hash : public ObjectWrap {
         delete [] md_hexdigest;
       } else if (strcasecmp(*encoding, "binary") == 0) {
         outString = Encode(md_value, md_len, BINARY);
+      } else if (strcasecmp(*encoding, "buffer") == 0) {
+        Buffer* buf = Buffer::New(reinterpret_cast<char*>(md_value), md_len);
+        outString = Local<Object>::New(buf->handle_);
       } else {
         fprintf(stderr, "node-crypto : Hash .digest encoding "
                         "can be binary, hex or base64\n");
@@ -2417,8 +3677,42 @@ class Hash : public ObjectWrap {
     return scope.Close(outString);
   }
 
+  // Runs on the thread pool while pending_ is set; see Hmac::UpdateWork.
+  static int UpdateWork(update_request* ur) {
+    Hash* hash = static_cast<Hash*>(ur->self);
+    return EVP_DigestUpdate(&hash->mdctx, ur->in, ur->in_len);
+  }
+
+  // hash.digestInto(buffer, [offset])
+  // Returns the number of bytes written.
+  static Handle<Value> HashDigestInto(const Arguments& args) {
+    HandleScope scope;
+
+    Hash *hash = ObjectWrap::Unwrap<Hash>(args.This());
+
+    if (hash->pending_) return ThrowBusy();
+    if (!hash->initialised_) {
+      return ThrowException(Exception::Error(String::New("Not initialized")));
+    }
+
+    char* out;
+    size_t room;
+    if (!GetOutputRange(args, 0, &out, &room)) return ThrowBadRange();
+    if (room < (size_t) EVP_MD_size(hash->md)) return ThrowNoRoom();
+
+    unsigned int md_len = 0;
+    EVP_DigestFinal_ex(&hash->mdctx,
+                       reinterpret_cast<unsigned char*>(out),
+                       &md_len);
+    EVP_MD_CTX_cleanup(&hash->mdctx);
+    hash->initialised_ = false;
+
+    return scope.Close(Integer::New(md_len));
+  }
+
   Hash () : ObjectWrap () {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Hash () { }
@@ -2428,6 +3722,7 @@ class Hash : public ObjectWrap {
   EVP_MD_CTX mdctx; /* coverity[member_decl] */
   const EVP_MD *md; /* coverity[member_decl] */
   bool initialised_;
+  bool pending_;
 };
 
 class Sign : public ObjectWrap {
@@ -2461,7 +3756,7 @@ class Sign : public ObjectWrap {
   }
 
   int SignUpdate(char* data, int len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     EVP_SignUpdate(&mdctx, data, len);
     return 1;
   }
@@ -2563,10 +3858,13 @@ class Sign : public ObjectWrap {
 
     HandleScope scope;
 
+    if (sign->pending_) {
+      return ThrowException(Exception::Error(
+            String::New("Signing already in progress")));
+    }
+
     unsigned char* md_value;
     unsigned int md_len;
-    char* md_hexdigest;
-    int md_hex_len;
     Local<Value> outString;
 
     md_len = 8192; // Maximum key size is 8192 bits
@@ -2584,6 +3882,30 @@ class Sign : public ObjectWrap {
     ssize_t written = DecodeWrite(buf, len, args[0], BINARY);
     assert(written == len);
 
+    // sign(key, [encoding], callback): the private key operation runs on
+    // the thread pool.
+    Local<Value> callback = args[args.Length() - 1];
+    if (args.Length() > 1 && callback->IsFunction()) {
+      sign_request* req = new sign_request;
+      req->sign = sign;
+      req->key = buf;
+      req->key_len = len;
+      req->md_value = md_value;
+      req->md_len = md_len;
+      Handle<Value> encoding = Undefined();
+      if (args.Length() > 2) encoding = args[1];
+      req->encoding = Persistent<Value>::New(encoding);
+      req->cb = Persistent<Function>::New(Local<Function>::Cast(callback));
+
+      sign->pending_ = true;
+      sign->Ref();
+
+      eio_custom(EIO_SignFinal, EIO_PRI_DEFAULT, AfterSignFinal, req);
+      ev_ref(EV_DEFAULT_UC);
+
+      return Undefined();
+    }
+
     int r = sign->SignFinal(&md_value, &md_len, buf, len);
 
     delete [] buf;
@@ -2593,11 +3915,28 @@ class Sign : public ObjectWrap {
       return scope.Close(String::New(""));
     }
 
-    if (args.Length() == 1 || !args[1]->IsString()) {
+    Handle<Value> encoding = Undefined();
+    if (args.Length() > 1) encoding = args[1];
+    outString = EncodeSignature(md_value, md_len, encoding);
+
+    delete [] md_value;
+    return scope.Close(outString);
+  }
+
+  static Local<Value> EncodeSignature(unsigned char* md_value,
+                                      unsigned int md_len,
+                                      Handle<Value> enc) {
+    HandleScope scope;
+
+    char* md_hexdigest;
+    int md_hex_len;
+    Local<Value> outString;
+
+    if (!enc->IsString()) {
       // Binary
       outString = Encode(md_value, md_len, BINARY);
     } else {
-      String::Utf8Value encoding(args[1]->ToString());
+      String::Utf8Value encoding(enc->ToString());
       if (strcasecmp(*encoding, "hex") == 0) {
         // Hex encoding
         HexEncode(md_value, md_len, &md_hexdigest, &md_hex_len);
@@ -2616,12 +3955,66 @@ class Sign : public ObjectWrap {
       }
     }
 
-    delete [] md_value;
     return scope.Close(outString);
   }
 
+  struct sign_request {
+    Sign* sign;
+    char* key;
+    int key_len;
+    unsigned char* md_value;
+    unsigned int md_len;
+    int r;
+    Persistent<Value> encoding;
+    Persistent<Function> cb;
+  };
+
+  static int EIO_SignFinal(eio_req* req) {
+    sign_request* sr = static_cast<sign_request*>(req->data);
+    sr->r = sr->sign->SignFinal(&sr->md_value, &sr->md_len,
+                                sr->key, sr->key_len);
+    return 0;
+  }
+
+  static int AfterSignFinal(eio_req* req) {
+    ev_unref(EV_DEFAULT_UC);
+
+    HandleScope scope;
+
+    sign_request* sr = static_cast<sign_request*>(req->data);
+    sr->sign->pending_ = false;
+
+    Local<Value> argv[2];
+
+    if (sr->md_len == 0 || sr->r == 0) {
+      argv[0] = Exception::Error(String::New("SignFinal error"));
+      argv[1] = Local<Value>::New(Undefined());
+    } else {
+      argv[0] = Local<Value>::New(Null());
+      argv[1] = EncodeSignature(sr->md_value, sr->md_len, sr->encoding);
+    }
+
+    TryCatch try_catch;
+
+    sr->cb->Call(Context::GetCurrent()->Global(), 2, argv);
+
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+
+    sr->sign->Unref();
+    sr->encoding.Dispose();
+    sr->cb.Dispose();
+    delete [] sr->key;
+    delete [] sr->md_value;
+    delete sr;
+
+    return 0;
+  }
+
   Sign () : ObjectWrap () {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Sign () { }
@@ -2631,6 +4024,7 @@ class Sign : public ObjectWrap {
   EVP_MD_CTX mdctx; /* coverity[member_decl] */
   const EVP_MD *md; /* coverity[member_decl] */
   bool initialised_;
+  bool pending_;
 };
 
 class Verify : public ObjectWrap {
@@ -2664,7 +4058,7 @@ class Verify : public ObjectWrap {
 
 
   int VerifyUpdate(char* data, int len) {
-    if (!initialised_) return 0;
+    if (!initialised_ || pending_) return 0;
     EVP_VerifyUpdate(&mdctx, data, len);
     return 1;
   }
@@ -2777,6 +4171,11 @@ class Verify : public ObjectWrap {
 
     Verify *verify = ObjectWrap::Unwrap<Verify>(args.This());
 
+    if (verify->pending_) {
+      return ThrowException(Exception::Error(
+            String::New("Verification already in progress")));
+    }
+
     ssize_t klen = DecodeBytes(args[0], BINARY);
 
     if (klen < 0) {
@@ -2803,39 +4202,113 @@ class Verify : public ObjectWrap {
     unsigned char* dbuf;
     int dlen;
 
-    int r=-1;
+    // Signature bytes end up in hbuf, or in dbuf if they were encoded.
+    dbuf = hbuf;
+    dlen = hlen;
 
-    if (args.Length() == 2 || !args[2]->IsString()) {
-      // Binary
-      r = verify->VerifyFinal(kbuf, klen, hbuf, hlen);
-    } else {
+    if (args.Length() > 2 && args[2]->IsString()) {
       String::Utf8Value encoding(args[2]->ToString());
       if (strcasecmp(*encoding, "hex") == 0) {
         // Hex encoding
         HexDecode(hbuf, hlen, (char **)&dbuf, &dlen);
-        r = verify->VerifyFinal(kbuf, klen, dbuf, dlen);
-        delete [] dbuf;
       } else if (strcasecmp(*encoding, "base64") == 0) {
         // Base64 encoding
         unbase64(hbuf, hlen, (char **)&dbuf, &dlen);
-        r = verify->VerifyFinal(kbuf, klen, dbuf, dlen);
-        delete [] dbuf;
-      } else if (strcasecmp(*encoding, "binary") == 0) {
-        r = verify->VerifyFinal(kbuf, klen, hbuf, hlen);
-      } else {
+      } else if (strcasecmp(*encoding, "binary") != 0) {
         fprintf(stderr, "node-crypto : Verify .verify encoding "
                         "can be binary, hex or base64\n");
+        delete [] kbuf;
+        delete [] hbuf;
+        return scope.Close(Integer::New(-1));
       }
     }
 
+    if (dbuf != hbuf) delete [] hbuf;
+
+    // verify(cert, signature, [encoding], callback): the public key
+    // operation runs on the thread pool.
+    Local<Value> callback = args[args.Length() - 1];
+    if (args.Length() > 2 && callback->IsFunction()) {
+      verify_request* req = new verify_request;
+      req->verify = verify;
+      req->key = kbuf;
+      req->key_len = klen;
+      req->sig = dbuf;
+      req->sig_len = dlen;
+      req->cb = Persistent<Function>::New(Local<Function>::Cast(callback));
+
+      verify->pending_ = true;
+      verify->Ref();
+
+      eio_custom(EIO_VerifyFinal, EIO_PRI_DEFAULT, AfterVerifyFinal, req);
+      ev_ref(EV_DEFAULT_UC);
+
+      return Undefined();
+    }
+
+    int r = verify->VerifyFinal(kbuf, klen, dbuf, dlen);
+
     delete [] kbuf;
-    delete [] hbuf;
+    delete [] dbuf;
 
     return scope.Close(Integer::New(r));
   }
 
+  struct verify_request {
+    Verify* verify;
+    char* key;
+    int key_len;
+    unsigned char* sig;
+    int sig_len;
+    int r;
+    Persistent<Function> cb;
+  };
+
+  static int EIO_VerifyFinal(eio_req* req) {
+    verify_request* vr = static_cast<verify_request*>(req->data);
+    vr->r = vr->verify->VerifyFinal(vr->key, vr->key_len,
+                                    vr->sig, vr->sig_len);
+    return 0;
+  }
+
+  static int AfterVerifyFinal(eio_req* req) {
+    ev_unref(EV_DEFAULT_UC);
+
+    HandleScope scope;
+
+    verify_request* vr = static_cast<verify_request*>(req->data);
+    vr->verify->pending_ = false;
+
+    Local<Value> argv[2];
+
+    if (vr->r < 0) {
+      argv[0] = Exception::Error(String::New("VerifyFinal error"));
+      argv[1] = Local<Value>::New(Undefined());
+    } else {
+      argv[0] = Local<Value>::New(Null());
+      argv[1] = Local<Value>::New(vr->r == 1 ? True() : False());
+    }
+
+    TryCatch try_catch;
+
+    vr->cb->Call(Context::GetCurrent()->Global(), 2, argv);
+
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+
+    vr->verify->Unref();
+    vr->cb.Dispose();
+    delete [] vr->key;
+    delete [] vr->sig;
+    delete vr;
+
+    return 0;
+  }
+
   Verify () : ObjectWrap () {
     initialised_ = false;
+    pending_ = false;
   }
 
   ~Verify () { }
@@ -2845,16 +4318,179 @@ class Verify : public ObjectWrap {
   EVP_MD_CTX mdctx; /* coverity[member_decl] */
   const EVP_MD *md; /* coverity[member_decl] */
   bool initialised_;
+  bool pending_;
+
+};
+
+
 
+
+
+// hashFile(path, algorithm, callback)
+// Reads and digests the whole file on the thread pool; the digest is handed
+// to the callback as a Buffer.
+
+#define HASH_FILE_CHUNK (64 * 1024)
+
+struct hash_file_request {
+  const EVP_MD* md;
+  int errorno;
+  const char* syscall;
+  unsigned char md_value[EVP_MAX_MD_SIZE];
+  unsigned int md_len;
+  Persistent<Function> cb;
+  char path[1];
 };
 
 
+static int EIO_HashFile(eio_req* req) {
+  hash_file_request* hr = static_cast<hash_file_request*>(req->data);
+
+  int fd = open(hr->path, O_RDONLY);
+  if (fd == -1) {
+    hr->errorno = errno;
+    hr->syscall = "open";
+    return 0;
+  }
+
+  char* chunk = new char[HASH_FILE_CHUNK];
+  EVP_MD_CTX mdctx;
+  EVP_MD_CTX_init(&mdctx);
+  EVP_DigestInit_ex(&mdctx, hr->md, NULL);
+
+  ssize_t n;
+  for (;;) {
+    n = read(fd, chunk, HASH_FILE_CHUNK);
+    if (n == 0) break;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      hr->errorno = errno;
+      hr->syscall = "read";
+      break;
+    }
+    EVP_DigestUpdate(&mdctx, chunk, n);
+  }
+
+  EVP_DigestFinal_ex(&mdctx, hr->md_value, &hr->md_len);
+  EVP_MD_CTX_cleanup(&mdctx);
+
+  delete [] chunk;
+  close(fd);
+  return 0;
+}
+
+
+static int AfterHashFile(eio_req* req) {
+  ev_unref(EV_DEFAULT_UC);
+
+  HandleScope scope;
+
+  hash_file_request* hr = static_cast<hash_file_request*>(req->data);
+
+  Local<Value> argv[2];
+
+  if (hr->errorno) {
+    argv[0] = ErrnoException(hr->errorno, hr->syscall, "", hr->path);
+    argv[1] = Local<Value>::New(Undefined());
+  } else {
+    Buffer* buf = Buffer::New(reinterpret_cast<char*>(hr->md_value),
+                              hr->md_len);
+    argv[0] = Local<Value>::New(Null());
+    argv[1] = Local<Object>::New(buf->handle_);
+  }
+
+  TryCatch try_catch;
+
+  hr->cb->Call(Context::GetCurrent()->Global(), 2, argv);
+
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+
+  hr->cb.Dispose();
+  free(hr);
+
+  return 0;
+}
+
+
+static Handle<Value> HashFile(const Arguments& args) {
+  HandleScope scope;
+
+  if (args.Length() < 3 ||
+      !args[0]->IsString() ||
+      !args[1]->IsString() ||
+      !args[2]->IsFunction()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Expected path, algorithm and callback")));
+  }
+
+  String::Utf8Value algorithm(args[1]->ToString());
+  const EVP_MD* md = EVP_get_digestbyname(*algorithm);
+  if (md == NULL) {
+    return ThrowException(Exception::Error(
+          String::New("Unknown message digest")));
+  }
+
+  String::Utf8Value path(args[0]->ToString());
+
+  hash_file_request* hr = static_cast<hash_file_request*>(
+      calloc(1, sizeof(hash_file_request) + path.length()));
+  if (hr == NULL) {
+    V8::LowMemoryNotification();
+    return ThrowException(Exception::Error(
+          String::New("Could not allocate enough memory")));
+  }
+
+  memcpy(hr->path, *path, path.length() + 1);
+  hr->md = md;
+  hr->cb = Persistent<Function>::New(Local<Function>::Cast(args[2]));
+
+  eio_custom(EIO_HashFile, EIO_PRI_DEFAULT, AfterHashFile, hr);
+  ev_ref(EV_DEFAULT_UC);
+
+  return Undefined();
+}
+
+
+// Handshakes, signatures and digests run on the eio threads as well as the
+// main one. OpenSSL before 1.1 needs to be handed its locks.
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static pthread_mutex_t* crypto_locks;
+
+static void CryptoLockCallback(int mode, int n, const char* file, int line) {
+  if (mode & CRYPTO_LOCK) {
+    pthread_mutex_lock(&crypto_locks[n]);
+  } else {
+    pthread_mutex_unlock(&crypto_locks[n]);
+  }
+}
+
+static unsigned long CryptoIdCallback(void) {
+#ifdef __MINGW32__
+  return (unsigned long) GetCurrentThreadId();
+#else
+  return (unsigned long) pthread_self();
+#endif
+}
+
+static void InitCryptoLocks() {
+  int n = CRYPTO_num_locks();
+  crypto_locks = new pthread_mutex_t[n];
+  for (int i = 0; i < n; i++) pthread_mutex_init(&crypto_locks[i], NULL);
 
+  CRYPTO_set_id_callback(CryptoIdCallback);
+  CRYPTO_set_locking_callback(CryptoLockCallback);
+}
+#else
+static void InitCryptoLocks() { }
+#endif
 
 
 void InitCrypto(Handle<Object> target) {
   HandleScope scope;
 
+  InitCryptoLocks();
   SSL_library_init();
   OpenSSL_add_all_algorithms();
   OpenSSL_add_all_digests();
@@ -2870,6 +4506,8 @@ void InitCrypto(Handle<Object> target) {
   Sign::Initialize(target);
   Verify::Initialize(target);
 
+  NODE_SET_METHOD(target, "hashFile", HashFile);
+
   subject_symbol    = NODE_PSYMBOL("subject");
   issuer_symbol     = NODE_PSYMBOL("issuer");
   valid_from_symbol = NODE_PSYMBOL("valid_from");
@@ -2878,6 +4516,7 @@ void InitCrypto(Handle<Object> target) {
   name_symbol       = NODE_PSYMBOL("name");
   version_symbol    = NODE_PSYMBOL("version");
   ext_key_usage_symbol = NODE_PSYMBOL("ext_key_usage");
+  want_write_symbol = NODE_PSYMBOL("wantWrite");
 }
 
 }  // namespace crypto
@@ -12,18 +12,65 @@
 #include <openssl/x509.h>
 #include <openssl/hmac.h>
 
+#include <sys/types.h>
+#include <stdint.h>
+#include <pthread.h>
+
 #define EVP_F_EVP_DECRYPTFINAL 101
 
 
 namespace node {
 namespace crypto {
 
+// Server side session cache kept in a memory mapped file, so that every
+// process opening the same file can resume the sessions of the others.
+// Direct mapped: a session id hashes to one slot, a newer session evicts
+// whatever was there. Slots are locked with fcntl() byte range locks, which
+// the kernel drops if a process dies while holding one.
+//
+// fcntl() locks belong to the process and closing any descriptor of the
+// file drops all of them, so a process opens each file once: Open() hands
+// out another reference to an instance already open on the same file, and
+// the instance's mutex keeps the threads of this process apart.
+class SessionCache {
+ public:
+  static SessionCache* Open(const char* path, uint32_t slots);
+  // Drops a reference; the last one unmaps and closes the file.
+  void Release();
+
+  void Put(SSL_SESSION* sess);
+  SSL_SESSION* Get(const unsigned char* id, int length);
+  void Remove(SSL_SESSION* sess);
+
+ private:
+  SessionCache() : fd_(-1), base_(NULL), size_(0), slots_(0), dev_(0),
+                   ino_(0), refs_(1), next_(NULL) {
+    pthread_mutex_init(&mutex_, NULL);
+  }
+  ~SessionCache();
+
+  struct Slot;
+  Slot* Lock(const unsigned char* id, unsigned int length, off_t* offset);
+  void Unlock(off_t offset);
+
+  int fd_;
+  char* base_;
+  size_t size_;
+  uint32_t slots_;
+  dev_t dev_;
+  ino_t ino_;
+  int refs_;
+  SessionCache* next_;
+  pthread_mutex_t mutex_;
+};
+
 class SecureContext : ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
 
   SSL_CTX *ctx_;
   X509_STORE *ca_store_;
+  SessionCache *session_cache_;
 
  protected:
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
@@ -34,21 +81,31 @@ class SecureContext : ObjectWrap {
   static v8::Handle<v8::Value> AddCRL(const v8::Arguments& args);
   static v8::Handle<v8::Value> AddRootCerts(const v8::Arguments& args);
   static v8::Handle<v8::Value> SetCiphers(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetSessionIdContext(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetSessionTimeout(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetSessionCache(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetTicketKeys(const v8::Arguments& args);
   static v8::Handle<v8::Value> Close(const v8::Arguments& args);
 
   SecureContext() : ObjectWrap() {
     ctx_ = NULL;
     ca_store_ = NULL;
+    session_cache_ = NULL;
   }
 
   ~SecureContext() {
     if (ctx_) {
+      // Freeing the context flushes its sessions; they must stay in the
+      // shared cache for the other processes.
+      SSL_CTX_sess_set_remove_cb(ctx_, NULL);
       SSL_CTX_free(ctx_);
       ctx_ = NULL;
       ca_store_ = NULL;
     } else {
       assert(ca_store_ == NULL);
     }
+    if (session_cache_) session_cache_->Release();
+    session_cache_ = NULL;
   }
 
  private:
@@ -74,9 +131,25 @@ class Connection : ObjectWrap {
   static v8::Handle<v8::Value> ReceivedShutdown(const v8::Arguments& args);
   static v8::Handle<v8::Value> Start(const v8::Arguments& args);
   static v8::Handle<v8::Value> Close(const v8::Arguments& args);
+  static v8::Handle<v8::Value> GetSession(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetSession(const v8::Arguments& args);
+  static v8::Handle<v8::Value> IsSessionReused(const v8::Arguments& args);
+
+  // Runs the next handshake step on the eio thread pool. JS must leave the
+  // connection alone until the callback fires.
+  static v8::Handle<v8::Value> HandshakeAsync(const v8::Arguments& args);
+  static int EIO_Handshake(eio_req* req);
+  static int AfterHandshake(eio_req* req);
+
+  // Native mode: SSL_read/SSL_write straight on the socket fd.
+  static v8::Handle<v8::Value> SetFd(const v8::Arguments& args);
+  static v8::Handle<v8::Value> ReadFd(const v8::Arguments& args);
+  static v8::Handle<v8::Value> WriteFd(const v8::Arguments& args);
+  static v8::Handle<v8::Value> HandshakeFd(const v8::Arguments& args);
 
   int HandleBIOError(BIO *bio, const char* func, int rv);
   int HandleSSLError(const char* func, int rv);
+  v8::Handle<v8::Value> HandleFdResult(const char* func, int rv);
 
   void ClearError();
   void SetShutdownFlags();
@@ -90,6 +163,9 @@ class Connection : ObjectWrap {
   Connection() : ObjectWrap() {
     bio_read_ = bio_write_ = NULL;
     ssl_ = NULL;
+    fd_mode_ = false;
+    busy_ = false;
+    close_pending_ = false;
   }
 
   ~Connection() {
@@ -104,6 +180,9 @@ class Connection : ObjectWrap {
   BIO *bio_write_;
   SSL *ssl_;
   bool is_server_; /* coverity[member_decl] */
+  bool fd_mode_;
+  bool busy_;
+  bool close_pending_;
 };
 
 void InitCrypto(v8::Handle<v8::Object> target);
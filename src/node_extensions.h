@@ -10,8 +10,13 @@ NODE_EXT_LIST_ITEM(node_evals)
 NODE_EXT_LIST_ITEM(node_fs)
 NODE_EXT_LIST_ITEM(node_net)
 NODE_EXT_LIST_ITEM(node_http_parser)
+NODE_EXT_LIST_ITEM(node_http_writer)
+NODE_EXT_LIST_ITEM(node_url)
 NODE_EXT_LIST_ITEM(node_signal_watcher)
 NODE_EXT_LIST_ITEM(node_stdio)
 NODE_EXT_LIST_ITEM(node_os)
+#ifdef HAVE_ZLIB
+NODE_EXT_LIST_ITEM(node_zlib)
+#endif
 NODE_EXT_LIST_END
 
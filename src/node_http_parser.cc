@@ -35,6 +35,7 @@ static Persistent<String> on_header_field_sym;
 static Persistent<String> on_header_value_sym;
 static Persistent<String> on_headers_complete_sym;
 static Persistent<String> on_body_sym;
+static Persistent<String> on_body_read_sym;
 static Persistent<String> on_message_complete_sym;
 
 static Persistent<String> delete_sym;
@@ -69,10 +70,149 @@ static Persistent<String> version_major_sym;
 static Persistent<String> version_minor_sym;
 static Persistent<String> should_keep_alive_sym;
 static Persistent<String> upgrade_sym;
+static Persistent<String> path_start_sym;
+static Persistent<String> path_end_sym;
+static Persistent<String> query_start_sym;
+static Persistent<String> query_end_sym;
+static Persistent<String> fragment_start_sym;
+static Persistent<String> fragment_end_sym;
+static Persistent<String> header_names_sym;
+static Persistent<String> header_values_sym;
+static Persistent<String> header_offsets_sym;
 
 static struct http_parser_settings settings;
 
 
+// Header names common enough to be worth interning. A field whose name is
+// in this list reaches JS as a lower-cased symbol that was created once at
+// startup; only other names are turned into new strings.
+static const char* const known_header_names[] = {
+  "accept", "accept-charset", "accept-encoding", "accept-language",
+  "accept-ranges", "access-control-allow-credentials",
+  "access-control-allow-headers", "access-control-allow-methods",
+  "access-control-allow-origin", "access-control-request-headers",
+  "access-control-request-method", "age", "allow", "authorization",
+  "cache-control", "connection", "content-disposition", "content-encoding",
+  "content-language", "content-length", "content-location", "content-md5",
+  "content-range", "content-type", "cookie", "date", "dnt", "etag", "expect",
+  "expires", "from", "host", "if-match", "if-modified-since",
+  "if-none-match", "if-range", "if-unmodified-since", "keep-alive",
+  "last-modified", "link", "location", "max-forwards", "origin", "pragma",
+  "proxy-authenticate", "proxy-authorization", "proxy-connection", "range",
+  "referer", "refresh", "retry-after", "server", "set-cookie",
+  "strict-transport-security", "te", "trailer", "transfer-encoding",
+  "upgrade", "user-agent", "vary", "via", "warning", "www-authenticate",
+  "x-forwarded-for", "x-forwarded-host", "x-forwarded-proto",
+  "x-powered-by", "x-real-ip", "x-requested-with"
+};
+
+#define KNOWN_HEADERS \
+  (sizeof(known_header_names) / sizeof(known_header_names[0]))
+
+static Persistent<String> known_header_syms[KNOWN_HEADERS];
+static size_t known_header_lengths[KNOWN_HEADERS];
+
+// Perfect hash of the names above: with this seed no two of them share a
+// slot, so a lookup is one hash and at most one compare. The slot holds
+// the index of the name plus one, zero meaning no known name.
+#define HEADER_HASH_SEED 0x30b8
+#define HEADER_HASH_SLOTS 256
+
+static unsigned char known_header_slots[HEADER_HASH_SLOTS];
+
+// FNV-1a over a lower-cased name.
+static inline unsigned int HeaderHash(const char* name, size_t len) {
+  uint32_t h = HEADER_HASH_SEED;
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ static_cast<unsigned char>(name[i])) * 16777619;
+  }
+  return (h ^ (h >> 16)) & (HEADER_HASH_SLOTS - 1);
+}
+
+// Index into known_header_names, or -1.
+static inline int KnownHeader(const char* name, size_t len) {
+  int slot = known_header_slots[HeaderHash(name, len)];
+  if (slot == 0) return -1;
+  int index = slot - 1;
+  if (known_header_lengths[index] != len ||
+      memcmp(known_header_names[index], name, len) != 0) {
+    return -1;
+  }
+  return index;
+}
+
+
+static inline char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+// A growable byte array. Parsers keep theirs across messages, so it is
+// normally allocated once per parser.
+class ByteArray {
+ public:
+  ByteArray() : data_(NULL), size_(0), capacity_(0) {
+  }
+
+  ~ByteArray() {
+    free(data_);
+  }
+
+  // Returns where the len new bytes start.
+  char* Grow(size_t len) {
+    if (size_ + len > capacity_) {
+      size_t capacity = capacity_ ? capacity_ * 2 : 256;
+      while (capacity < size_ + len) capacity *= 2;
+      char* data = static_cast<char*>(realloc(data_, capacity));
+      if (data == NULL) return NULL;
+      data_ = data;
+      capacity_ = capacity;
+    }
+    char* p = data_ + size_;
+    size_ += len;
+    return p;
+  }
+
+  bool Append(const char* s, size_t len) {
+    if (len == 0) return true;
+    char* p = Grow(len);
+    if (p == NULL) return false;
+    memcpy(p, s, len);
+    return true;
+  }
+
+  bool AppendLower(const char* s, size_t len) {
+    if (len == 0) return true;
+    char* p = Grow(len);
+    if (p == NULL) return false;
+    for (size_t i = 0; i < len; i++) p[i] = ToLower(s[i]);
+    return true;
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  void Truncate(size_t size) { size_ = size; }
+  void Clear() { size_ = 0; }
+
+ private:
+  char* data_;
+  size_t size_;
+  size_t capacity_;
+};
+
+
+// One received header line. The name is a known_header_names index, or
+// sits lower-cased in Parser::names_. The value is a range of the buffer
+// being parsed, or of Parser::values_ once it had to be copied out.
+struct header_line {
+  int known;
+  size_t name_start;
+  size_t name_len;
+  size_t value_start;
+  size_t value_len;
+};
+
+
 // This is a hack to get the current_buffer to the callbacks with the least
 // amount of overhead. Nothing else will run while http_parser_execute()
 // runs, therefore this pointer can be set and used for the execution.
@@ -84,42 +224,45 @@ static size_t current_buffer_len;
 // Callback prototype for http_cb
 #define DEFINE_HTTP_CB(name)                                             \
   static int name(http_parser *p) {                                      \
-    Parser *parser = static_cast<Parser*>(p->data);                      \
-    Local<Value> cb_value = parser->handle_->Get(name##_sym);            \
-    if (!cb_value->IsFunction()) return 0;                               \
-    Local<Function> cb = Local<Function>::Cast(cb_value);                \
-    Local<Value> ret = cb->Call(parser->handle_, 0, NULL);               \
-    if (ret.IsEmpty()) {                                                 \
-      parser->got_exception_ = true;                                     \
-      return -1;                                                         \
-    } else {                                                             \
-      return 0;                                                          \
-    }                                                                    \
+    return Callback(p, name##_sym);                                      \
   }
 
 // Callback prototype for http_data_cb
 #define DEFINE_HTTP_DATA_CB(name)                                        \
+  static int name(http_parser *p, const char *at, size_t length) {       \
+    return DataCallback(p, name##_sym, at, length);                      \
+  }
+
+// The pieces of the URL are also remembered as positions in the input, so
+// that onHeadersComplete can say where they sit within the URL.
+#define DEFINE_HTTP_URL_CB(name, part)                                   \
   static int name(http_parser *p, const char *at, size_t length) {       \
     Parser *parser = static_cast<Parser*>(p->data);                      \
-    assert(current_buffer);                                              \
-    Local<Value> cb_value = parser->handle_->Get(name##_sym);            \
-    if (!cb_value->IsFunction()) return 0;                               \
-    Local<Function> cb = Local<Function>::Cast(cb_value);                \
-    Local<Value> argv[3] = { *current_buffer                             \
-                           , Integer::New(at - current_buffer_data)      \
-                           , Integer::New(length)                        \
-                           };                                            \
-    Local<Value> ret = cb->Call(parser->handle_, 3, argv);               \
-    assert(current_buffer);                                              \
-    if (ret.IsEmpty()) {                                                 \
-      parser->got_exception_ = true;                                     \
-      return -1;                                                         \
-    } else {                                                             \
-      return 0;                                                          \
-    }                                                                    \
+    parser->part.Mark(parser->pos_ + (at - parser->data_), length);      \
+    return DataCallback(p, name##_sym, at, length);                      \
   }
 
 
+// Where one piece of the URL starts and ends in the input stream.
+struct url_part {
+  size_t start;
+  size_t end;
+  bool seen;
+
+  void Reset() {
+    seen = false;
+  }
+
+  void Mark(size_t pos, size_t length) {
+    if (!seen) {
+      start = pos;
+      seen = true;
+    }
+    end = pos + length;
+  }
+};
+
+
 static inline Persistent<String>
 method_to_str(unsigned short m) {
   switch (m) {
@@ -153,39 +296,161 @@ method_to_str(unsigned short m) {
 
 class Parser : public ObjectWrap {
  public:
-  Parser(enum http_parser_type type) : ObjectWrap() {
+  Parser(enum http_parser_type type)
+    : ObjectWrap(), headers_(NULL), nheaders_(0), headers_capacity_(0),
+      body_limit_(0), body_(NULL), body_len_(0), body_size_(0) {
     Init(type);
   }
 
   ~Parser() {
+    free(headers_);
+    ClearBody();
   }
 
-  DEFINE_HTTP_CB(on_message_begin)
-  DEFINE_HTTP_CB(on_message_complete)
+  static int Callback(http_parser *p, Persistent<String> sym) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    Local<Value> cb_value = parser->handle_->Get(sym);
+    if (!cb_value->IsFunction()) return 0;
+    Local<Function> cb = Local<Function>::Cast(cb_value);
+    Local<Value> ret = cb->Call(parser->handle_, 0, NULL);
+    if (ret.IsEmpty()) {
+      parser->got_exception_ = true;
+      return -1;
+    } else {
+      return 0;
+    }
+  }
 
-  DEFINE_HTTP_DATA_CB(on_path)
-  DEFINE_HTTP_DATA_CB(on_url)
-  DEFINE_HTTP_DATA_CB(on_fragment)
-  DEFINE_HTTP_DATA_CB(on_query_string)
-  DEFINE_HTTP_DATA_CB(on_header_field)
-  DEFINE_HTTP_DATA_CB(on_header_value)
-  DEFINE_HTTP_DATA_CB(on_body)
+  static int DataCallback(http_parser *p, Persistent<String> sym,
+                          const char *at, size_t length) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    assert(current_buffer);
+    Local<Value> cb_value = parser->handle_->Get(sym);
+    if (!cb_value->IsFunction()) return 0;
+    Local<Function> cb = Local<Function>::Cast(cb_value);
+    Local<Value> argv[3] = { *current_buffer
+                           , Integer::New(at - current_buffer_data)
+                           , Integer::New(length)
+                           };
+    Local<Value> ret = cb->Call(parser->handle_, 3, argv);
+    assert(current_buffer);
+    if (ret.IsEmpty()) {
+      parser->got_exception_ = true;
+      return -1;
+    } else {
+      return 0;
+    }
+  }
+
+  static int on_message_begin(http_parser *p) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    parser->url_.Reset();
+    parser->path_.Reset();
+    parser->query_string_.Reset();
+    parser->fragment_.Reset();
+    parser->ClearHeaders();
+    parser->ClearBody();
+    return Callback(p, on_message_begin_sym);
+  }
+
+  DEFINE_HTTP_URL_CB(on_path, path_)
+  DEFINE_HTTP_URL_CB(on_url, url_)
+  DEFINE_HTTP_URL_CB(on_fragment, fragment_)
+  DEFINE_HTTP_URL_CB(on_query_string, query_string_)
+  static int on_body(http_parser *p, const char *at, size_t length) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    if (!parser->collect_body_) {
+      return DataCallback(p, on_body_sym, at, length);
+    }
+    return parser->CollectBody(at, length) ? 0 : -1;
+  }
+
+  static int on_header_field(http_parser *p, const char *at, size_t length) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    if (!parser->HeaderField(at, length)) return -1;
+    return DataCallback(p, on_header_field_sym, at, length);
+  }
+
+  static int on_header_value(http_parser *p, const char *at, size_t length) {
+    Parser *parser = static_cast<Parser*>(p->data);
+    if (!parser->HeaderValue(at, length)) return -1;
+    return DataCallback(p, on_header_value_sym, at, length);
+  }
+
+  static int on_message_complete(http_parser *p) {
+    Parser *parser = static_cast<Parser*>(p->data);
+
+    Local<Value> cb_value = parser->handle_->Get(on_message_complete_sym);
+    if (!cb_value->IsFunction()) {
+      parser->ClearHeaders();
+      return 0;
+    }
+    Local<Function> cb = Local<Function>::Cast(cb_value);
+
+    // Trailers of a chunked message, in the same form as the headers.
+    int argc = 0;
+    Local<Value> argv[1];
+    if (parser->header_state_ != HEADER_NONE) {
+      Local<Object> trailer_info = Object::New();
+      parser->TakeHeaders(trailer_info);
+      argv[argc++] = trailer_info;
+    }
+
+    Local<Value> ret = cb->Call(parser->handle_, argc, argv);
+    if (ret.IsEmpty()) {
+      parser->got_exception_ = true;
+      return -1;
+    } else {
+      return 0;
+    }
+  }
 
   static int on_headers_complete(http_parser *p) {
     Parser *parser = static_cast<Parser*>(p->data);
 
     Local<Value> cb_value = parser->handle_->Get(on_headers_complete_sym);
-    if (!cb_value->IsFunction()) return 0;
+    if (!cb_value->IsFunction()) {
+      parser->ClearHeaders();
+      return 0;
+    }
     Local<Function> cb = Local<Function>::Cast(cb_value);
 
 
     Local<Object> message_info = Object::New();
 
+    // HEADERS
+    if (parser->header_state_ != HEADER_NONE) {
+      parser->TakeHeaders(message_info);
+    }
+
     // METHOD
     if (p->type == HTTP_REQUEST) {
       message_info->Set(method_sym, method_to_str(p->method));
     }
 
+    // URL: offsets of the path, query string and fragment in it
+    if (p->type == HTTP_REQUEST && parser->url_.seen) {
+      size_t url_start = parser->url_.start;
+      if (parser->path_.seen) {
+        message_info->Set(path_start_sym,
+                          Integer::New(parser->path_.start - url_start));
+        message_info->Set(path_end_sym,
+                          Integer::New(parser->path_.end - url_start));
+      }
+      if (parser->query_string_.seen) {
+        message_info->Set(query_start_sym,
+                          Integer::New(parser->query_string_.start - url_start));
+        message_info->Set(query_end_sym,
+                          Integer::New(parser->query_string_.end - url_start));
+      }
+      if (parser->fragment_.seen) {
+        message_info->Set(fragment_start_sym,
+                          Integer::New(parser->fragment_.start - url_start));
+        message_info->Set(fragment_end_sym,
+                          Integer::New(parser->fragment_.end - url_start));
+      }
+    }
+
     // STATUS
     if (p->type == HTTP_RESPONSE) {
       message_info->Set(status_code_sym, Integer::New(p->status_code));
@@ -275,10 +540,24 @@ class Parser : public ObjectWrap {
     current_buffer_data = buffer_data;
     current_buffer_len = buffer_len;
     parser->got_exception_ = false;
+    parser->data_ = buffer_data + off;
 
     size_t nparsed =
       http_parser_execute(&parser->parser_, &settings, buffer_data + off, len);
 
+    parser->pos_ += nparsed;
+
+    // Header values are ranges of this buffer; if the header block goes on
+    // in the next one, keep a copy of what was received so far.
+    if (parser->header_state_ != HEADER_NONE) parser->CopyHeaderValues();
+
+    // Body collected by collectBody() is announced once per execute(), not
+    // once per piece of it.
+    if (parser->body_pending_ && !parser->got_exception_) {
+      parser->body_pending_ = false;
+      Callback(&parser->parser_, on_body_read_sym);
+    }
+
     // Unassign the 'buffer_' variable
     assert(current_buffer);
     current_buffer = NULL;
@@ -339,16 +618,292 @@ class Parser : public ObjectWrap {
     return Undefined();
   }
 
+  // parser.collectBody(enable, [limit])
+  //
+  // Instead of calling onBody() for every piece, keep the body of the
+  // current message in one growing buffer and call onBodyRead() at the end
+  // of each execute() that added to it. With a limit, bytes past it are
+  // dropped and bodyLength() reports -1 until collectBody() is called
+  // without one. Collecting stops at the next message.
+  static Handle<Value> CollectBody(const Arguments& args) {
+    HandleScope scope;
+    Parser *parser = ObjectWrap::Unwrap<Parser>(args.This());
+
+    bool enable = args[0]->IsTrue();
+    size_t limit = args[1]->IsNumber() ?
+                   static_cast<size_t>(args[1]->IntegerValue()) : 0;
+
+    if (limit && parser->body_len_ > limit) {
+      parser->ClearBody();
+      parser->body_overflow_ = true;
+    } else if (!limit) {
+      parser->body_overflow_ = false;
+    }
+
+    parser->collect_body_ = enable;
+    parser->body_limit_ = limit;
+
+    return Undefined();
+  }
+
+  // var length = parser.bodyLength();
+  static Handle<Value> BodyLength(const Arguments& args) {
+    HandleScope scope;
+    Parser *parser = ObjectWrap::Unwrap<Parser>(args.This());
+
+    if (parser->body_overflow_) return scope.Close(Integer::New(-1));
+    return scope.Close(Integer::NewFromUnsigned(parser->body_len_));
+  }
+
+  // var slowBuffer = parser.takeBody();
+  //
+  // Hands the collected bytes over to a SlowBuffer without copying them and
+  // starts over with an empty buffer. Returns null when nothing was
+  // collected.
+  static Handle<Value> TakeBody(const Arguments& args) {
+    HandleScope scope;
+    Parser *parser = ObjectWrap::Unwrap<Parser>(args.This());
+
+    parser->body_pending_ = false;
+    if (parser->body_len_ == 0) return Null();
+
+    Buffer* buffer = Buffer::New(parser->body_, parser->body_len_, FreeBody,
+                                 reinterpret_cast<void*>(parser->body_size_));
+    parser->body_ = NULL;
+    parser->body_len_ = 0;
+    parser->body_size_ = 0;
+
+    return scope.Close(buffer->handle_);
+  }
+
 
  private:
 
+  static void FreeBody(char *data, void *hint) {
+    BufferPool::Free(data, reinterpret_cast<size_t>(hint));
+  }
+
+  // Drops whatever was collected and stops collecting. Also runs from the
+  // destructor, so the external memory delta is left for the next
+  // allocation to report.
+  void ClearBody() {
+    if (body_) BufferPool::Free(body_, body_size_);
+    body_ = NULL;
+    body_len_ = 0;
+    body_size_ = 0;
+    body_overflow_ = false;
+    body_pending_ = false;
+    collect_body_ = false;
+  }
+
+  bool CollectBody(const char *at, size_t length) {
+    body_pending_ = true;
+    if (body_overflow_) return true;
+
+    if (body_limit_ && body_len_ + length > body_limit_) {
+      ClearBody();
+      collect_body_ = true;
+      body_overflow_ = true;
+      body_pending_ = true;
+      return true;
+    }
+
+    if (body_len_ + length > body_size_) {
+      // Grow in powers of two so that the chunks come from, and go back
+      // to, the size classes of the SlowBuffer pool.
+      size_t size = body_size_ * 2;
+      if (size == 0) size = kMinBodySize;
+      while (size < body_len_ + length) size *= 2;
+      char* body = BufferPool::Alloc(size);
+      if (body == NULL) return false;
+      if (body_) {
+        memcpy(body, body_, body_len_);
+        BufferPool::Free(body_, body_size_);
+      }
+      body_ = body;
+      body_size_ = size;
+
+      ssize_t delta = BufferPool::TakeExternalDelta();
+      if (delta) V8::AdjustAmountOfExternalAllocatedMemory(delta);
+    }
+
+    memcpy(body_ + body_len_, at, length);
+    body_len_ += length;
+    return true;
+  }
+
+  static const size_t kMinBodySize = 4 * 1024;
+
+  enum header_state { HEADER_NONE, HEADER_FIELD, HEADER_VALUE };
+
   void Init (enum http_parser_type type) {
     http_parser_init(&parser_, type);
     parser_.data = this;
+    pos_ = 0;
+    data_ = NULL;
+    ClearHeaders();
+    ClearBody();
+  }
+
+  void ClearHeaders() {
+    header_state_ = HEADER_NONE;
+    nheaders_ = 0;
+    names_.Clear();
+    values_.Clear();
+    values_copied_ = false;
+  }
+
+  // Part of a field name. A name split over two execute() calls is put
+  // back together in names_ and looked up once it is complete.
+  bool HeaderField(const char *at, size_t length) {
+    // http_parser reports no value for an empty one, so a field right
+    // after a field is a new line unless it continues in a new buffer.
+    if (header_state_ == HEADER_FIELD && at != data_) EndField();
+
+    if (header_state_ != HEADER_FIELD) {
+      if (nheaders_ == headers_capacity_) {
+        size_t capacity = headers_capacity_ ? headers_capacity_ * 2 : 32;
+        header_line* headers = static_cast<header_line*>(
+            realloc(headers_, capacity * sizeof(header_line)));
+        if (headers == NULL) return false;
+        headers_ = headers;
+        headers_capacity_ = capacity;
+      }
+
+      header_line* line = &headers_[nheaders_++];
+      line->known = -1;
+      line->name_start = names_.size();
+      line->name_len = 0;
+      line->value_start = 0;
+      line->value_len = 0;
+      header_state_ = HEADER_FIELD;
+    }
+
+    if (!names_.AppendLower(at, length)) return false;
+    headers_[nheaders_ - 1].name_len += length;
+    return true;
+  }
+
+  // The name of the last line is complete. Known names do not need their
+  // bytes kept.
+  void EndField() {
+    header_line* line = &headers_[nheaders_ - 1];
+    line->known = KnownHeader(names_.data() + line->name_start,
+                              line->name_len);
+    if (line->known >= 0) names_.Truncate(line->name_start);
+    line->value_start = values_copied_ ? values_.size() : 0;
+    line->value_len = 0;
+    header_state_ = HEADER_VALUE;
+  }
+
+  bool HeaderValue(const char *at, size_t length) {
+    bool first = header_state_ == HEADER_FIELD;
+    if (first) EndField();
+
+    header_line* line = &headers_[nheaders_ - 1];
+    size_t offset = at - current_buffer_data;
+
+    if (!values_copied_) {
+      if (first) {
+        line->value_start = offset;
+      } else if (offset != line->value_start + line->value_len) {
+        // Not contiguous with the rest of the value.
+        if (!CopyHeaderValues()) return false;
+      }
+    }
+
+    if (values_copied_ && !values_.Append(at, length)) return false;
+    line->value_len += length;
+    return true;
+  }
+
+  // Moves the values received so far out of the buffer being parsed, for
+  // when they have to outlive it.
+  bool CopyHeaderValues() {
+    if (values_copied_) return true;
+
+    for (size_t i = 0; i < nheaders_; i++) {
+      header_line* line = &headers_[i];
+      if (i == nheaders_ - 1 && header_state_ == HEADER_FIELD) break;
+      size_t start = values_.size();
+      if (!values_.Append(current_buffer_data + line->value_start,
+                          line->value_len)) {
+        return false;
+      }
+      line->value_start = start;
+    }
+
+    values_copied_ = true;
+    return true;
+  }
+
+  // Hands the collected lines over to JS as
+  //   headerNames:   [name, ...]
+  //   headerValues:  a Buffer holding the values
+  //   headerOffsets: [start, end, ...] of each value in headerValues
+  // The values are only turned into strings when JS asks for them.
+  void TakeHeaders(Local<Object> info) {
+    if (header_state_ == HEADER_FIELD) EndField();
+
+    Local<Array> names = Array::New(nheaders_);
+    Local<Array> offsets = Array::New(nheaders_ * 2);
+
+    for (size_t i = 0; i < nheaders_; i++) {
+      header_line* line = &headers_[i];
+      if (line->known >= 0) {
+        names->Set(i, known_header_syms[line->known]);
+      } else {
+        names->Set(i, String::New(names_.data() + line->name_start,
+                                  line->name_len));
+      }
+      offsets->Set(i * 2, Integer::New(line->value_start));
+      offsets->Set(i * 2 + 1,
+                   Integer::New(line->value_start + line->value_len));
+    }
+
+    if (values_copied_) {
+      Buffer* values = Buffer::New(const_cast<char*>(values_.data()),
+                                   values_.size());
+      info->Set(header_values_sym, values->handle_);
+    } else {
+      info->Set(header_values_sym, *current_buffer);
+    }
+
+    info->Set(header_names_sym, names);
+    info->Set(header_offsets_sym, offsets);
+
+    ClearHeaders();
   }
 
   bool got_exception_;
   http_parser parser_;
+
+  // Bytes parsed before the current execute() and where its data begins.
+  size_t pos_;
+  const char *data_;
+
+  url_part url_;
+  url_part path_;
+  url_part query_string_;
+  url_part fragment_;
+
+  // Header lines of the message (or trailers) being parsed.
+  header_state header_state_;
+  header_line *headers_;
+  size_t nheaders_;
+  size_t headers_capacity_;
+  ByteArray names_;
+  ByteArray values_;
+  bool values_copied_;
+
+  // Body collected for collectBody(), in a chunk from BufferPool.
+  bool collect_body_;
+  bool body_overflow_;
+  bool body_pending_;
+  size_t body_limit_;
+  char *body_;
+  size_t body_len_;
+  size_t body_size_;
 };
 
 
@@ -362,6 +917,9 @@ void InitHttpParser(Handle<Object> target) {
   NODE_SET_PROTOTYPE_METHOD(t, "execute", Parser::Execute);
   NODE_SET_PROTOTYPE_METHOD(t, "finish", Parser::Finish);
   NODE_SET_PROTOTYPE_METHOD(t, "reinitialize", Parser::Reinitialize);
+  NODE_SET_PROTOTYPE_METHOD(t, "collectBody", Parser::CollectBody);
+  NODE_SET_PROTOTYPE_METHOD(t, "bodyLength", Parser::BodyLength);
+  NODE_SET_PROTOTYPE_METHOD(t, "takeBody", Parser::TakeBody);
 
   target->Set(String::NewSymbol("HTTPParser"), t->GetFunction());
 
@@ -374,6 +932,7 @@ void InitHttpParser(Handle<Object> target) {
   on_header_value_sym     = NODE_PSYMBOL("onHeaderValue");
   on_headers_complete_sym = NODE_PSYMBOL("onHeadersComplete");
   on_body_sym             = NODE_PSYMBOL("onBody");
+  on_body_read_sym        = NODE_PSYMBOL("onBodyRead");
   on_message_complete_sym = NODE_PSYMBOL("onMessageComplete");
 
   delete_sym = NODE_PSYMBOL("DELETE");
@@ -408,6 +967,25 @@ void InitHttpParser(Handle<Object> target) {
   version_minor_sym = NODE_PSYMBOL("versionMinor");
   should_keep_alive_sym = NODE_PSYMBOL("shouldKeepAlive");
   upgrade_sym = NODE_PSYMBOL("upgrade");
+  path_start_sym = NODE_PSYMBOL("pathStart");
+  path_end_sym = NODE_PSYMBOL("pathEnd");
+  query_start_sym = NODE_PSYMBOL("queryStart");
+  query_end_sym = NODE_PSYMBOL("queryEnd");
+  fragment_start_sym = NODE_PSYMBOL("fragmentStart");
+  fragment_end_sym = NODE_PSYMBOL("fragmentEnd");
+  header_names_sym = NODE_PSYMBOL("headerNames");
+  header_values_sym = NODE_PSYMBOL("headerValues");
+  header_offsets_sym = NODE_PSYMBOL("headerOffsets");
+
+  for (size_t i = 0; i < KNOWN_HEADERS; i++) {
+    const char* name = known_header_names[i];
+    size_t len = strlen(name);
+    unsigned int slot = HeaderHash(name, len);
+    assert(known_header_slots[slot] == 0);
+    known_header_slots[slot] = i + 1;
+    known_header_lengths[i] = len;
+    known_header_syms[i] = NODE_PSYMBOL(name);
+  }
 
   settings.on_message_begin    = Parser::on_message_begin;
   settings.on_path             = Parser::on_path;
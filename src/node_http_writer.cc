@@ -0,0 +1,370 @@
+#include <node_http_writer.h>
+
+#include <v8.h>
+#include <node.h>
+#include <node_buffer.h>
+
+#include <ctype.h>  /* tolower() */
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h>  /* free() */
+#include <string.h>  /* memcpy() */
+
+// Serializes outgoing HTTP headers straight into a Buffer.
+//
+// OutgoingMessage used to build the header block by string concatenation
+// and ran a handful of regular expressions over every field to find the
+// ones that decide how the body is framed. writeHeader() copies the first
+// line, the fields and their values into a pooled Buffer in one call and
+// does that bookkeeping on the bytes it has just written.
+
+
+namespace node {
+
+using namespace v8;
+
+// Flags passed in, describing the message.
+#define HEADER_KEEP_ALIVE       0x01  // shouldKeepAlive
+#define HEADER_CHUNKED_DEFAULT  0x02  // useChunkedEncodingByDefault
+#define HEADER_BODYLESS         0x04  // request that never has a body
+#define HEADER_HAS_BODY         0x08  // _hasBody
+
+// Flags handed back.
+#define HEADER_LAST             0x10  // close the connection afterwards
+#define HEADER_CHUNKED          0x20  // frame the body with chunked encoding
+#define HEADER_CONNECTION       0x40  // a Connection field other than close
+#define HEADER_EXPECT           0x80  // an Expect field was sent
+
+#define CRLF "\r\n"
+
+static const char connection_keep_alive[] = "Connection: keep-alive" CRLF;
+static const char connection_close[] = "Connection: close" CRLF;
+static const char transfer_encoding_chunked[] =
+    "Transfer-Encoding: chunked" CRLF;
+
+#define MIN_STATUS 100
+#define MAX_STATUS 599
+
+// Pre-encoded "HTTP/1.1 200 OK\r\n" lines, keyed by status code. A line is
+// only used when the reason phrase passed in is the one it was built from.
+struct status_line {
+  Persistent<String> reason;
+  char* data;
+  size_t len;
+};
+
+static status_line status_lines[MAX_STATUS - MIN_STATUS + 1];
+
+
+// Case insensitive substring search. needle must be lower case.
+static bool ContainsNoCase(const char* s, size_t len,
+                           const char* needle, size_t nlen) {
+  if (nlen > len) return false;
+
+  for (size_t i = 0; i <= len - nlen; i++) {
+    size_t j = 0;
+    while (j < nlen && tolower(s[i + j]) == needle[j]) j++;
+    if (j == nlen) return true;
+  }
+
+  return false;
+}
+
+#define CONTAINS(s, len, needle) \
+  ContainsNoCase((s), (len), needle, sizeof(needle) - 1)
+
+
+class HeaderBuffer {
+ public:
+  HeaderBuffer(char* data, size_t room)
+    : data_(data), room_(room), pos_(0), full_(false) {
+  }
+
+  void Raw(const char* s, size_t len) {
+    if (full_ || room_ - pos_ < len) {
+      full_ = true;
+      return;
+    }
+    memcpy(data_ + pos_, s, len);
+    pos_ += len;
+  }
+
+  void Number(uint32_t n) {
+    char digits[10];
+    int i = sizeof(digits);
+    do {
+      digits[--i] = '0' + n % 10;
+      n /= 10;
+    } while (n);
+    Raw(digits + i, sizeof(digits) - i);
+  }
+
+  // Writes the value as UTF-8; numbers are formatted without going
+  // through a string.
+  void Write(Handle<Value> value) {
+    if (value->IsUint32()) {
+      Number(value->Uint32Value());
+      return;
+    }
+
+    if (full_) return;
+
+    Local<String> s = value->ToString();
+    int chars;
+    int written = s->WriteUtf8(data_ + pos_,
+                               room_ - pos_,
+                               &chars,
+                               String::HINT_MANY_WRITES_EXPECTED);
+    if (chars < s->Length()) {
+      full_ = true;
+      return;
+    }
+    if (written > 0 && data_[pos_ + written - 1] == '\0') written--;
+    pos_ += written;
+  }
+
+  const char* At(size_t pos) const { return data_ + pos; }
+  size_t pos() const { return pos_; }
+  bool full() const { return full_; }
+
+ private:
+  char* data_;
+  size_t room_;
+  size_t pos_;
+  bool full_;
+};
+
+
+// setStatusLines(codes)
+// Pre-encodes a status line for every entry of http.STATUS_CODES.
+static Handle<Value> SetStatusLines(const Arguments& args) {
+  HandleScope scope;
+
+  if (!args[0]->IsObject()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Argument must be an object")));
+  }
+
+  Local<Object> codes = args[0]->ToObject();
+  Local<Array> keys = codes->GetPropertyNames();
+
+  for (uint32_t i = 0; i < keys->Length(); i++) {
+    Local<Value> key = keys->Get(i);
+    int code = key->Int32Value();
+    if (code < MIN_STATUS || code > MAX_STATUS) continue;
+
+    Local<String> reason = codes->Get(key)->ToString();
+    String::Utf8Value reason_v(reason);
+
+    status_line* line = &status_lines[code - MIN_STATUS];
+    if (line->data) {
+      free(line->data);
+      line->reason.Dispose();
+    }
+
+    size_t size = sizeof("HTTP/1.1 000 " CRLF) + reason_v.length();
+    line->data = static_cast<char*>(malloc(size));
+    line->len = snprintf(line->data, size, "HTTP/1.1 %d %s" CRLF,
+                         code, *reason_v);
+    line->reason = Persistent<String>::New(reason);
+  }
+
+  return Undefined();
+}
+
+
+// writeHeader(buffer, offset, firstLine, reason, fields, values, flags,
+//             state)
+//
+// firstLine is the request line, CRLF included, when reason is undefined.
+// Otherwise it is the status code to be sent with that reason phrase.
+// fields and values are parallel arrays. Returns the number of bytes
+// written, or -1 if the header does not fit in the buffer. The HEADER_LAST,
+// HEADER_CHUNKED, HEADER_CONNECTION and HEADER_EXPECT flags describing what
+// was written are stored in state[0].
+static Handle<Value> WriteHeader(const Arguments& args) {
+  HandleScope scope;
+
+  if (!Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(
+          String::New("First argument must be a Buffer")));
+  }
+
+  if (!args[4]->IsArray() || !args[5]->IsArray() || !args[7]->IsArray()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Bad argument")));
+  }
+
+  Local<Object> buffer_obj = args[0]->ToObject();
+  size_t buffer_length = Buffer::Length(buffer_obj);
+  size_t off = args[1]->Uint32Value();
+
+  if (off > buffer_length) {
+    return ThrowException(Exception::RangeError(
+          String::New("Offset is out of bounds")));
+  }
+
+  HeaderBuffer out(Buffer::Data(buffer_obj) + off, buffer_length - off);
+
+  if (!args[3]->IsUndefined()) {
+    int code = args[2]->IsInt32() ? args[2]->Int32Value() : 0;
+    status_line* line = code >= MIN_STATUS && code <= MAX_STATUS ?
+                        &status_lines[code - MIN_STATUS] : NULL;
+
+    if (line && line->data && args[3]->StrictEquals(line->reason)) {
+      out.Raw(line->data, line->len);
+    } else {
+      out.Raw("HTTP/1.1 ", 9);
+      out.Write(args[2]);
+      out.Raw(" ", 1);
+      out.Write(args[3]);
+      out.Raw(CRLF, 2);
+    }
+  } else {
+    out.Write(args[2]);
+  }
+
+  Local<Array> fields = Local<Array>::Cast(args[4]);
+  Local<Array> values = Local<Array>::Cast(args[5]);
+  int flags = args[6]->Int32Value();
+  int result = 0;
+
+  bool sent_connection = false;
+  bool sent_content_length = false;
+  bool sent_transfer_encoding = false;
+
+  uint32_t n = fields->Length();
+
+  for (uint32_t i = 0; i < n && !out.full(); i++) {
+    size_t field_start = out.pos();
+    out.Write(fields->Get(i));
+    size_t field_len = out.pos() - field_start;
+    out.Raw(": ", 2);
+
+    size_t value_start = out.pos();
+    out.Write(values->Get(i));
+    size_t value_len = out.pos() - value_start;
+    out.Raw(CRLF, 2);
+
+    if (out.full()) break;
+
+    const char* field = out.At(field_start);
+    const char* value = out.At(value_start);
+
+    if (CONTAINS(field, field_len, "connection")) {
+      sent_connection = true;
+      if (CONTAINS(value, value_len, "close")) {
+        result |= HEADER_LAST;
+      } else {
+        result |= HEADER_CONNECTION;
+      }
+
+    } else if (CONTAINS(field, field_len, "transfer-encoding")) {
+      sent_transfer_encoding = true;
+      if (CONTAINS(value, value_len, "chunk")) result |= HEADER_CHUNKED;
+
+    } else if (CONTAINS(field, field_len, "content-length")) {
+      sent_content_length = true;
+
+    } else if (CONTAINS(field, field_len, "expect")) {
+      result |= HEADER_EXPECT;
+    }
+  }
+
+  // keep-alive logic
+  if (!sent_connection) {
+    if ((flags & HEADER_KEEP_ALIVE) &&
+        (sent_content_length ||
+         (flags & (HEADER_CHUNKED_DEFAULT | HEADER_BODYLESS)))) {
+      out.Raw(connection_keep_alive, sizeof(connection_keep_alive) - 1);
+    } else {
+      result |= HEADER_LAST;
+      out.Raw(connection_close, sizeof(connection_close) - 1);
+    }
+  }
+
+  if (!sent_content_length && !sent_transfer_encoding) {
+    if (flags & HEADER_HAS_BODY) {
+      if (flags & HEADER_CHUNKED_DEFAULT) {
+        out.Raw(transfer_encoding_chunked,
+                sizeof(transfer_encoding_chunked) - 1);
+        result |= HEADER_CHUNKED;
+      } else {
+        result |= HEADER_LAST;
+      }
+    } else {
+      // Make sure we don't end the 0\r\n\r\n at the end of the message.
+      result &= ~HEADER_CHUNKED;
+    }
+  }
+
+  out.Raw(CRLF, 2);
+
+  if (out.full()) return scope.Close(Integer::New(-1));
+
+  Local<Array>::Cast(args[7])->Set(0, Integer::New(result));
+  return scope.Close(Integer::New(out.pos()));
+}
+
+
+// writeChunkHeader(buffer, offset, size)
+//
+// Writes the '<hex size>\r\n' line that starts a chunk of a chunked body.
+// The chunk data itself is sent from its own Buffer right behind it.
+// Returns the number of bytes written, or -1 if they do not fit.
+static Handle<Value> WriteChunkHeader(const Arguments& args) {
+  HandleScope scope;
+
+  if (!Buffer::HasInstance(args[0])) {
+    return ThrowException(Exception::TypeError(
+          String::New("First argument must be a Buffer")));
+  }
+
+  Local<Object> buffer_obj = args[0]->ToObject();
+  size_t buffer_length = Buffer::Length(buffer_obj);
+  size_t off = args[1]->Uint32Value();
+
+  if (off > buffer_length) {
+    return ThrowException(Exception::RangeError(
+          String::New("Offset is out of bounds")));
+  }
+
+  static const char hex[] = "0123456789abcdef";
+  uint64_t size = static_cast<uint64_t>(args[2]->IntegerValue());
+
+  char line[sizeof(size) * 2 + 2];
+  int i = sizeof(line) - 2;
+  line[i] = '\r';
+  line[i + 1] = '\n';
+  do {
+    line[--i] = hex[size & 0xf];
+    size >>= 4;
+  } while (size);
+
+  size_t len = sizeof(line) - i;
+  if (len > buffer_length - off) return scope.Close(Integer::New(-1));
+
+  memcpy(Buffer::Data(buffer_obj) + off, line + i, len);
+  return scope.Close(Integer::New(len));
+}
+
+
+void InitHttpWriter(Handle<Object> target) {
+  HandleScope scope;
+
+  NODE_SET_METHOD(target, "setStatusLines", SetStatusLines);
+  NODE_SET_METHOD(target, "writeHeader", WriteHeader);
+  NODE_SET_METHOD(target, "writeChunkHeader", WriteChunkHeader);
+
+  NODE_DEFINE_CONSTANT(target, HEADER_KEEP_ALIVE);
+  NODE_DEFINE_CONSTANT(target, HEADER_CHUNKED_DEFAULT);
+  NODE_DEFINE_CONSTANT(target, HEADER_BODYLESS);
+  NODE_DEFINE_CONSTANT(target, HEADER_HAS_BODY);
+  NODE_DEFINE_CONSTANT(target, HEADER_LAST);
+  NODE_DEFINE_CONSTANT(target, HEADER_CHUNKED);
+  NODE_DEFINE_CONSTANT(target, HEADER_CONNECTION);
+  NODE_DEFINE_CONSTANT(target, HEADER_EXPECT);
+}
+
+}  // namespace node
+
+NODE_MODULE(node_http_writer, node::InitHttpWriter);
@@ -0,0 +1,12 @@
+#ifndef NODE_HTTP_WRITER
+#define NODE_HTTP_WRITER
+
+#include <v8.h>
+
+namespace node {
+
+void InitHttpWriter(v8::Handle<v8::Object> target);
+
+}
+
+#endif  // NODE_HTTP_WRITER
@@ -21,6 +21,7 @@
 #ifdef __POSIX__
 # include <sys/ioctl.h>
 # include <sys/socket.h>
+# include <sys/uio.h> /* writev */
 # include <sys/un.h>
 # include <arpa/inet.h> /* inet_pton */
 # include <netdb.h>
@@ -80,8 +81,14 @@ static Persistent<String> port_symbol;
 static Persistent<String> type_symbol;
 static Persistent<String> tcp_symbol;
 static Persistent<String> unix_symbol;
+static Persistent<String> rejected_symbol;
+static Persistent<String> offsets_symbol;
+static Persistent<String> lengths_symbol;
+static Persistent<String> from_symbol;
+static Persistent<String> truncated_symbol;
 
 static Persistent<FunctionTemplate> recv_msg_template;
+static Persistent<FunctionTemplate> send_many_template;
 
 
 #define FD_ARG(a)                                        \
@@ -212,6 +219,9 @@ static Handle<Value> SocketPair(const Arguments& args) {
 // t.socket("TCP");
 // t.socket("UNIX");
 // t.socket("UDP");
+// t.socket("TCP", true);  -- also set SO_REUSEPORT so several processes
+//                            can bind() the same address and let the
+//                            kernel spread connections between them.
 static Handle<Value> Socket(const Arguments& args) {
   HandleScope scope;
 
@@ -264,6 +274,19 @@ static Handle<Value> Socket(const Arguments& args) {
     }
   }
 
+  if (args[1]->IsTrue()) {
+#ifdef SO_REUSEPORT
+    if (domain == PF_UNIX) {
+      return ThrowException(Exception::Error(
+            String::New("SO_REUSEPORT is not supported on UNIX sockets.")));
+    }
+    set_reuseport = true;
+#else
+    return ThrowException(Exception::Error(
+          String::New("SO_REUSEPORT is not supported on this platform.")));
+#endif
+  }
+
 #ifdef __POSIX__
   int fd = socket(domain, type, 0);
 #else // __MINGW32__
@@ -283,11 +306,15 @@ static Handle<Value> Socket(const Arguments& args) {
 
 #ifdef SO_REUSEPORT
   // needed for datagrams to be able to have multiple processes listening to
-  // e.g. broadcasted datagrams.
+  // e.g. broadcasted datagrams, and for TCP servers that asked for it.
   if (set_reuseport) {
     int flags = 1;
-    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const char *)&flags,
-               sizeof(flags));
+    if (0 > setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const char *)&flags,
+                       sizeof(flags)) && type == SOCK_STREAM) {
+      int sockopt_errno = errno;
+      close(fd);
+      return ThrowException(ErrnoException(sockopt_errno, "setsockopt"));
+    }
   }
 #endif
 
@@ -674,6 +701,8 @@ static Handle<Value> Listen(const Arguments& args) {
   return Undefined();
 }
 
+#ifdef __MINGW32__
+
 void AfterAccept(HANDLE handle, IocpPacket *packet) {
   HandleScope scope;
   TryCatch try_catch;
@@ -789,6 +818,172 @@ static Handle<Value> Accept(const Arguments& args) {
 }
 
 
+#else // __POSIX__
+
+// Spare descriptor, given up when accept() fails with EMFILE so that the
+// pending connections can be taken off the backlog and closed. Otherwise
+// they sit there forever and keep the listening socket readable.
+static int reserve_fd = -1;
+
+static inline void OpenReserveFD() {
+  if (reserve_fd < 0) {
+    reserve_fd = open("/dev/null", O_RDONLY);
+    if (reserve_fd >= 0) SetCloseOnExec(reserve_fd);
+  }
+}
+
+
+// accept() returning a nonblocking, close-on-exec descriptor. accept4()
+// does that in one system call instead of three.
+static int AcceptPeer(int fd, struct sockaddr_storage *address,
+                      socklen_t *len) {
+  int peer;
+
+#if defined(__linux__) && defined(SOCK_NONBLOCK)
+  static bool have_accept4 = true;
+
+  if (have_accept4) {
+    do {
+      peer = accept4(fd, (struct sockaddr *) address, len,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } while (peer < 0 && errno == EINTR);
+
+    if (peer >= 0 || errno != ENOSYS) return peer;
+    have_accept4 = false;
+  }
+#endif
+
+  do {
+    peer = accept(fd, (struct sockaddr *) address, len);
+  } while (peer < 0 && errno == EINTR);
+
+  if (peer < 0) return -1;
+
+  if (!SetNonBlock(peer) || !SetCloseOnExec(peer)) {
+    int fcntl_errno = errno;
+    close(peer);
+    errno = fcntl_errno;
+    return -1;
+  }
+
+  return peer;
+}
+
+
+// Out of descriptors: use the reserved one to accept and immediately close
+// up to max pending connections, then take it back.
+static int RejectPending(int fd, int max) {
+  int rejected = 0;
+
+  if (reserve_fd < 0) return 0;
+  close(reserve_fd);
+  reserve_fd = -1;
+
+  while (rejected < max) {
+    int peer = accept(fd, NULL, NULL);
+    if (peer < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    close(peer);
+    rejected++;
+  }
+
+  OpenReserveFD();
+  return rejected;
+}
+
+
+// var peerInfo = t.accept(server_fd);
+//
+//   peerInfo.fd
+//   peerInfo.address
+//   peerInfo.port
+//
+// Returns a new nonblocking socket fd. If the listen queue is empty the
+// function returns null (wait for server_fd to become readable and try
+// again)
+static Handle<Value> Accept(const Arguments& args) {
+  HandleScope scope;
+
+  FD_ARG(args[0])
+
+  struct sockaddr_storage address_storage;
+  socklen_t len = sizeof(struct sockaddr_storage);
+
+  int peer_fd = AcceptPeer(fd, &address_storage, &len);
+
+  if (peer_fd < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return scope.Close(Null());
+    return ThrowException(ErrnoException(errno, "accept"));
+  }
+
+  Local<Object> peer_info = Object::New();
+  peer_info->Set(fd_symbol, Integer::New(peer_fd));
+  ADDRESS_TO_JS(peer_info, address_storage, len);
+
+  return scope.Close(peer_info);
+}
+
+
+// var peers = t.acceptMany(server_fd, max);
+//
+// Accepts up to max (default 64) connections in one call and returns an
+// array of peerInfo objects as described for accept(), or null if the
+// listen queue is empty.
+//
+// When the process runs out of descriptors the pending connections are
+// accepted and closed (see RejectPending) and an EMFILE exception carrying
+// the number of rejected peers in 'rejected' is thrown, so the caller can
+// back off for a while.
+static Handle<Value> AcceptMany(const Arguments& args) {
+  HandleScope scope;
+
+  FD_ARG(args[0])
+  int max = args[1]->IsInt32() ? args[1]->Int32Value() : 64;
+  if (max < 1) max = 1;
+
+  Local<Array> peers;
+  int count = 0;
+
+  while (count < max) {
+    struct sockaddr_storage address_storage;
+    socklen_t len = sizeof(struct sockaddr_storage);
+
+    int peer_fd = AcceptPeer(fd, &address_storage, &len);
+
+    if (peer_fd < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+
+      // Hand out what we have; the error comes back on the next call.
+      if (count > 0) break;
+
+      if (errno == EMFILE || errno == ENFILE) {
+        int accept_errno = errno;
+        int rejected = RejectPending(fd, max);
+        Local<Value> e = ErrnoException(accept_errno, "accept");
+        e->ToObject()->Set(rejected_symbol, Integer::New(rejected));
+        return ThrowException(e);
+      }
+
+      return ThrowException(ErrnoException(errno, "accept"));
+    }
+
+    if (count == 0) peers = Array::New();
+
+    Local<Object> peer_info = Object::New();
+    peer_info->Set(fd_symbol, Integer::New(peer_fd));
+    ADDRESS_TO_JS(peer_info, address_storage, len);
+    peers->Set(Integer::New(count++), peer_info);
+  }
+
+  if (count == 0) return scope.Close(Null());
+  return scope.Close(peers);
+}
+
+#endif // __POSIX__
+
+
 static Handle<Value> SocketError(const Arguments& args) {
   HandleScope scope;
 
@@ -1096,6 +1291,314 @@ static Handle<Value> RecvFrom(const Arguments& args) {
 }
 
 
+#ifdef __POSIX__
+
+// Most datagrams moved by one recvMany() or sendMany() call.
+#define MAX_MMSG 64
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+# define HAVE_MMSG 1
+#endif
+
+static struct iovec mmsg_iov[MAX_MMSG];
+static struct sockaddr_storage mmsg_addr[MAX_MMSG];
+static socklen_t mmsg_addrlen[MAX_MMSG];
+static size_t mmsg_size[MAX_MMSG];
+static bool mmsg_trunc[MAX_MMSG];
+
+#ifdef HAVE_MMSG
+static struct mmsghdr mmsg_hdr[MAX_MMSG];
+static bool have_mmsg = true;
+#endif
+
+
+// Receives up to count datagrams into the slots set up in mmsg_iov.
+// Returns the number received, or -1 with errno set.
+static int ReceiveBatch(int fd, int count) {
+#ifdef HAVE_MMSG
+  if (have_mmsg) {
+    for (int i = 0; i < count; i++) {
+      memset(&mmsg_hdr[i], 0, sizeof(mmsg_hdr[i]));
+      mmsg_hdr[i].msg_hdr.msg_iov = &mmsg_iov[i];
+      mmsg_hdr[i].msg_hdr.msg_iovlen = 1;
+      mmsg_hdr[i].msg_hdr.msg_name = &mmsg_addr[i];
+      mmsg_hdr[i].msg_hdr.msg_namelen = sizeof(mmsg_addr[i]);
+    }
+
+    int r;
+    do {
+      r = recvmmsg(fd, mmsg_hdr, count, MSG_DONTWAIT, NULL);
+    } while (r < 0 && errno == EINTR);
+
+    if (r >= 0) {
+      for (int i = 0; i < r; i++) {
+        mmsg_size[i] = mmsg_hdr[i].msg_len;
+        mmsg_addrlen[i] = mmsg_hdr[i].msg_hdr.msg_namelen;
+        mmsg_trunc[i] = (mmsg_hdr[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+      }
+      return r;
+    }
+
+    if (errno != ENOSYS) return -1;
+    have_mmsg = false;
+  }
+#endif
+
+  int n = 0;
+  while (n < count) {
+    // recvmsg() rather than recvfrom() for msg_flags.
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &mmsg_iov[n];
+    msg.msg_iovlen = 1;
+    msg.msg_name = &mmsg_addr[n];
+    msg.msg_namelen = sizeof(mmsg_addr[n]);
+
+    ssize_t r = recvmsg(fd, &msg, 0);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      if (n > 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      return n > 0 ? n : -1;
+    }
+    mmsg_addrlen[n] = msg.msg_namelen;
+    mmsg_trunc[n] = (msg.msg_flags & MSG_TRUNC) != 0;
+    mmsg_size[n++] = r;
+  }
+  return n;
+}
+
+
+//  var info = t.recvMany(fd, buffer, offset, length, count);
+//    info.offsets   // where each datagram starts, relative to offset
+//    info.lengths   // size of each datagram
+//    info.from      // sender of each datagram: { address, port }
+//    info.truncated // true for each datagram that did not fit its slot
+//    info.size      // total bytes read
+//
+// Reads up to count datagrams in one system call where recvmmsg() is
+// available. buffer[offset, offset + length) is split into count equal
+// slots; datagrams larger than a slot are cut short (MSG_TRUNC), which
+// info.truncated reports. The datagrams are packed together afterwards, so
+// info.size bytes starting at offset are used. Consecutive datagrams from
+// the same sender share one 'from' object.
+//
+// Returns null on EAGAIN or EINTR, raises an exception on all other errors.
+static Handle<Value> RecvMany(const Arguments& args) {
+  HandleScope scope;
+
+  if (args.Length() < 5) {
+    return ThrowException(Exception::TypeError(
+          String::New("Takes 5 parameters")));
+  }
+
+  FD_ARG(args[0])
+
+  if (!Buffer::HasInstance(args[1])) {
+    return ThrowException(Exception::TypeError(
+          String::New("Second argument should be a buffer")));
+  }
+
+  Local<Object> buffer_obj = args[1]->ToObject();
+  char *buffer_data = Buffer::Data(buffer_obj);
+  size_t buffer_length = Buffer::Length(buffer_obj);
+
+  size_t off = args[2]->Int32Value();
+  if (off >= buffer_length) {
+    return ThrowException(Exception::Error(
+          String::New("Offset is out of bounds")));
+  }
+
+  size_t len = args[3]->Int32Value();
+  if (off + len > buffer_length) {
+    return ThrowException(Exception::Error(
+          String::New("Length is extends beyond buffer")));
+  }
+
+  int count = args[4]->Int32Value();
+  if (count < 1) count = 1;
+  if (count > MAX_MMSG) count = MAX_MMSG;
+
+  size_t slot = len / count;
+  if (slot == 0) {
+    return ThrowException(Exception::Error(
+          String::New("Length too small for the number of datagrams")));
+  }
+
+  for (int i = 0; i < count; i++) {
+    mmsg_iov[i].iov_base = buffer_data + off + i * slot;
+    mmsg_iov[i].iov_len = slot;
+  }
+
+  int n = ReceiveBatch(fd, count);
+
+  if (n < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return Null();
+    }
+    return ThrowException(ErrnoException(errno, "recvmmsg"));
+  }
+
+  Local<Array> offsets = Array::New(n);
+  Local<Array> lengths = Array::New(n);
+  Local<Array> from = Array::New(n);
+  Local<Array> truncated = Array::New(n);
+  Local<Object> last_from;
+
+  size_t used = 0;
+  for (int i = 0; i < n; i++) {
+    // Slot 0 is already in place and every later slot starts past 'used'.
+    char *dst = buffer_data + off + used;
+    if (dst != mmsg_iov[i].iov_base) {
+      memmove(dst, mmsg_iov[i].iov_base, mmsg_size[i]);
+    }
+
+    offsets->Set(Integer::New(i), Integer::New(used));
+    lengths->Set(Integer::New(i), Integer::New(mmsg_size[i]));
+    truncated->Set(Integer::New(i), mmsg_trunc[i] ? True() : False());
+    used += mmsg_size[i];
+
+    if (i == 0 ||
+        mmsg_addrlen[i] != mmsg_addrlen[i - 1] ||
+        memcmp(&mmsg_addr[i], &mmsg_addr[i - 1], mmsg_addrlen[i]) != 0) {
+      last_from = Object::New();
+      ADDRESS_TO_JS(last_from, mmsg_addr[i], mmsg_addrlen[i]);
+    }
+    from->Set(Integer::New(i), last_from);
+  }
+
+  Local<Object> info = Object::New();
+  info->Set(offsets_symbol, offsets);
+  info->Set(lengths_symbol, lengths);
+  info->Set(from_symbol, from);
+  info->Set(truncated_symbol, truncated);
+  info->Set(size_symbol, Integer::New(used));
+
+  return scope.Close(info);
+}
+
+
+// var sent = t.sendMany(fd, messages);
+// if (sent < messages.length) {
+//   error = t.sendMany.errno;
+// }
+//
+// messages is an array of [buffer, offset, length, port, address] tuples
+// (or [buffer, offset, length, path] for UNIX datagram sockets). They go
+// out with one sendmmsg() where available.
+//
+// Returns the number of datagrams sent. Sending stops at the first message
+// that fails, EAGAIN when the socket buffer is full or EMSGSIZE, say, and
+// its errno is left in sendMany.errno (0 if everything was sent), the way
+// recvMsg() leaves a received fd in recvMsg.fd.
+static Handle<Value> SendMany(const Arguments& args) {
+  HandleScope scope;
+
+  FD_ARG(args[0])
+
+  if (!args[1]->IsArray()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Second argument should be an array")));
+  }
+
+  Local<Array> messages = Local<Array>::Cast(args[1]);
+  int count = messages->Length();
+  if (count > MAX_MMSG) count = MAX_MMSG;
+
+  for (int i = 0; i < count; i++) {
+    Local<Value> v = messages->Get(Integer::New(i));
+    if (!v->IsArray()) {
+      return ThrowException(Exception::TypeError(
+            String::New("Each message should be an array")));
+    }
+    Local<Array> m = Local<Array>::Cast(v);
+
+    Local<Value> b = m->Get(Integer::New(0));
+    if (!Buffer::HasInstance(b)) {
+      return ThrowException(Exception::TypeError(
+            String::New("Message data should be a buffer")));
+    }
+
+    Local<Object> buffer_obj = b->ToObject();
+    size_t buffer_length = Buffer::Length(buffer_obj);
+    size_t offset = m->Get(Integer::New(1))->Uint32Value();
+    size_t length = m->Get(Integer::New(2))->Uint32Value();
+    if (offset > buffer_length || offset + length > buffer_length) {
+      return ThrowException(Exception::Error(
+            String::New("offset + length beyond buffer length")));
+    }
+
+    mmsg_iov[i].iov_base = Buffer::Data(buffer_obj) + offset;
+    mmsg_iov[i].iov_len = length;
+
+    Handle<Value> error = ParseAddressArgs(m->Get(Integer::New(3)),
+                                           m->Get(Integer::New(4)),
+                                           false);
+    if (!error.IsEmpty()) return ThrowException(error);
+
+    memcpy(&mmsg_addr[i], addr, addrlen);
+    mmsg_addrlen[i] = addrlen;
+  }
+
+  int sent = 0;
+  int err = 0;
+
+#ifdef HAVE_MMSG
+  if (have_mmsg) {
+    for (int i = 0; i < count; i++) {
+      memset(&mmsg_hdr[i], 0, sizeof(mmsg_hdr[i]));
+      mmsg_hdr[i].msg_hdr.msg_iov = &mmsg_iov[i];
+      mmsg_hdr[i].msg_hdr.msg_iovlen = 1;
+      mmsg_hdr[i].msg_hdr.msg_name = &mmsg_addr[i];
+      mmsg_hdr[i].msg_hdr.msg_namelen = mmsg_addrlen[i];
+    }
+
+    // sendmmsg() drops the error of a message that fails after others
+    // went out, so the rest is sent again: the failing message then
+    // comes first and reports its own errno.
+    while (sent < count) {
+      int r = sendmmsg(fd, mmsg_hdr + sent, count - sent, 0);
+      if (r < 0) {
+        if (errno == EINTR) continue;
+        if (errno == ENOSYS && sent == 0) {
+          have_mmsg = false;
+        } else {
+          err = errno;
+        }
+        break;
+      }
+      if (r == 0) {
+        err = EAGAIN;
+        break;
+      }
+      sent += r;
+    }
+  }
+
+  if (!have_mmsg)
+#endif
+  {
+    while (sent < count) {
+      ssize_t r = sendto(fd, mmsg_iov[sent].iov_base, mmsg_iov[sent].iov_len,
+                         0, (struct sockaddr *) &mmsg_addr[sent],
+                         mmsg_addrlen[sent]);
+      if (r < 0) {
+        if (errno == EINTR) continue;
+        err = errno;
+        break;
+      }
+      sent++;
+    }
+  }
+
+  if (err == EWOULDBLOCK) err = EAGAIN;
+  send_many_template->GetFunction()->Set(errno_symbol, Integer::New(err));
+
+  return scope.Close(Integer::New(sent));
+}
+
+#endif // __POSIX__
+
+
 #ifdef __POSIX__
 
 // bytesRead = t.recvMsg(fd, buffer, offset, length)
@@ -1323,6 +1826,55 @@ static Handle<Value> SendMsg(const Arguments& args) {
   return scope.Close(Integer::New(written));
 }
 
+
+#define MAX_WRITEV 64
+
+// var bytes = t.writev(fd, buffers);
+//
+// Writes an array of buffers with one writev() call, so that e.g. an HTTP
+// header and its body leave in the same packet without being copied
+// together first. At most MAX_WRITEV buffers are written per call.
+//
+// Returns the number of bytes written, null on EAGAIN or EINTR, raises an
+// exception on all other errors.
+static Handle<Value> Writev(const Arguments& args) {
+  HandleScope scope;
+
+  struct iovec iov[MAX_WRITEV];
+
+  FD_ARG(args[0])
+
+  if (!args[1]->IsArray()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Second argument should be an array")));
+  }
+
+  Local<Array> buffers = Local<Array>::Cast(args[1]);
+  int count = buffers->Length();
+  if (count > MAX_WRITEV) count = MAX_WRITEV;
+
+  for (int i = 0; i < count; i++) {
+    Local<Value> b = buffers->Get(Integer::New(i));
+    if (!Buffer::HasInstance(b)) {
+      return ThrowException(Exception::TypeError(
+            String::New("Array should contain only buffers")));
+    }
+
+    Local<Object> buffer_obj = b->ToObject();
+    iov[i].iov_base = Buffer::Data(buffer_obj);
+    iov[i].iov_len = Buffer::Length(buffer_obj);
+  }
+
+  ssize_t written = writev(fd, iov, count);
+
+  if (written < 0) {
+    if (errno == EAGAIN || errno == EINTR) return Null();
+    return ThrowException(ErrnoException(errno, "writev"));
+  }
+
+  return scope.Close(Integer::New(written));
+}
+
 #endif // __POSIX__
 
 
@@ -1908,9 +2460,17 @@ void InitNet(Handle<Object> target) {
   NODE_SET_METHOD(target, "read", Read);
   NODE_SET_METHOD(target, "sendto", SendTo);
   NODE_SET_METHOD(target, "recvfrom", RecvFrom);
+#ifdef __POSIX__
+  send_many_template =
+      Persistent<FunctionTemplate>::New(FunctionTemplate::New(SendMany));
+  target->Set(String::NewSymbol("sendMany"),
+              send_many_template->GetFunction());
+  NODE_SET_METHOD(target, "recvMany", RecvMany);
+#endif // __POSIX__
 
 #ifdef __POSIX__
   NODE_SET_METHOD(target, "sendMsg", SendMsg);
+  NODE_SET_METHOD(target, "writev", Writev);
 
   recv_msg_template =
       Persistent<FunctionTemplate>::New(FunctionTemplate::New(RecvMsg));
@@ -1930,6 +2490,9 @@ void InitNet(Handle<Object> target) {
   NODE_SET_METHOD(target, "bind", Bind);
   NODE_SET_METHOD(target, "listen", Listen);
   NODE_SET_METHOD(target, "accept", Accept);
+#ifdef __POSIX__
+  NODE_SET_METHOD(target, "acceptMany", AcceptMany);
+#endif // __POSIX__
   NODE_SET_METHOD(target, "socketError", SocketError);
   NODE_SET_METHOD(target, "toRead", ToRead);
   NODE_SET_METHOD(target, "setNoDelay", SetNoDelay);
@@ -1948,12 +2511,27 @@ void InitNet(Handle<Object> target) {
   NODE_SET_METHOD(target, "isIP", IsIP);
   NODE_SET_METHOD(target, "errnoException", CreateErrnoException);
 
+#ifdef SO_REUSEPORT
+  target->Set(String::NewSymbol("hasReusePort"), True());
+#else
+  target->Set(String::NewSymbol("hasReusePort"), False());
+#endif
+
   errno_symbol          = NODE_PSYMBOL("errno");
   syscall_symbol        = NODE_PSYMBOL("syscall");
   fd_symbol             = NODE_PSYMBOL("fd");
   size_symbol           = NODE_PSYMBOL("size");
   address_symbol        = NODE_PSYMBOL("address");
   port_symbol           = NODE_PSYMBOL("port");
+  rejected_symbol       = NODE_PSYMBOL("rejected");
+  offsets_symbol        = NODE_PSYMBOL("offsets");
+  lengths_symbol        = NODE_PSYMBOL("lengths");
+  from_symbol           = NODE_PSYMBOL("from");
+  truncated_symbol      = NODE_PSYMBOL("truncated");
+
+#ifdef __POSIX__
+  OpenReserveFD();
+#endif // __POSIX__
 }
 
 }  // namespace node
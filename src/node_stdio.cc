@@ -1,10 +1,14 @@
 #include <node_stdio.h>
 #include <node_events.h>
+#include <node_buffer.h>
 
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/time.h>
 #if defined(__APPLE__) || defined(__OpenBSD__)
 # include <util.h>
 #elif __FreeBSD__
@@ -172,6 +176,352 @@ WriteError (const Arguments& args)
 }
 
 
+// Buffered stdout.
+//
+// Writes are copied into a bounded ring buffer and return immediately; a
+// helper thread drains the ring into the fd with plain write()s, so a slow
+// pipe never stalls the event loop. When the ring is full the writer
+// either discards the write and counts it (DROP, the default) or waits for
+// room on the calling thread (BLOCK). Stdio::Flush() drains what it can
+// before exit. stderr is not buffered: it has to get out even if the
+// process aborts.
+class StdioWriter {
+ public:
+  enum Policy { BLOCK, DROP };
+
+  static const size_t kDefaultSize = 64 * 1024;
+  // How long Flush() waits for a reader that has stopped reading.
+  static const int kFlushTimeout = 2000;  // ms
+  // How long an fd may keep failing with EIO before writes give up.
+  static const int kMaxEIORetries = 1000;  // 100us apart
+
+  StdioWriter(int fd) : fd_(fd), policy_(DROP), size_(kDefaultSize),
+                        head_(0), tail_(0), dropped_(0), error_(0),
+                        started_(false) {
+    ring_ = new char[size_];
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&data_cond_, NULL);
+    pthread_cond_init(&space_cond_, NULL);
+  }
+
+  // Returns false if the data was dropped.
+  bool Write(const char* data, size_t len) {
+    pthread_mutex_lock(&mutex_);
+
+    if (error_ || (policy_ == DROP && size_ - Buffered() < len)) {
+      dropped_ += len;
+      pthread_mutex_unlock(&mutex_);
+      return false;
+    }
+
+    if (!Start()) {
+      // No helper thread; write synchronously like writeError does.
+      pthread_mutex_unlock(&mutex_);
+      while (len > 0) {
+        ssize_t r = WriteOut(data, len);
+        if (r < 0) {
+          error_ = errno;
+          return false;
+        }
+        data += r;
+        len -= r;
+      }
+      return true;
+    }
+
+    while (len > 0) {
+      while (Buffered() == size_ && !error_) {
+        pthread_cond_wait(&space_cond_, &mutex_);
+      }
+      if (error_) break;
+
+      size_t offset = head_ % size_;
+      size_t n = size_ - Buffered();
+      if (n > size_ - offset) n = size_ - offset;
+      if (n > len) n = len;
+
+      memcpy(ring_ + offset, data, n);
+      head_ += n;
+      data += n;
+      len -= n;
+
+      pthread_cond_signal(&data_cond_);
+    }
+
+    pthread_mutex_unlock(&mutex_);
+    return true;
+  }
+
+  // Waits until the helper thread has written everything out, or for at
+  // most timeout milliseconds. Returns false if data is left over.
+  bool Flush(int timeout) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + timeout / 1000;
+    deadline.tv_nsec = now.tv_usec * 1000 + (timeout % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&mutex_);
+    while (Buffered() > 0 && !error_) {
+      if (pthread_cond_timedwait(&space_cond_, &mutex_, &deadline) ==
+          ETIMEDOUT) {
+        break;
+      }
+    }
+    bool r = Buffered() == 0;
+    pthread_mutex_unlock(&mutex_);
+    return r;
+  }
+
+  // Resizing drains the ring first; if that does not finish in time the
+  // old size is kept.
+  void Configure(Policy policy, size_t size) {
+    Flush(kFlushTimeout);
+    pthread_mutex_lock(&mutex_);
+    policy_ = policy;
+    if (size != size_ && Buffered() == 0) {
+      delete [] ring_;
+      ring_ = new char[size];
+      size_ = size;
+      head_ = tail_ = 0;
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  size_t buffered() {
+    pthread_mutex_lock(&mutex_);
+    size_t n = Buffered();
+    pthread_mutex_unlock(&mutex_);
+    return n;
+  }
+
+  // The errno of the first failed write(), or 0. Once set, writes are
+  // discarded.
+  int error() {
+    pthread_mutex_lock(&mutex_);
+    int r = error_;
+    pthread_mutex_unlock(&mutex_);
+    return r;
+  }
+
+  double dropped() const { return dropped_; }
+  Policy policy() const { return policy_; }
+  size_t size() const { return size_; }
+
+ private:
+  size_t Buffered() const { return head_ - tail_; }
+
+  // Called with the mutex held. Returns false if there is no helper
+  // thread and the caller has to write for itself.
+  bool Start() {
+    if (started_) return true;
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    started_ = pthread_create(&thread, &attr, Run, this) == 0;
+    pthread_attr_destroy(&attr);
+
+    return started_;
+  }
+
+  static void* Run(void* arg) {
+    static_cast<StdioWriter*>(arg)->Loop();
+    return NULL;
+  }
+
+  void Loop() {
+    pthread_mutex_lock(&mutex_);
+
+    for (;;) {
+      while (Buffered() == 0) {
+        pthread_cond_wait(&data_cond_, &mutex_);
+      }
+
+      size_t offset = tail_ % size_;
+      size_t n = Buffered();
+      if (n > size_ - offset) n = size_ - offset;
+      const char* chunk = ring_ + offset;
+
+      pthread_mutex_unlock(&mutex_);
+      ssize_t r = WriteOut(chunk, n);
+      pthread_mutex_lock(&mutex_);
+
+      if (r < 0) {
+        // Nobody is listening any more (EPIPE and friends). Throw away
+        // what is buffered so that writers and Flush() do not wait on it.
+        error_ = errno;
+        tail_ = head_;
+      } else {
+        tail_ += r;
+      }
+
+      pthread_cond_broadcast(&space_cond_);
+    }
+  }
+
+  ssize_t WriteOut(const char* data, size_t len) {
+    int eio_retries = 0;
+
+    for (;;) {
+      ssize_t r = write(fd_, data, len);
+      if (r >= 0) return r;
+
+      if (errno == EINTR) continue;
+
+      // The fd may have been made non-blocking by someone else, for
+      // example a tty shared with stdin.
+      if (errno == EAGAIN) {
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLOUT;
+        poll(&pfd, 1, -1);
+        continue;
+      }
+
+      // A terminal that is going away can fail with EIO for a while.
+      if (errno == EIO && ++eio_retries < kMaxEIORetries) {
+        usleep(100);
+        continue;
+      }
+
+      return -1;
+    }
+  }
+
+  int fd_;
+  Policy policy_;
+  char* ring_;
+  size_t size_;
+  // Total bytes ever added and removed; the ring offset is taken modulo
+  // size_.
+  size_t head_;
+  size_t tail_;
+  double dropped_;
+  int error_;
+  bool started_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t data_cond_;
+  pthread_cond_t space_cond_;
+};
+
+
+static StdioWriter* writers[STDOUT_FILENO + 1];
+
+
+static StdioWriter* GetWriter(Handle<Value> fd_v) {
+  int fd = fd_v->Int32Value();
+  if (fd != STDOUT_FILENO) return NULL;
+  if (writers[fd] == NULL) writers[fd] = new StdioWriter(fd);
+  return writers[fd];
+}
+
+
+#define THROW_BAD_FD \
+    return ThrowException(Exception::TypeError( \
+          String::New("Only stdout can be buffered")))
+
+
+// process.binding('stdio').writeBuffered(fd, buffer)
+// Returns false if the data was dropped. Throws if an earlier write to
+// the fd failed; the error is reported from the next call after the
+// helper thread has seen it.
+static Handle<Value> WriteBuffered(const Arguments& args) {
+  HandleScope scope;
+
+  StdioWriter* writer = GetWriter(args[0]);
+  if (writer == NULL) THROW_BAD_FD;
+
+  if (!Buffer::HasInstance(args[1])) {
+    return ThrowException(Exception::TypeError(
+          String::New("Second argument must be a buffer")));
+  }
+
+  Local<Object> buffer_obj = args[1]->ToObject();
+  bool r = writer->Write(Buffer::Data(buffer_obj),
+                         Buffer::Length(buffer_obj));
+
+  int err = writer->error();
+  if (err) return ThrowException(ErrnoException(err, "write"));
+
+  return scope.Close(r ? True() : False());
+}
+
+
+// process.binding('stdio').setWriterPolicy(fd, 'drop' | 'block', [size])
+static Handle<Value> SetWriterPolicy(const Arguments& args) {
+  HandleScope scope;
+
+  StdioWriter* writer = GetWriter(args[0]);
+  if (writer == NULL) THROW_BAD_FD;
+
+  String::Utf8Value policy_s(args[1]);
+  StdioWriter::Policy policy;
+  if (strcmp(*policy_s, "block") == 0) {
+    policy = StdioWriter::BLOCK;
+  } else if (strcmp(*policy_s, "drop") == 0) {
+    policy = StdioWriter::DROP;
+  } else {
+    return ThrowException(Exception::TypeError(
+          String::New("Policy must be 'block' or 'drop'")));
+  }
+
+  size_t size = writer->size();
+  if (args[2]->IsNumber()) {
+    int64_t n = args[2]->IntegerValue();
+    if (n < 1) {
+      return ThrowException(Exception::RangeError(
+            String::New("Buffer size must be positive")));
+    }
+    size = static_cast<size_t>(n);
+  }
+
+  writer->Configure(policy, size);
+
+  return Undefined();
+}
+
+
+// process.binding('stdio').getWriterStats(fd)
+static Handle<Value> GetWriterStats(const Arguments& args) {
+  HandleScope scope;
+
+  StdioWriter* writer = GetWriter(args[0]);
+  if (writer == NULL) THROW_BAD_FD;
+
+  Local<Object> stats = Object::New();
+  stats->Set(String::NewSymbol("policy"),
+             String::New(writer->policy() == StdioWriter::DROP ? "drop"
+                                                               : "block"));
+  stats->Set(String::NewSymbol("size"), Integer::NewFromUnsigned(writer->size()));
+  stats->Set(String::NewSymbol("buffered"),
+             Integer::NewFromUnsigned(writer->buffered()));
+  stats->Set(String::NewSymbol("dropped"), Number::New(writer->dropped()));
+
+  return scope.Close(stats);
+}
+
+
+void Stdio::Drain() {
+  StdioWriter* writer = writers[STDOUT_FILENO];
+  if (writer == NULL) return;
+
+  if (!writer->Flush(StdioWriter::kFlushTimeout)) {
+    fprintf(stderr, "node: gave up waiting for %u bytes of stdout\n",
+            static_cast<unsigned>(writer->buffered()));
+  } else if (writer->error() && writer->error() != EPIPE) {
+    // EPIPE just means the reader is done, as with `node script | head`.
+    fprintf(stderr, "node: writing to stdout failed: %s\n",
+            strerror(writer->error()));
+  }
+}
+
+
 static Handle<Value> OpenStdin(const Arguments& args) {
   HandleScope scope;
 
@@ -255,6 +605,8 @@ typedef void (*sighandler)(int);
 
 
 void Stdio::Flush() {
+  Drain();
+
   if (stdin_flags != -1) {
     fcntl(STDIN_FILENO, F_SETFL, stdin_flags & ~O_NONBLOCK);
   }
@@ -290,6 +642,9 @@ void Stdio::Initialize(v8::Handle<v8::Object> target) {
   target->Set(String::NewSymbol("stdinFD"), Integer::New(STDIN_FILENO));
 
   NODE_SET_METHOD(target, "writeError", WriteError);
+  NODE_SET_METHOD(target, "writeBuffered", WriteBuffered);
+  NODE_SET_METHOD(target, "setWriterPolicy", SetWriterPolicy);
+  NODE_SET_METHOD(target, "getWriterStats", GetWriterStats);
   NODE_SET_METHOD(target, "openStdin", OpenStdin);
   NODE_SET_METHOD(target, "isStdoutBlocking", IsStdoutBlocking);
   NODE_SET_METHOD(target, "isStdinBlocking", IsStdinBlocking);
@@ -10,6 +10,8 @@ class Stdio  {
 public:
   static void Initialize (v8::Handle<v8::Object> target);
   static void Flush ();
+  // Blocks until buffered stdout/stderr writes have reached their fds.
+  static void Drain ();
   static void DisableRawMode(int fd);
 };
 
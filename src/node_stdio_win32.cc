@@ -127,6 +127,10 @@ void Stdio::Flush() {
 }
 
 
+void Stdio::Drain() {
+}
+
+
 /*
  * STDERR should always be blocking
  */
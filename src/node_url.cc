@@ -0,0 +1,451 @@
+#include <node_url.h>
+
+#include <v8.h>
+#include <node.h>
+#include <node_buffer.h>
+
+#include <string.h>  /* memcmp() */
+
+// Native helpers for lib/url.js and lib/querystring.js.
+//
+// parse() splits a URL into its components with a single scan and no
+// regular expressions. parseQueryString() splits a query string, decodes
+// every key and value and builds the result object in one pass over the
+// bytes, instead of String.split() plus a Buffer per component.
+
+
+namespace node {
+
+using namespace v8;
+
+
+// The bytes of a Buffer, or of a string encoded as UTF-8.
+class InputBytes {
+ public:
+  explicit InputBytes(Handle<Value> value) : data_(NULL), length_(0),
+                                             heap_(NULL) {
+    if (Buffer::HasInstance(value)) {
+      Local<Object> buffer_obj = value->ToObject();
+      data_ = Buffer::Data(buffer_obj);
+      length_ = Buffer::Length(buffer_obj);
+      return;
+    }
+
+    Local<String> s = value->ToString();
+    // Room for the worst case and the NUL WriteUtf8 always appends then.
+    size_t size = s->Length() * 3 + 1;
+    char* p = size <= sizeof(stack_) ? stack_ : (heap_ = new char[size]);
+    length_ = s->WriteUtf8(p, size, NULL, String::HINT_MANY_WRITES_EXPECTED)
+              - 1;
+    data_ = p;
+  }
+
+  ~InputBytes() {
+    delete [] heap_;
+  }
+
+  const char* data() const { return data_; }
+  size_t length() const { return length_; }
+
+ private:
+  const char* data_;
+  size_t length_;
+  char* heap_;
+  char stack_[1024];
+};
+
+
+static inline int Unhex(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+
+// Decodes %XX escapes, and '+' to a space if decode_spaces is set. A '%'
+// that does not start a valid escape is copied along with the characters
+// that were looked at, as QueryString.unescapeBuffer always did. The
+// output is never longer than the input. Returns the bytes written.
+static size_t Unescape(const char* s, size_t len, char* out,
+                       bool decode_spaces) {
+  size_t o = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    char c = s[i];
+
+    if (c == '+' && decode_spaces) {
+      out[o++] = ' ';
+      continue;
+    }
+
+    if (c != '%') {
+      out[o++] = c;
+      continue;
+    }
+
+    out[o++] = '%';
+    if (i + 1 == len) break;
+
+    int n = Unhex(s[++i]);
+    if (n < 0 || i + 1 == len) {
+      out[o++] = s[i];
+      continue;
+    }
+
+    int m = Unhex(s[++i]);
+    if (m < 0) {
+      out[o++] = s[i - 1];
+      out[o++] = s[i];
+      continue;
+    }
+
+    out[o - 1] = static_cast<char>(n * 16 + m);
+  }
+
+  return o;
+}
+
+
+static inline Local<String> Decode(const char* s, size_t len, char* scratch) {
+  return String::New(scratch, Unescape(s, len, scratch, true));
+}
+
+
+// First occurrence of needle in [s, s + len), or len.
+static inline size_t Find(const char* s, size_t len,
+                          const char* needle, size_t nlen) {
+  if (nlen == 1) {
+    const char* p = static_cast<const char*>(memchr(s, needle[0], len));
+    return p ? p - s : len;
+  }
+
+  for (size_t i = 0; i + nlen <= len; i++) {
+    if (s[i] == needle[0] && memcmp(s + i, needle, nlen) == 0) return i;
+  }
+
+  return len;
+}
+
+
+// unescapeBuffer(string or buffer, decodeSpaces, out)
+// out must hold at least as many bytes as the input. Returns the number of
+// bytes written to it.
+static Handle<Value> UnescapeBuffer(const Arguments& args) {
+  HandleScope scope;
+
+  if (!Buffer::HasInstance(args[2])) {
+    return ThrowException(Exception::TypeError(
+          String::New("Third argument must be a buffer")));
+  }
+
+  InputBytes in(args[0]);
+  Local<Object> out = args[2]->ToObject();
+
+  if (Buffer::Length(out) < in.length()) {
+    return ThrowException(Exception::RangeError(
+          String::New("Output buffer too small")));
+  }
+
+  size_t len = Unescape(in.data(), in.length(), Buffer::Data(out),
+                        args[1]->BooleanValue());
+
+  return scope.Close(Integer::New(len));
+}
+
+
+// parse(string or buffer, sep, eq)
+//
+// Same result as the old QueryString.parse: a key without eq gets the
+// value '', everything after the first eq is the value, and a key seen
+// again turns into an array of its values.
+static Handle<Value> Parse(const Arguments& args) {
+  HandleScope scope;
+
+  InputBytes in(args[0]);
+  String::Utf8Value sep(args[1]);
+  String::Utf8Value eq(args[2]);
+
+  if (sep.length() == 0 || eq.length() == 0) {
+    return ThrowException(Exception::TypeError(
+          String::New("Separators must not be empty")));
+  }
+
+  Local<Object> obj = Object::New();
+
+  const char* s = in.data();
+  size_t len = in.length();
+  if (len == 0) return scope.Close(obj);
+
+  char stack_scratch[1024];
+  char* scratch = len <= sizeof(stack_scratch) ? stack_scratch
+                                                : new char[len];
+
+  size_t pos = 0;
+
+  for (;;) {
+    size_t end = pos + Find(s + pos, len - pos, *sep, sep.length());
+    size_t kvp_len = end - pos;
+    size_t key_len = Find(s + pos, kvp_len, *eq, eq.length());
+
+    Local<String> key = Decode(s + pos, key_len, scratch);
+    Local<String> value;
+    if (key_len == kvp_len) {
+      value = String::Empty();
+    } else {
+      size_t value_start = key_len + eq.length();
+      value = Decode(s + pos + value_start, kvp_len - value_start, scratch);
+    }
+
+    if (!obj->Has(key)) {
+      obj->Set(key, value);
+    } else {
+      Local<Value> existing = obj->Get(key);
+      if (existing->IsArray()) {
+        Local<Array> values = Local<Array>::Cast(existing);
+        values->Set(values->Length(), value);
+      } else {
+        Local<Array> values = Array::New(2);
+        values->Set(0, existing);
+        values->Set(1, value);
+        obj->Set(key, values);
+      }
+    }
+
+    if (end == len) break;
+    pos = end + sep.length();
+  }
+
+  if (scratch != stack_scratch) delete [] scratch;
+
+  return scope.Close(obj);
+}
+
+
+static Persistent<String> href_sym;
+static Persistent<String> protocol_sym;
+static Persistent<String> slashes_sym;
+static Persistent<String> host_sym;
+static Persistent<String> auth_sym;
+static Persistent<String> port_sym;
+static Persistent<String> hostname_sym;
+static Persistent<String> hash_sym;
+static Persistent<String> search_sym;
+static Persistent<String> query_sym;
+static Persistent<String> pathname_sym;
+
+
+// A component of the URL as a [start, end) range, or absent.
+struct UrlRange {
+  UrlRange() : start(0), end(0), present(false) {}
+
+  void Set(size_t s, size_t e) {
+    start = s;
+    end = e;
+    present = true;
+  }
+
+  size_t start;
+  size_t end;
+  bool present;
+};
+
+
+struct UrlParts {
+  UrlParts() : slashes(false) {}
+
+  UrlRange protocol;
+  bool slashes;
+  UrlRange host;
+  UrlRange auth;
+  UrlRange port;
+  UrlRange hostname;  // set, possibly empty, whenever host is
+  UrlRange hash;
+  UrlRange search;
+  UrlRange query;
+  UrlRange pathname;
+};
+
+
+static inline bool IsProtocolChar(uint16_t c) {
+  return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+
+static inline bool IsNonHostChar(uint16_t c) {
+  return c == '/' || c == '?' || c == ';' || c == '#';
+}
+
+
+static inline bool RangeIs(const uint16_t* s, const UrlRange& r,
+                           const char* ascii) {
+  size_t i = r.start;
+  for (; *ascii; ascii++, i++) {
+    if (i == r.end || s[i] != static_cast<uint8_t>(*ascii)) return false;
+  }
+  return i == r.end;
+}
+
+
+// //user@host at the start of a protocol-less URL, which is always taken
+// to name a host: two slashes, then one or more characters other than '@'
+// and '/', an '@', and again one or more of those.
+static bool StartsWithSlashedAuth(const uint16_t* s, size_t i, size_t n) {
+  if (n - i < 2 || s[i] != '/' || s[i + 1] != '/') return false;
+  i += 2;
+
+  size_t start = i;
+  while (i < n && s[i] != '@' && s[i] != '/') i++;
+  if (i == start || i == n || s[i] != '@') return false;
+
+  i++;
+  return i < n && s[i] != '@' && s[i] != '/';
+}
+
+
+// Splits s into the components url.parse() reports. The rules are the
+// ones lib/url.js implemented with regular expressions: a lower case
+// protocol, a host when there are slashes or a non-slashed protocol like
+// mailto:, auth before the first '@' and a port of trailing digits in the
+// host, then the hash, the search and whatever is left as the pathname.
+static void SplitUrl(const uint16_t* s, size_t n, bool slashes_denote_host,
+                     UrlParts* out) {
+  size_t i = 0;
+
+  while (i < n && IsProtocolChar(s[i])) i++;
+  if (i > 0 && i < n && s[i] == ':') {
+    out->protocol.Set(0, ++i);
+  } else {
+    i = 0;
+  }
+
+  bool proto = out->protocol.present;
+  bool hostless = proto && RangeIs(s, out->protocol, "file:");
+  bool slashed_proto = hostless ||
+                       (proto && (RangeIs(s, out->protocol, "http:") ||
+                                  RangeIs(s, out->protocol, "https:") ||
+                                  RangeIs(s, out->protocol, "ftp:") ||
+                                  RangeIs(s, out->protocol, "gopher:")));
+
+  bool slashes = false;
+  if (slashes_denote_host || proto || StartsWithSlashedAuth(s, i, n)) {
+    slashes = n - i >= 2 && s[i] == '/' && s[i + 1] == '/';
+    if (slashes && !hostless) {
+      i += 2;
+      out->slashes = true;
+    }
+  }
+
+  if (!hostless && (slashes || (proto && !slashed_proto))) {
+    size_t host_start = i;
+    while (i < n && !IsNonHostChar(s[i])) i++;
+    out->host.Set(host_start, i);
+
+    size_t name_start = host_start;
+    for (size_t j = host_start; j < i; j++) {
+      if (s[j] == '@') {
+        out->auth.Set(host_start, j);
+        name_start = j + 1;
+        break;
+      }
+    }
+
+    size_t name_end = i;
+    size_t j = i;
+    while (j > name_start && s[j - 1] >= '0' && s[j - 1] <= '9') j--;
+    if (j < i && j > name_start && s[j - 1] == ':') {
+      out->port.Set(j, i);
+      name_end = j - 1;
+    }
+
+    out->hostname.Set(name_start, name_end);
+  }
+
+  size_t end = n;
+
+  for (size_t j = i; j < end; j++) {
+    if (s[j] == '#') {
+      out->hash.Set(j, end);
+      end = j;
+      break;
+    }
+  }
+
+  for (size_t j = i; j < end; j++) {
+    if (s[j] == '?') {
+      out->search.Set(j, end);
+      out->query.Set(j + 1, end);
+      end = j;
+      break;
+    }
+  }
+
+  if (i < end) out->pathname.Set(i, end);
+}
+
+
+static inline void SetRange(Local<Object> obj, Persistent<String> sym,
+                            const uint16_t* s, const UrlRange& r) {
+  if (r.present) {
+    obj->Set(sym, String::New(s + r.start, r.end - r.start));
+  }
+}
+
+
+// parse(url, slashesDenoteHost)
+// The query is left as a string; lib/url.js hands it to querystring.
+static Handle<Value> ParseUrl(const Arguments& args) {
+  HandleScope scope;
+
+  if (!args[0]->IsString()) {
+    return ThrowException(Exception::TypeError(
+          String::New("Parameter 'url' must be a string")));
+  }
+
+  Local<String> url = args[0]->ToString();
+  String::Value value(url);
+  const uint16_t* s = *value;
+
+  UrlParts parts;
+  SplitUrl(s, value.length(), args[1]->BooleanValue(), &parts);
+
+  Local<Object> obj = Object::New();
+  obj->Set(href_sym, url);
+  SetRange(obj, protocol_sym, s, parts.protocol);
+  if (parts.slashes) obj->Set(slashes_sym, True());
+  SetRange(obj, host_sym, s, parts.host);
+  SetRange(obj, auth_sym, s, parts.auth);
+  SetRange(obj, port_sym, s, parts.port);
+  SetRange(obj, hostname_sym, s, parts.hostname);
+  SetRange(obj, hash_sym, s, parts.hash);
+  SetRange(obj, search_sym, s, parts.search);
+  SetRange(obj, query_sym, s, parts.query);
+  SetRange(obj, pathname_sym, s, parts.pathname);
+
+  return scope.Close(obj);
+}
+
+
+void InitUrl(Handle<Object> target) {
+  HandleScope scope;
+
+  href_sym = NODE_PSYMBOL("href");
+  protocol_sym = NODE_PSYMBOL("protocol");
+  slashes_sym = NODE_PSYMBOL("slashes");
+  host_sym = NODE_PSYMBOL("host");
+  auth_sym = NODE_PSYMBOL("auth");
+  port_sym = NODE_PSYMBOL("port");
+  hostname_sym = NODE_PSYMBOL("hostname");
+  hash_sym = NODE_PSYMBOL("hash");
+  search_sym = NODE_PSYMBOL("search");
+  query_sym = NODE_PSYMBOL("query");
+  pathname_sym = NODE_PSYMBOL("pathname");
+
+  NODE_SET_METHOD(target, "parse", ParseUrl);
+  NODE_SET_METHOD(target, "unescapeBuffer", UnescapeBuffer);
+  NODE_SET_METHOD(target, "parseQueryString", Parse);
+}
+
+}  // namespace node
+
+NODE_MODULE(node_url, node::InitUrl);
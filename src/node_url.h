@@ -0,0 +1,12 @@
+#ifndef NODE_URL_H_
+#define NODE_URL_H_
+
+#include <v8.h>
+
+namespace node {
+
+void InitUrl(v8::Handle<v8::Object> target);
+
+}
+
+#endif  // NODE_URL_H_
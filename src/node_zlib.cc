@@ -0,0 +1,366 @@
+#include <node_zlib.h>
+
+#include <v8.h>
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <eio.h>
+
+#include <string.h>
+#include <zlib.h>
+
+// Streaming deflate/inflate over the system zlib.
+//
+// A Zlib object owns one z_stream for its whole life. write() runs
+// deflate() or inflate() once from an input Buffer range into an output
+// Buffer range and reports how much of each is left; lib/zlib.js loops
+// while the output fills up. Given a callback, the same call runs on the
+// thread pool instead, which is worth it for large chunks.
+
+
+namespace node {
+
+using namespace v8;
+
+
+enum zlib_mode {
+  DEFLATE = 1,
+  INFLATE,
+  GZIP,
+  GUNZIP,
+  DEFLATERAW,
+  INFLATERAW,
+  UNZIP
+};
+
+
+class Zlib : public ObjectWrap {
+ public:
+  static void Initialize(Handle<Object> target) {
+    HandleScope scope;
+
+    Local<FunctionTemplate> t = FunctionTemplate::New(New);
+
+    t->InstanceTemplate()->SetInternalFieldCount(1);
+
+    NODE_SET_PROTOTYPE_METHOD(t, "init", Init);
+    NODE_SET_PROTOTYPE_METHOD(t, "write", Write);
+    NODE_SET_PROTOTYPE_METHOD(t, "reset", Reset);
+    NODE_SET_PROTOTYPE_METHOD(t, "close", Close);
+
+    target->Set(String::NewSymbol("Zlib"), t->GetFunction());
+  }
+
+ private:
+  Zlib(zlib_mode mode) : ObjectWrap(), mode_(mode), initialized_(false),
+                         pending_(false), flush_(Z_NO_FLUSH), err_(Z_OK) {
+    memset(&strm_, 0, sizeof(strm_));
+  }
+
+  ~Zlib() {
+    End();
+  }
+
+  bool IsDeflate() const {
+    return mode_ == DEFLATE || mode_ == GZIP || mode_ == DEFLATERAW;
+  }
+
+  void End() {
+    if (!initialized_) return;
+    if (IsDeflate()) {
+      deflateEnd(&strm_);
+    } else {
+      inflateEnd(&strm_);
+    }
+    initialized_ = false;
+  }
+
+  int InitStream(int level, int window_bits, int mem_level, int strategy) {
+    switch (mode_) {
+      case GZIP:
+      case GUNZIP:
+        window_bits += 16;
+        break;
+      case UNZIP:
+        window_bits += 32;
+        break;
+      case DEFLATERAW:
+      case INFLATERAW:
+        window_bits = -window_bits;
+        break;
+      default:
+        break;
+    }
+
+    int r;
+    if (IsDeflate()) {
+      r = deflateInit2(&strm_, level, Z_DEFLATED, window_bits, mem_level,
+                       strategy);
+    } else {
+      r = inflateInit2(&strm_, window_bits);
+    }
+
+    initialized_ = r == Z_OK;
+    return r;
+  }
+
+  // Runs on the main thread or on the thread pool.
+  void Process() {
+    if (IsDeflate()) {
+      err_ = deflate(&strm_, flush_);
+    } else {
+      err_ = inflate(&strm_, flush_);
+    }
+  }
+
+  // Under Z_FINISH everything has been handed over, so stopping short of
+  // the end of the stream while there is still room for output means the
+  // input was cut off.
+  bool Truncated() const {
+    return flush_ == Z_FINISH &&
+           (err_ == Z_OK || err_ == Z_BUF_ERROR) &&
+           strm_.avail_out != 0;
+  }
+
+  // Otherwise Z_BUF_ERROR only means that no progress was possible with
+  // the space given; the caller tries again with a fresh output buffer.
+  bool Failed() const {
+    if (Truncated()) return true;
+    return err_ != Z_OK && err_ != Z_STREAM_END && err_ != Z_BUF_ERROR;
+  }
+
+  Local<Value> Error() {
+    int err = err_;
+    const char* msg = strm_.msg;
+    if (Truncated()) {
+      err = Z_BUF_ERROR;
+      msg = "unexpected end of file";
+    }
+    if (msg == NULL) msg = zError(err);
+    Local<Value> e = Exception::Error(String::New(msg));
+    e->ToObject()->Set(String::NewSymbol("errno"), Integer::New(err));
+    return e;
+  }
+
+  static Handle<Value> New(const Arguments& args) {
+    HandleScope scope;
+
+    int mode = args[0]->Int32Value();
+    if (mode < DEFLATE || mode > UNZIP) {
+      return ThrowException(Exception::TypeError(
+            String::New("Bad zlib mode")));
+    }
+
+    Zlib* z = new Zlib(static_cast<zlib_mode>(mode));
+    z->Wrap(args.This());
+    return args.This();
+  }
+
+  // init(level, windowBits, memLevel, strategy)
+  static Handle<Value> Init(const Arguments& args) {
+    HandleScope scope;
+
+    Zlib* z = ObjectWrap::Unwrap<Zlib>(args.This());
+    if (z->pending_) return ThrowBusy();
+
+    z->End();
+    int r = z->InitStream(args[0]->Int32Value(),
+                          args[1]->Int32Value(),
+                          args[2]->Int32Value(),
+                          args[3]->Int32Value());
+    if (r != Z_OK) {
+      z->err_ = r;
+      return ThrowException(z->Error());
+    }
+
+    return Undefined();
+  }
+
+  // write(flush, in, inOffset, inLength, out, outOffset, outLength, [cb])
+  //
+  // Returns [availIn, availOut], the input and output bytes left over. With
+  // a callback, returns nothing and calls cb(err, availIn, availOut) once
+  // the thread pool is done; both Buffers must be left alone until then.
+  static Handle<Value> Write(const Arguments& args) {
+    HandleScope scope;
+
+    Zlib* z = ObjectWrap::Unwrap<Zlib>(args.This());
+    if (!z->initialized_) {
+      return ThrowException(Exception::Error(
+            String::New("Zlib stream is not initialized")));
+    }
+    if (z->pending_) return ThrowBusy();
+
+    if (!Buffer::HasInstance(args[1]) || !Buffer::HasInstance(args[4])) {
+      return ThrowException(Exception::TypeError(
+            String::New("Input and output must be buffers")));
+    }
+
+    Local<Object> in = args[1]->ToObject();
+    Local<Object> out = args[4]->ToObject();
+    size_t in_off = args[2]->Uint32Value();
+    size_t in_len = args[3]->Uint32Value();
+    size_t out_off = args[5]->Uint32Value();
+    size_t out_len = args[6]->Uint32Value();
+
+    if (in_off > Buffer::Length(in) ||
+        in_len > Buffer::Length(in) - in_off ||
+        out_off > Buffer::Length(out) ||
+        out_len > Buffer::Length(out) - out_off) {
+      return ThrowException(Exception::RangeError(
+            String::New("Bad buffer, offset or length")));
+    }
+
+    z->flush_ = args[0]->Int32Value();
+    z->strm_.next_in = reinterpret_cast<Bytef*>(Buffer::Data(in) + in_off);
+    z->strm_.avail_in = in_len;
+    z->strm_.next_out = reinterpret_cast<Bytef*>(Buffer::Data(out) + out_off);
+    z->strm_.avail_out = out_len;
+
+    if (args[7]->IsFunction()) {
+      z->pending_ = true;
+      z->input_ = Persistent<Object>::New(in);
+      z->output_ = Persistent<Object>::New(out);
+      z->callback_ = Persistent<Function>::New(Local<Function>::Cast(args[7]));
+      z->Ref();
+
+      eio_custom(EIO_Process, EIO_PRI_DEFAULT, AfterProcess, z);
+      ev_ref(EV_DEFAULT_UC);
+
+      return Undefined();
+    }
+
+    z->Process();
+    if (z->Failed()) return ThrowException(z->Error());
+
+    Local<Array> result = Array::New(2);
+    result->Set(0, Integer::NewFromUnsigned(z->strm_.avail_in));
+    result->Set(1, Integer::NewFromUnsigned(z->strm_.avail_out));
+    return scope.Close(result);
+  }
+
+  static int EIO_Process(eio_req* req) {
+    static_cast<Zlib*>(req->data)->Process();
+    return 0;
+  }
+
+  static int AfterProcess(eio_req* req) {
+    ev_unref(EV_DEFAULT_UC);
+
+    HandleScope scope;
+
+    Zlib* z = static_cast<Zlib*>(req->data);
+    z->pending_ = false;
+
+    Local<Value> argv[3];
+    if (z->Failed()) {
+      argv[0] = z->Error();
+      argv[1] = Local<Value>::New(Undefined());
+      argv[2] = Local<Value>::New(Undefined());
+    } else {
+      argv[0] = Local<Value>::New(Null());
+      argv[1] = Integer::NewFromUnsigned(z->strm_.avail_in);
+      argv[2] = Integer::NewFromUnsigned(z->strm_.avail_out);
+    }
+
+    Persistent<Function> cb = z->callback_;
+    z->input_.Dispose();
+    z->output_.Dispose();
+    z->input_.Clear();
+    z->output_.Clear();
+    z->callback_.Clear();
+
+    TryCatch try_catch;
+
+    cb->Call(z->handle_, 3, argv);
+
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+
+    cb.Dispose();
+    z->Unref();
+
+    return 0;
+  }
+
+  static Handle<Value> Reset(const Arguments& args) {
+    HandleScope scope;
+
+    Zlib* z = ObjectWrap::Unwrap<Zlib>(args.This());
+    if (z->pending_) return ThrowBusy();
+
+    if (z->initialized_) {
+      z->err_ = z->IsDeflate() ? deflateReset(&z->strm_)
+                               : inflateReset(&z->strm_);
+      if (z->err_ != Z_OK) return ThrowException(z->Error());
+    }
+
+    return Undefined();
+  }
+
+  static Handle<Value> Close(const Arguments& args) {
+    HandleScope scope;
+
+    Zlib* z = ObjectWrap::Unwrap<Zlib>(args.This());
+    if (z->pending_) return ThrowBusy();
+
+    z->End();
+
+    return Undefined();
+  }
+
+  static Handle<Value> ThrowBusy() {
+    return ThrowException(Exception::Error(
+          String::New("An asynchronous operation is in progress")));
+  }
+
+  z_stream strm_;
+  zlib_mode mode_;
+  bool initialized_;
+  bool pending_;
+  int flush_;
+  int err_;
+  Persistent<Object> input_;
+  Persistent<Object> output_;
+  Persistent<Function> callback_;
+};
+
+
+void InitZlib(Handle<Object> target) {
+  HandleScope scope;
+
+  Zlib::Initialize(target);
+
+  NODE_DEFINE_CONSTANT(target, Z_NO_FLUSH);
+  NODE_DEFINE_CONSTANT(target, Z_SYNC_FLUSH);
+  NODE_DEFINE_CONSTANT(target, Z_FULL_FLUSH);
+  NODE_DEFINE_CONSTANT(target, Z_FINISH);
+
+  NODE_DEFINE_CONSTANT(target, Z_OK);
+  NODE_DEFINE_CONSTANT(target, Z_STREAM_END);
+
+  NODE_DEFINE_CONSTANT(target, Z_NO_COMPRESSION);
+  NODE_DEFINE_CONSTANT(target, Z_BEST_SPEED);
+  NODE_DEFINE_CONSTANT(target, Z_BEST_COMPRESSION);
+  NODE_DEFINE_CONSTANT(target, Z_DEFAULT_COMPRESSION);
+  NODE_DEFINE_CONSTANT(target, Z_FILTERED);
+  NODE_DEFINE_CONSTANT(target, Z_HUFFMAN_ONLY);
+  NODE_DEFINE_CONSTANT(target, Z_RLE);
+  NODE_DEFINE_CONSTANT(target, Z_FIXED);
+  NODE_DEFINE_CONSTANT(target, Z_DEFAULT_STRATEGY);
+
+  NODE_DEFINE_CONSTANT(target, DEFLATE);
+  NODE_DEFINE_CONSTANT(target, INFLATE);
+  NODE_DEFINE_CONSTANT(target, GZIP);
+  NODE_DEFINE_CONSTANT(target, GUNZIP);
+  NODE_DEFINE_CONSTANT(target, DEFLATERAW);
+  NODE_DEFINE_CONSTANT(target, INFLATERAW);
+  NODE_DEFINE_CONSTANT(target, UNZIP);
+
+  target->Set(String::NewSymbol("ZLIB_VERSION"), String::New(ZLIB_VERSION));
+}
+
+}  // namespace node
+
+NODE_MODULE(node_zlib, node::InitZlib);
@@ -0,0 +1,12 @@
+#ifndef SRC_NODE_ZLIB_H_
+#define SRC_NODE_ZLIB_H_
+
+#include <v8.h>
+
+namespace node {
+
+void InitZlib(v8::Handle<v8::Object> target);
+
+}  // namespace node
+
+#endif  // SRC_NODE_ZLIB_H_
@@ -0,0 +1,2 @@
+// Dies straight away, as a worker with a startup bug would.
+process.exit(1);
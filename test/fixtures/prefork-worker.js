@@ -0,0 +1,11 @@
+// Worker script for test/simple/test-prefork.js
+var http = require('http');
+var prefork = require('prefork');
+
+var server = http.createServer(function(req, res) {
+  prefork.count('requests');
+  res.writeHead(200, { 'Content-Type': 'text/plain' });
+  res.end(String(process.pid));
+});
+
+prefork.serve(server);
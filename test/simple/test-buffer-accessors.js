@@ -0,0 +1,102 @@
+var common = require('../common');
+var assert = require('assert');
+
+var Buffer = require('buffer').Buffer;
+var SlowBuffer = require('buffer').SlowBuffer;
+
+function test(buf) {
+  buf[0] = 0x01;
+  buf[1] = 0x02;
+  buf[2] = 0x03;
+  buf[3] = 0xfe;
+  buf[4] = 0xff;
+  buf[5] = 0x00;
+  buf[6] = 0x00;
+  buf[7] = 0x80;
+
+  assert.equal(0x01, buf.readUInt8(0));
+  assert.equal(0xfe, buf.readUInt8(3));
+  assert.equal(-2, buf.readInt8(3));
+  assert.equal(0x0102, buf.readUInt16BE(0));
+  assert.equal(0x0201, buf.readUInt16LE(0));
+  assert.equal(-257, buf.readInt16BE(3));
+  assert.equal(-2, buf.readInt16LE(3));
+  assert.equal(0x010203fe, buf.readUInt32BE(0));
+  assert.equal(0xfe030201, buf.readUInt32LE(0));
+  assert.equal(-0x1fcfdff, buf.readInt32LE(0));
+  assert.equal(0xff000080, buf.readUInt32BE(4));
+  assert.equal(-0xffff80, buf.readInt32BE(4));
+
+  // unaligned access
+  assert.equal(0x0203fe, buf.readUInt32BE(1) >>> 8);
+
+  buf.writeUInt16BE(0xbeef, 0);
+  assert.equal(0xbe, buf[0]);
+  assert.equal(0xef, buf[1]);
+  buf.writeUInt16LE(0xbeef, 0);
+  assert.equal(0xef, buf[0]);
+  assert.equal(0xbe, buf[1]);
+
+  buf.writeInt32BE(-1, 0);
+  assert.equal(0xffffffff, buf.readUInt32BE(0));
+  assert.equal(-1, buf.readInt32LE(0));
+
+  buf.writeUInt32LE(0xdeadbeef, 4);
+  assert.equal(0xef, buf[4]);
+  assert.equal(0xde, buf[7]);
+  assert.equal(0xdeadbeef, buf.readUInt32LE(4));
+
+  buf.writeInt8(-128, 2);
+  assert.equal(0x80, buf[2]);
+  assert.equal(-128, buf.readInt8(2));
+  buf.writeUInt8(255, 2);
+  assert.equal(255, buf.readUInt8(2));
+
+  buf.writeFloatBE(1.5, 0);
+  assert.equal(0x3f, buf[0]);
+  assert.equal(0xc0, buf[1]);
+  assert.equal(1.5, buf.readFloatBE(0));
+  buf.writeFloatLE(-0.25, 4);
+  assert.equal(-0.25, buf.readFloatLE(4));
+
+  buf.writeDoubleLE(Math.PI, 0);
+  assert.equal(Math.PI, buf.readDoubleLE(0));
+  buf.writeDoubleBE(1 / 3, 0);
+  assert.equal(0x3f, buf[0]);
+  assert.equal(1 / 3, buf.readDoubleBE(0));
+
+  // the native side always refuses to leave the buffer
+  assert.throws(function() { buf.readUInt32LE(buf.length - 3, true); });
+  assert.throws(function() { buf.readDoubleBE(buf.length - 1); });
+  assert.throws(function() { buf.writeUInt16BE(1, buf.length - 1, true); });
+}
+
+test(new SlowBuffer(8));
+test(new Buffer(8));
+
+// Buffer slices are addressed relative to their own start.
+var parent = new Buffer(16);
+for (var i = 0; i < 16; i++) parent[i] = i;
+var slice = parent.slice(4, 12);
+assert.equal(0x04050607, slice.readUInt32BE(0));
+slice.writeUInt16LE(0xaabb, 6);
+assert.equal(0xbb, parent[10]);
+assert.equal(0xaa, parent[11]);
+
+// A slice checks its own bounds unless noAssert is set.
+assert.throws(function() { slice.readUInt32BE(6); }, RangeError);
+assert.equal(0x0c0d, slice.readUInt16BE(8, true));
+
+// Value range checks
+var b = new Buffer(4);
+assert.throws(function() { b.writeUInt8(256, 0); }, RangeError);
+assert.throws(function() { b.writeInt8(-129, 0); }, RangeError);
+assert.throws(function() { b.writeUInt16LE(-1, 0); }, RangeError);
+assert.throws(function() { b.writeInt32BE(0x80000000, 0); }, RangeError);
+assert.throws(function() { b.writeUInt32BE(1.5, 0); }, TypeError);
+assert.throws(function() { b.writeFloatLE('1', 0); }, TypeError);
+assert.throws(function() { b.readUInt16LE(-1); }, TypeError);
+
+// noAssert lets out of range integers wrap around
+b.writeUInt16LE(0x10001, 0, true);
+assert.equal(1, b.readUInt16LE(0));
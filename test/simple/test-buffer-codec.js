@@ -0,0 +1,111 @@
+var common = require('../common');
+var assert = require('assert');
+
+var Buffer = require('buffer').Buffer;
+var SlowBuffer = require('buffer').SlowBuffer;
+
+assert.ok(/^(avx2|sse2|scalar)$/.test(SlowBuffer.codecKernel));
+
+// Reference encoders used to check the native ones on odd lengths and on
+// inputs long enough to take the vector paths.
+var alphabet = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz' +
+               '0123456789+/';
+
+function refBase64(b) {
+  var out = '';
+  for (var i = 0; i < b.length; i += 3) {
+    var v = (b[i] << 16) | ((i + 1 < b.length ? b[i + 1] : 0) << 8) |
+            (i + 2 < b.length ? b[i + 2] : 0);
+    out += alphabet[v >> 18] + alphabet[(v >> 12) & 63];
+    out += i + 1 < b.length ? alphabet[(v >> 6) & 63] : '=';
+    out += i + 2 < b.length ? alphabet[v & 63] : '=';
+  }
+  return out;
+}
+
+function refHex(b) {
+  var out = '';
+  for (var i = 0; i < b.length; i++) {
+    out += (b[i] < 16 ? '0' : '') + b[i].toString(16);
+  }
+  return out;
+}
+
+var lengths = [0, 1, 2, 3, 15, 16, 17, 27, 28, 29, 31, 32, 33, 100, 1000, 4099];
+
+lengths.forEach(function(n) {
+  var b = new Buffer(n);
+  for (var i = 0; i < n; i++) b[i] = (i * 131 + 7) & 255;
+
+  var b64 = b.toString('base64');
+  assert.equal(refBase64(b), b64);
+
+  var d = new Buffer(n);
+  assert.equal(n, d.write(b64, 0, 'base64'));
+  for (var i = 0; i < n; i++) assert.equal(b[i], d[i]);
+
+  // whitespace in the middle of the input is skipped
+  var wrapped = b64.replace(/(.{76})/g, '$1\r\n');
+  var d2 = new Buffer(n);
+  assert.equal(n, d2.write(wrapped, 0, 'base64'));
+  for (var i = 0; i < n; i++) assert.equal(b[i], d2[i]);
+
+  var hex = b.toString('hex');
+  assert.equal(refHex(b), hex);
+  assert.equal(n, Buffer.byteLength(hex, 'hex'));
+
+  var d3 = new Buffer(n);
+  assert.equal(n, d3.write(hex.toUpperCase(), 0, 'hex'));
+  for (var i = 0; i < n; i++) assert.equal(b[i], d3[i]);
+});
+
+// base64 decoding stops at the first padding character
+assert.equal('a', new Buffer('YQ==YQ==', 'base64').toString());
+assert.equal('ab', new Buffer('YWI=YWJj', 'base64').toString());
+assert.equal(1, new Buffer(4).write('YQ=YWJj', 0, 'base64'));
+
+// 'hex' is accepted wherever the core takes an encoding argument
+var crypto;
+try {
+  crypto = require('crypto');
+} catch (e) {
+}
+if (crypto) {
+  var digest = crypto.createHash('sha1').update('abc').digest('hex');
+  assert.equal(digest,
+               crypto.createHash('sha1').update('616263', 'hex').digest('hex'));
+  assert.equal(new Buffer(digest, 'hex').toString('binary'),
+               crypto.createHash('sha1').update('abc').digest('binary'));
+}
+
+assert.equal('deadbeef', new Buffer('deadbeef', 'hex').toString('hex'));
+assert.equal(4, new Buffer('DEADBEEF', 'hex').length);
+
+// A trailing odd digit is ignored on every path
+assert.equal('ab', new Buffer('abc', 'hex').toString('hex'));
+assert.equal(1, Buffer.byteLength('abc', 'hex'));
+assert.equal(1, new Buffer(4).write('abc', 0, 'hex'));
+if (crypto) {
+  assert.equal(crypto.createHash('sha1').update('ab', 'hex').digest('hex'),
+               crypto.createHash('sha1').update('abc', 'hex').digest('hex'));
+}
+
+assert.throws(function() {
+  new Buffer('zz', 'hex');
+});
+
+// ASCII and UTF-8 detection
+var long = new Array(2000).join('abcdefgh');
+assert.ok(Buffer.isAscii(new Buffer(long)));
+assert.ok(Buffer.isUtf8(new Buffer(long)));
+assert.ok(!Buffer.isAscii(new Buffer(long + 'é')));
+assert.ok(Buffer.isUtf8(new Buffer(long + 'é€')));
+assert.ok(!Buffer.isUtf8(new Buffer([0xc0, 0x80])));          // overlong
+assert.ok(!Buffer.isUtf8(new Buffer([0xed, 0xa0, 0x80])));    // surrogate
+assert.ok(!Buffer.isUtf8(new Buffer([0xe2, 0x82])));          // truncated
+assert.ok(Buffer.isAscii(new Buffer(0)));
+
+// Large ASCII slices take the external string path.
+assert.equal(long, new Buffer(long).toString());
+assert.equal(long, new Buffer(long).toString('ascii'));
+assert.equal(long.slice(3, 4000), new Buffer(long).toString('utf8', 3, 4000));
@@ -0,0 +1,79 @@
+var common = require('../common');
+var assert = require('assert');
+
+var Buffer = require('buffer').Buffer;
+var BufferList = require('buffer').BufferList;
+
+var zero = [];
+var one = [new Buffer('asdf')];
+var long = [];
+for (var i = 0; i < 10; i++) long.push(new Buffer('asdf'));
+
+var flatZero = Buffer.concat(zero);
+var flatOne = Buffer.concat(one);
+var flatLong = Buffer.concat(long);
+var flatLongLen = Buffer.concat(long, 40);
+
+assert.equal(0, flatZero.length);
+assert.equal('asdf', flatOne.toString());
+assert.equal(one[0], flatOne); // no copy for a single buffer
+assert.equal('asdf'.length * 10, flatLong.length);
+assert.equal(new Array(11).join('asdf'), flatLong.toString());
+assert.equal(new Array(11).join('asdf'), flatLongLen.toString());
+
+// A short totalLength truncates, a long one pads with zeros.
+assert.equal('asdfas', Buffer.concat(long, 6).toString());
+var padded = Buffer.concat(long, 50);
+assert.equal(50, padded.length);
+assert.equal(new Array(11).join('asdf'), padded.toString('ascii', 0, 40));
+for (var i = 40; i < 50; i++) assert.equal(0, padded[i]);
+
+// totalLength applies to a single buffer and an empty list as well.
+assert.equal('as', Buffer.concat(one, 2).toString());
+var paddedOne = Buffer.concat(one, 6);
+assert.equal('asdf', paddedOne.toString('ascii', 0, 4));
+assert.equal(0, paddedOne[4]);
+assert.equal(0, paddedOne[5]);
+assert.notEqual(one[0], paddedOne);
+var paddedZero = Buffer.concat(zero, 3);
+assert.equal(3, paddedZero.length);
+for (var i = 0; i < 3; i++) assert.equal(0, paddedZero[i]);
+
+assert.throws(function() {
+  Buffer.concat('asdf');
+});
+
+assert.throws(function() {
+  Buffer.concat([new Buffer('a'), 'b']);
+});
+
+
+// BufferList
+var list = new BufferList();
+list.push(new Buffer('Content-Le'));
+list.push(new Buffer('ngth: 5\r'));
+list.push(new Buffer('\n\r\nhello'));
+
+assert.equal(26, list.length);
+assert.equal(17, list.indexOf('\r\n'));
+assert.equal(17, list.indexOf('\r\n\r\n'));
+assert.equal(-1, list.indexOf('\r\n\r\n', 18));
+assert.equal(21, list.indexOf(104)); // 'h'
+assert.equal(-1, list.indexOf('world'));
+assert.equal('Length', list.slice(8, 14).toString());
+assert.equal('Content', list.slice(0, 7).toString());
+assert.equal(':'.charCodeAt(0), list.get(14));
+
+assert.equal('Content-Length: 5', list.take(17).toString());
+assert.equal(9, list.length);
+list.consume(4);
+assert.equal('hello', list.toString());
+assert.equal('hello', list.toBuffer().toString());
+
+assert.throws(function() {
+  list.slice(0, 10);
+});
+
+assert.throws(function() {
+  list.push('not a buffer');
+});
@@ -0,0 +1,80 @@
+var common = require('../common');
+var assert = require('assert');
+
+var Buffer = require('buffer').Buffer;
+var SlowBuffer = require('buffer').SlowBuffer;
+
+var b = new Buffer('abcdef');
+var buf_a = new Buffer('a');
+var buf_bc = new Buffer('bc');
+var buf_f = new Buffer('f');
+var buf_z = new Buffer('z');
+var buf_empty = new Buffer('');
+
+assert.equal(0, b.indexOf('a'));
+assert.equal(-1, b.indexOf('a', 1));
+assert.equal(0, b.indexOf('a', -20));
+assert.equal(1, b.indexOf('bc'));
+assert.equal(-1, b.indexOf('bc', 2));
+assert.equal(1, b.indexOf('bc', -5));
+assert.equal(5, b.indexOf('f'));
+assert.equal(5, b.indexOf('f', -1));
+assert.equal(-1, b.indexOf('z'));
+assert.equal(-1, b.indexOf('abcdefg'));
+assert.equal(0, b.indexOf(''));
+assert.equal(3, b.indexOf('', 3));
+assert.equal(-1, b.indexOf('', 7));
+
+assert.equal(0, b.indexOf(buf_a));
+assert.equal(1, b.indexOf(buf_bc));
+assert.equal(5, b.indexOf(buf_f));
+assert.equal(-1, b.indexOf(buf_z));
+assert.equal(0, b.indexOf(buf_empty));
+
+assert.equal(0, b.indexOf(0x61));
+assert.equal(3, b.indexOf(0x64));
+assert.equal(-1, b.indexOf(0x7a));
+assert.equal(3, b.indexOf(0x164)); // only the low byte counts
+
+assert.equal(5, b.lastIndexOf('f'));
+assert.equal(1, b.lastIndexOf('bc'));
+assert.equal(1, b.lastIndexOf('bc', 1));
+assert.equal(-1, b.lastIndexOf('bc', 0));
+assert.equal(-1, b.lastIndexOf('bc', -6));
+assert.equal(0, b.lastIndexOf(0x61));
+assert.equal(6, b.lastIndexOf(''));
+
+// Slices only see their own window.
+var s = new Buffer('xxabcabcxx').slice(2, 8);
+assert.equal(0, s.indexOf('abc'));
+assert.equal(3, s.indexOf('abc', 1));
+assert.equal(3, s.lastIndexOf('abc'));
+assert.equal(-1, s.indexOf('x'));
+assert.equal(-1, s.lastIndexOf('x'));
+
+// multi-byte characters are matched as utf8
+var u = new Buffer('a€b€c');
+assert.equal(1, u.indexOf('€'));
+assert.equal(5, u.lastIndexOf('€'));
+
+// Long haystacks and needles take the Horspool path.
+var boundary = '\r\n--boundary-1234567890\r\n';
+var body = new Array(5000).join('0123456789abcdef') + boundary + 'tail' +
+           boundary;
+var big = new Buffer(body);
+assert.equal(body.indexOf(boundary), big.indexOf(boundary));
+assert.equal(body.lastIndexOf(boundary), big.lastIndexOf(boundary));
+assert.equal(body.indexOf(boundary, body.indexOf(boundary) + 1),
+             big.indexOf(boundary, big.indexOf(boundary) + 1));
+assert.equal(-1, big.indexOf('--boundary-0'));
+
+// SlowBuffer takes an explicit window.
+var slow = new SlowBuffer(6);
+slow.write('abcabc', 0, 'ascii');
+assert.equal(3, slow.indexOf('abc', 1));
+assert.equal(-1, slow.indexOf('abc', 1, 5));
+assert.equal(0, slow.lastIndexOf('abc', 0, 5));
+
+assert.throws(function() {
+  b.indexOf({});
+});
@@ -0,0 +1,37 @@
+var common = require('../common');
+var assert = require('assert');
+
+var SlowBuffer = require('buffer').SlowBuffer;
+var Buffer = require('buffer').Buffer;
+
+var stats = Buffer.poolStats();
+
+assert.equal('number', typeof stats.allocs);
+assert.equal('number', typeof stats.hitRate);
+assert.ok(stats.hitRate >= 0 && stats.hitRate <= 1);
+assert.ok(stats.fragmentation >= 0 && stats.fragmentation < 1);
+assert.equal(11, stats.classes.length);
+assert.equal(1024, stats.classes[0].size);
+assert.equal(1024 * 1024, stats.classes[10].size);
+
+// Every SlowBuffer goes through the pool, rounded up to its size class.
+var before = SlowBuffer.poolStats();
+var b = new SlowBuffer(3000);
+var after = SlowBuffer.poolStats();
+assert.equal(before.allocs + 1, after.allocs);
+assert.equal(before.liveBytes + 3000, after.liveBytes);
+assert.equal(before.reservedBytes + 4096, after.reservedBytes);
+
+// Recycled memory must still be usable as a normal buffer.
+for (var i = 0; i < b.length; i++) b[i] = i % 256;
+for (var i = 0; i < b.length; i++) assert.equal(i % 256, b[i]);
+
+// Shrinking the cache releases everything that is held.
+SlowBuffer.setPoolCacheSize(0);
+assert.equal(0, SlowBuffer.poolStats().cachedBytes);
+assert.equal(0, SlowBuffer.poolStats().maxCachedBytes);
+SlowBuffer.setPoolCacheSize(16 * 1024 * 1024);
+
+assert.throws(function() {
+  SlowBuffer.setPoolCacheSize(-1);
+});
@@ -0,0 +1,69 @@
+var common = require('../common');
+var assert = require('assert');
+
+try {
+  var crypto = require('crypto');
+} catch (e) {
+  console.log('Not compiled with OPENSSL support.');
+  process.exit();
+}
+
+var fs = require('fs');
+
+var certPem = fs.readFileSync(common.fixturesDir + '/test_cert.pem', 'ascii');
+var keyPem = fs.readFileSync(common.fixturesDir + '/test_key.pem', 'ascii');
+
+var signed = 0;
+var verified = 0;
+
+var expected = crypto.createSign('RSA-SHA1')
+                     .update('Test123')
+                     .sign(keyPem, 'base64');
+
+crypto.createSign('RSA-SHA1')
+      .update('Test123')
+      .sign(keyPem, 'base64', function(err, sig) {
+  assert.equal(null, err);
+  assert.equal(expected, sig);
+  signed++;
+
+  crypto.createVerify('RSA-SHA1')
+        .update('Test123')
+        .verify(certPem, sig, 'base64', function(err, ok) {
+    assert.equal(null, err);
+    assert.strictEqual(true, ok);
+    verified++;
+  });
+
+  crypto.createVerify('RSA-SHA1')
+        .update('Test124')
+        .verify(certPem, sig, 'base64', function(err, ok) {
+    assert.equal(null, err);
+    assert.strictEqual(false, ok);
+    verified++;
+  });
+});
+
+// Binary output when no encoding is given.
+crypto.createSign('RSA-SHA256')
+      .update('Test123')
+      .sign(keyPem, function(err, sig) {
+  assert.equal(null, err);
+  assert.ok(crypto.createVerify('RSA-SHA256')
+                  .update('Test123')
+                  .verify(certPem, sig));
+  signed++;
+});
+
+// A signer cannot be reused while the signature is being computed.
+var busy = crypto.createSign('RSA-SHA1').update('Test123');
+busy.sign(keyPem, function() { signed++; });
+assert.throws(function() {
+  busy.sign(keyPem);
+});
+
+
+process.on('exit', function() {
+  assert.equal(3, signed);
+  assert.equal(2, verified);
+});
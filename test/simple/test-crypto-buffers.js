@@ -0,0 +1,137 @@
+var common = require('../common');
+var assert = require('assert');
+
+try {
+  var crypto = require('crypto');
+} catch (e) {
+  console.log('Not compiled with OPENSSL support.');
+  process.exit();
+}
+
+var fs = require('fs');
+var path = require('path');
+
+var callbacks = 0;
+
+// digest('buffer') and digestInto()
+var expected = crypto.createHash('sha1').update('Test123').digest('hex');
+var d = crypto.createHash('sha1').update('Test123').digest('buffer');
+assert.ok(Buffer.isBuffer(d));
+assert.equal(expected, d.toString('hex'));
+
+var out = new Buffer(24);
+var n = crypto.createHash('sha1').update('Test123').digestInto(out, 4);
+assert.equal(20, n);
+assert.equal(expected, out.slice(4, 24).toString('hex'));
+
+assert.throws(function() {
+  crypto.createHash('sha1').update('Test123').digestInto(new Buffer(10));
+}, RangeError);
+
+var hmacExpected = crypto.createHmac('sha1', 'Node').update('some data')
+                         .digest('hex');
+out = new Buffer(20);
+crypto.createHmac('sha1', 'Node').update('some data').digestInto(out);
+assert.equal(hmacExpected, out.toString('hex'));
+
+// Asynchronous update
+var big = new Buffer(1024 * 1024);
+for (var i = 0; i < big.length; i++) big[i] = i & 0xff;
+var bigDigest = crypto.createHash('md5').update(big).digest('hex');
+
+var h = crypto.createHash('md5');
+h.update(big, function(err) {
+  assert.equal(null, err);
+  assert.equal(bigDigest, h.digest('hex'));
+  callbacks++;
+});
+assert.throws(function() {
+  h.digest('hex');
+});
+
+var hm = crypto.createHmac('sha256', 'key');
+hm.update(big, 0, 1000, function(err) {
+  assert.equal(null, err);
+  assert.equal(crypto.createHmac('sha256', 'key')
+                     .update(big.slice(0, 1000)).digest('hex'),
+               hm.digest('hex'));
+  callbacks++;
+});
+
+// Known answers, so an update that hashed nothing cannot pass.
+var abc = crypto.createHash('sha1');
+abc.update(new Buffer('ab'), function(err) {
+  assert.equal(null, err);
+  abc.update('c');
+  assert.equal('a9993e364706816aba3e25717850c26c9cd0d89d', abc.digest('hex'));
+  callbacks++;
+});
+
+var fox = crypto.createHmac('sha256', 'key');
+fox.update(new Buffer('The quick brown fox jumps over the lazy dog'),
+           function(err) {
+  assert.equal(null, err);
+  assert.equal('f7bc83f430538424b13298e6aa6fb143' +
+               'ef4d59a14946175997479dbc2d1a3cd8',
+               fox.digest('hex'));
+  callbacks++;
+});
+
+// Cipher and decipher into caller supplied buffers
+var plaintext = new Buffer('Top secret, must be encrypted with a 128 bit ' +
+                           'key and decrypted again');
+var encrypted = new Buffer(plaintext.length + 16);
+var cipher = crypto.createCipher('aes128', 'key');
+var elen = cipher.updateInto(plaintext, 0, plaintext.length, encrypted, 0);
+elen += cipher.finalInto(encrypted, elen);
+encrypted = encrypted.slice(0, elen);
+
+var reference = crypto.createCipher('aes128', 'key');
+var refString = reference.update(plaintext.toString('binary'), 'binary',
+                                 'binary') + reference.final('binary');
+assert.equal(refString, encrypted.toString('binary'));
+
+var decrypted = new Buffer(encrypted.length + 16);
+var decipher = crypto.createDecipher('aes128', 'key');
+decipher.updateInto(encrypted, 0, encrypted.length, decrypted, 0,
+                    function(err, dlen) {
+  assert.equal(null, err);
+  dlen += decipher.finalInto(decrypted, dlen);
+  assert.equal(plaintext.toString(), decrypted.slice(0, dlen).toString());
+  callbacks++;
+});
+
+assert.throws(function() {
+  crypto.createCipher('aes128', 'key')
+        .updateInto(plaintext, 0, plaintext.length, new Buffer(8), 0);
+}, RangeError);
+
+// hashFile
+var file = path.join(common.fixturesDir, 'sample.png');
+var fileDigest = crypto.createHash('sha1')
+                       .update(fs.readFileSync(file)).digest('hex');
+
+crypto.hashFile(file, 'sha1', 'hex', function(err, sum) {
+  assert.equal(null, err);
+  assert.equal(fileDigest, sum);
+  callbacks++;
+});
+
+crypto.hashFile(file, 'sha1', function(err, sum) {
+  assert.equal(null, err);
+  assert.ok(Buffer.isBuffer(sum));
+  assert.equal(fileDigest, sum.toString('hex'));
+  callbacks++;
+});
+
+crypto.hashFile(path.join(common.fixturesDir, 'does_not_exist'), 'sha1',
+                function(err) {
+  assert.ok(err);
+  assert.equal('ENOENT', err.code);
+  callbacks++;
+});
+
+
+process.on('exit', function() {
+  assert.equal(8, callbacks);
+});
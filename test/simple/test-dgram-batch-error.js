@@ -0,0 +1,49 @@
+var common = require('../common');
+var assert = require('assert');
+var dgram = require('dgram');
+
+// A batch stops at the message that fails and reports that message's own
+// error, not EAGAIN.
+var received = [];
+var batchError = null;
+
+var server = dgram.createSocket('udp4');
+
+server.on('message', function(msg) {
+  received.push(msg.toString());
+  if (received.length == 2) {
+    server.close();
+    client.close();
+  }
+});
+
+server.on('listening', function() {
+  function message(buffer) {
+    return { buffer: buffer, port: common.PORT, address: '127.0.0.1' };
+  }
+
+  // Larger than any UDP datagram can be.
+  var messages = [message(new Buffer('first')),
+                  message(new Buffer(70000)),
+                  message(new Buffer('last'))];
+
+  var count = client.sendBatch(messages, function(err, n) {
+    batchError = err;
+    assert.equal(n, 1);
+  });
+  assert.equal(count, 1);
+
+  client.sendBatch(messages.slice(2), function(err, n) {
+    assert.equal(err, null);
+    assert.equal(n, 1);
+  });
+});
+
+var client = dgram.createSocket('udp4');
+server.bind(common.PORT, '127.0.0.1');
+
+process.on('exit', function() {
+  assert.ok(batchError instanceof Error);
+  assert.equal(batchError.code, 'EMSGSIZE');
+  assert.deepEqual(received.sort(), ['first', 'last']);
+});
@@ -0,0 +1,80 @@
+var common = require('../common');
+var assert = require('assert');
+var dgram = require('dgram');
+
+var N = 40;
+var received = [];
+var batches = 0;
+var perMessage = 0;
+var truncated = 0;
+var longMessage = new Array(101).join('x');
+
+var server = dgram.createSocket('udp4');
+server.setRecvBatch(16, 64);
+
+server.on('messages', function(buf, info) {
+  batches++;
+  assert.ok(info.offsets.length <= 16);
+  assert.equal(info.offsets.length, info.lengths.length);
+  assert.equal(info.offsets.length, info.from.length);
+  assert.equal(info.offsets.length, info.truncated.length);
+
+  var total = 0;
+  for (var i = 0; i < info.offsets.length; i++) {
+    assert.equal(info.offsets[i], total);
+    total += info.lengths[i];
+    assert.equal(info.from[i].address, '127.0.0.1');
+    var s = buf.toString('ascii', info.offsets[i],
+                         info.offsets[i] + info.lengths[i]);
+    if (info.truncated[i]) {
+      // Longer than the 64 byte slot.
+      assert.equal(longMessage.slice(0, 64), s);
+      truncated++;
+    } else {
+      received.push(s);
+    }
+  }
+  assert.equal(total, info.size);
+  assert.equal(buf.length, info.size);
+
+  if (received.length + truncated == N + 1) {
+    server.close();
+    client.close();
+  }
+});
+
+server.on('message', function(msg, rinfo) {
+  assert.equal(msg.length, rinfo.size);
+  assert.equal(msg.length == 64, rinfo.truncated === true);
+  perMessage++;
+});
+
+server.on('listening', function() {
+  var messages = [];
+  for (var i = 0; i < N; i++) {
+    messages.push({ buffer: new Buffer('message ' + i),
+                    port: common.PORT,
+                    address: '127.0.0.1' });
+  }
+  messages.push({ buffer: new Buffer(longMessage),
+                  port: common.PORT,
+                  address: '127.0.0.1' });
+
+  client.sendBatch(messages, function(err, count) {
+    assert.equal(err, null);
+    assert.equal(count, N + 1);
+  });
+});
+
+var client = dgram.createSocket('udp4');
+server.bind(common.PORT, '127.0.0.1');
+
+process.on('exit', function() {
+  assert.equal(received.length, N);
+  assert.equal(perMessage, N + 1);
+  assert.equal(truncated, 1);
+  assert.ok(batches >= Math.ceil((N + 1) / 16));
+  for (var i = 0; i < N; i++) {
+    assert.notEqual(received.indexOf('message ' + i), -1);
+  }
+});
@@ -0,0 +1,100 @@
+var common = require('../common');
+var assert = require('assert');
+
+var path = require('path'),
+    fs = require('fs');
+
+var _fs_write = fs.write,
+    _fs_fdatasync = fs.fdatasync;
+
+var writes = 0, syncs = 0;
+
+fs.write = function() {
+  writes++;
+  return _fs_write.apply(fs, arguments);
+};
+
+fs.fdatasync = function() {
+  syncs++;
+  return _fs_fdatasync.apply(fs, arguments);
+};
+
+var lines = 1000;
+var line = 'GET /index.html 200 1234\n';
+
+
+// Lines written while the file is being opened go out in one write().
+(function() {
+  var file = path.join(common.tmpDir, 'coalesce.txt');
+  var stream = fs.createWriteStream(file);
+  var callbacks = 0;
+
+  for (var i = 0; i < lines; i++) {
+    stream.write(i % 2 ? line : new Buffer(line), function(err, written) {
+      assert.equal(null, err);
+      assert.equal(line.length, written);
+      callbacks++;
+    });
+  }
+
+  stream.end(function() {
+    assert.equal(1, writes);
+    assert.equal(lines, callbacks);
+    assert.equal(lines * line.length, fs.readFileSync(file).length);
+    latency();
+  });
+})();
+
+
+// maxLatency holds writes back so that they can be grouped, maxBytes
+// flushes early, and syncInterval fdatasync()s what was written.
+function latency() {
+  var file = path.join(common.tmpDir, 'coalesce-latency.txt');
+  var stream = fs.createWriteStream(file, { maxLatency: 50,
+                                            maxBytes: 100 * line.length,
+                                            syncInterval: 10 });
+  writes = 0;
+
+  stream.on('open', function() {
+    var i = 0;
+    var timer = setInterval(function() {
+      for (var j = 0; j < 50; j++) stream.write(line);
+      if (++i < 10) return;
+
+      clearInterval(timer);
+      stream.end(function() {
+        assert.ok(writes > 1 && writes <= 10, 'writes: ' + writes);
+        assert.ok(syncs >= 1);
+        assert.equal(500 * line.length, fs.readFileSync(file).length);
+        cap();
+      });
+    }, 1);
+  });
+}
+
+
+// Without maxBytes a group still stops short of 64 KB: ten 20000 byte
+// writes queued during open go out three at a time.
+function cap() {
+  var file = path.join(common.tmpDir, 'coalesce-cap.txt');
+  var stream = fs.createWriteStream(file);
+  var chunk = new Buffer(20000);
+  writes = 0;
+
+  for (var i = 0; i < 10; i++) stream.write(chunk);
+
+  stream.end(function() {
+    assert.equal(4, writes);
+    assert.equal(10 * chunk.length, fs.readFileSync(file).length);
+    fs.write = _fs_write;
+    fs.fdatasync = _fs_fdatasync;
+    done = true;
+  });
+}
+
+
+var done = false;
+
+process.on('exit', function() {
+  assert.ok(done);
+});
@@ -0,0 +1,58 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+var net = require('net');
+
+// An HTTP/1.0 response without "Connection: keep-alive" means the server
+// will not reuse the connection, even though it does not close it.
+var connections = 0;
+var serverEnds = 0;
+
+var server = net.createServer(function(socket) {
+  connections++;
+  socket.once('data', function() {
+    socket.write('HTTP/1.0 200 OK\r\n' +
+                 'Content-Length: 2\r\n' +
+                 '\r\n' +
+                 'ok');
+  });
+  // The client ends each connection once the response is read.
+  socket.on('end', function() {
+    socket.end();
+    if (++serverEnds == 2) server.close();
+  });
+});
+
+var agent = new http.Agent({ host: 'localhost',
+                             port: common.PORT,
+                             keepAlive: true });
+
+var responses = 0;
+
+function get(cb) {
+  http.get({ host: 'localhost',
+             port: common.PORT,
+             path: '/',
+             agent: agent }, function(res) {
+    assert.equal(200, res.statusCode);
+    res.on('end', function() {
+      responses++;
+      process.nextTick(function() {
+        assert.equal(0, agent.freeSockets.length);
+        cb();
+      });
+    });
+  });
+}
+
+server.listen(common.PORT, function() {
+  get(function() {
+    get(function() { });
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(2, responses);
+  assert.equal(2, connections);
+  assert.equal(2, serverEnds);
+});
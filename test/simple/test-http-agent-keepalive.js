@@ -0,0 +1,75 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+
+var serverSockets = 0;
+
+var server = http.createServer(function(req, res) {
+  res.writeHead(200, { 'Content-Length': 2 });
+  res.end('ok');
+});
+
+server.on('connection', function() {
+  serverSockets++;
+});
+
+var agent = new http.Agent({ host: 'localhost',
+                             port: common.PORT,
+                             keepAlive: true,
+                             maxSockets: 2,
+                             maxIdleTime: 200 });
+
+function get(cb) {
+  http.get({ host: 'localhost',
+             port: common.PORT,
+             path: '/',
+             agent: agent }, function(res) {
+    assert.equal(200, res.statusCode);
+    res.on('end', cb);
+  });
+}
+
+
+server.listen(common.PORT, function() {
+  // Sequential requests share one connection.
+  get(function() {
+    process.nextTick(function() {
+      assert.equal(1, agent.freeSockets.length);
+      get(function() {
+        process.nextTick(function() {
+          var stats = agent.getStats();
+          assert.equal(1, stats.misses);
+          assert.equal(1, stats.hits);
+          assert.equal(1, serverSockets);
+          burst();
+        });
+      });
+    });
+  });
+});
+
+
+// A burst of four requests runs on at most maxSockets connections.
+function burst() {
+  var done = 0;
+  for (var i = 0; i < 4; i++) {
+    get(function() {
+      if (++done < 4) return;
+      process.nextTick(function() {
+        assert.ok(serverSockets <= 2);
+        assert.equal(2, agent.sockets.length);
+        waitForIdleTimeout();
+      });
+    });
+  }
+}
+
+
+// Idle connections are closed after maxIdleTime.
+function waitForIdleTimeout() {
+  setTimeout(function() {
+    assert.equal(0, agent.sockets.length);
+    assert.equal(0, agent.freeSockets.length);
+    server.close();
+  }, 500);
+}
@@ -0,0 +1,120 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+
+// request.setBodyMode(): the parser collects the body and hands it over
+// per socket read, by watermark, or as a single 'body' event.
+
+var chunk = new Buffer(500);
+for (var i = 0; i < chunk.length; i++) chunk[i] = i % 256;
+var chunks = 10;
+var total = chunk.length * chunks;
+
+function check(body) {
+  assert.equal(total, body.length);
+  for (var i = 0; i < body.length; i++) {
+    if (body[i] !== i % chunk.length % 256) assert.fail(body[i], i % 256);
+  }
+}
+
+function join(buffers) {
+  var length = 0;
+  buffers.forEach(function(b) { length += b.length; });
+  var out = new Buffer(length), pos = 0;
+  buffers.forEach(function(b) {
+    b.copy(out, pos);
+    pos += b.length;
+  });
+  return out;
+}
+
+var results = {};
+
+var server = http.createServer(function(req, res) {
+  var received = [];
+  var bodies = 0;
+  var error = null;
+
+  switch (req.url) {
+    case '/read':
+      req.setBodyMode('read');
+      break;
+    case '/watermark':
+      req.setBodyMode('watermark', 1200);
+      break;
+    case '/body':
+      req.setBodyMode('body', 1024 * 1024);
+      break;
+    case '/too-large':
+      req.setBodyMode('body', 1000);
+      req.on('error', function(e) {
+        error = e;
+      });
+      break;
+  }
+
+  req.on('data', function(d) {
+    assert.ok(Buffer.isBuffer(d));
+    received.push(d);
+  });
+
+  req.on('body', function(body) {
+    bodies++;
+    received.push(body);
+  });
+
+  req.on('end', function() {
+    results[req.url] = { received: received, bodies: bodies, error: error };
+    res.writeHead(error ? 413 : 200);
+    res.end();
+  });
+});
+
+var paths = ['/read', '/watermark', '/body', '/too-large'];
+var responses = 0;
+
+server.listen(common.PORT, function() {
+  paths.forEach(function(path) {
+    var req = http.request({ port: common.PORT,
+                             method: 'POST',
+                             path: path }, function(res) {
+      assert.equal(path == '/too-large' ? 413 : 200, res.statusCode);
+      if (++responses == paths.length) server.close();
+    });
+
+    var n = 0;
+    (function next() {
+      req.write(chunk);
+      if (++n < chunks) {
+        setTimeout(next, 5);
+      } else {
+        req.end();
+      }
+    })();
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(paths.length, responses);
+
+  // One 'data' per read, never more than the chunks written.
+  var read = results['/read'];
+  assert.ok(read.received.length >= 1 && read.received.length <= chunks);
+  check(join(read.received));
+
+  var watermark = results['/watermark'];
+  watermark.received.slice(0, -1).forEach(function(d) {
+    assert.ok(d.length >= 1200);
+  });
+  check(join(watermark.received));
+
+  var body = results['/body'];
+  assert.equal(1, body.bodies);
+  assert.equal(1, body.received.length);
+  check(body.received[0]);
+
+  var tooLarge = results['/too-large'];
+  assert.equal(0, tooLarge.bodies);
+  assert.equal(0, tooLarge.received.length);
+  assert.equal('EMSGSIZE', tooLarge.error.code);
+});
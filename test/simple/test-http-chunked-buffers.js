@@ -0,0 +1,69 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+var net = require('net');
+
+// Buffer chunks of a chunked response are framed natively and sent with
+// writev(). Check the exact bytes on the wire, mixed with string chunks,
+// and for res.end(buffer) with and without trailers.
+
+var big = new Buffer(300);
+for (var i = 0; i < big.length; i++) big[i] = 'a'.charCodeAt(0);
+
+var expected = {
+  '/stream': '5\r\nhello\r\n' +
+             '5\r\nworld\r\n' +
+             '12c\r\n' + big.toString() + '\r\n' +
+             '0\r\n\r\n',
+  '/end': '4\r\ndone\r\n0\r\n\r\n',
+  '/trailer': '4\r\ndone\r\n0\r\nX-Sum: 42\r\n\r\n'
+};
+
+var server = http.createServer(function(req, res) {
+  res.writeHead(200, { 'Content-Type': 'text/plain' });
+  switch (req.url) {
+    case '/stream':
+      res.write(new Buffer('hello'));
+      res.write('world');
+      res.write(big);
+      res.end();
+      break;
+
+    case '/trailer':
+      res.addTrailers({ 'X-Sum': 42 });
+      // fall through
+    case '/end':
+      res.end(new Buffer('done'));
+      break;
+  }
+});
+
+var responses = 0;
+
+function get(path) {
+  var c = net.createConnection(common.PORT);
+  var raw = '';
+
+  c.setEncoding('binary');
+  c.on('connect', function() {
+    c.write('GET ' + path + ' HTTP/1.1\r\nConnection: close\r\n\r\n');
+  });
+  c.on('data', function(d) {
+    raw += d;
+  });
+  c.on('end', function() {
+    var head = raw.slice(0, raw.indexOf('\r\n\r\n'));
+    assert.ok(/Transfer-Encoding: chunked/i.test(head));
+    assert.equal(expected[path], raw.slice(head.length + 4));
+    c.end();
+    if (++responses == Object.keys(expected).length) server.close();
+  });
+}
+
+server.listen(common.PORT, function() {
+  Object.keys(expected).forEach(get);
+});
+
+process.on('exit', function() {
+  assert.equal(3, responses);
+});
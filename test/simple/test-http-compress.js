@@ -0,0 +1,93 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+
+try {
+  var zlib = require('zlib');
+} catch (e) {
+  console.log('Not compiled with zlib support.');
+  process.exit();
+}
+
+var body = new Array(1000).join('compress me please ');
+var responses = 0;
+
+var server = http.createServer(function(req, res) {
+  if (req.url === '/png') {
+    res.writeHead(200, { 'Content-Type': 'image/png' });
+    res.end(body);
+    return;
+  }
+
+  res.compress();
+  res.writeHead(200, { 'Content-Type': 'text/plain',
+                       'Content-Length': Buffer.byteLength(body) });
+  res.write(body.slice(0, 100));
+  res.end(body.slice(100));
+});
+server.compression = { level: 1 };
+
+
+function get(path, acceptEncoding, callback) {
+  var headers = {};
+  if (acceptEncoding) headers['Accept-Encoding'] = acceptEncoding;
+
+  http.get({ port: common.PORT, path: path, headers: headers }, function(res) {
+    var chunks = [], length = 0;
+    res.on('data', function(chunk) {
+      chunks.push(chunk);
+      length += chunk.length;
+    });
+    res.on('end', function() {
+      var buf = new Buffer(length);
+      for (var i = 0, offset = 0; i < chunks.length; i++) {
+        chunks[i].copy(buf, offset, 0);
+        offset += chunks[i].length;
+      }
+      callback(res, buf);
+    });
+  });
+}
+
+
+server.listen(common.PORT, function() {
+  get('/', 'deflate;q=0.5, gzip', function(res, buf) {
+    assert.equal('gzip', res.headers['content-encoding']);
+    assert.equal('Accept-Encoding', res.headers['vary']);
+    assert.equal(undefined, res.headers['content-length']);
+    zlib.gunzip(buf, function(err, plain) {
+      assert.equal(null, err);
+      assert.equal(body, plain.toString());
+      responses++;
+    });
+
+    get('/', 'gzip;q=0, deflate', function(res, buf) {
+      assert.equal('deflate', res.headers['content-encoding']);
+      zlib.inflate(buf, function(err, plain) {
+        assert.equal(null, err);
+        assert.equal(body, plain.toString());
+        responses++;
+      });
+
+      get('/', null, function(res, buf) {
+        assert.equal(undefined, res.headers['content-encoding']);
+        assert.equal(Buffer.byteLength(body), res.headers['content-length']);
+        assert.equal(body, buf.toString());
+        responses++;
+
+        // server.compression applies, but images are left alone.
+        get('/png', 'gzip', function(res, buf) {
+          assert.equal(undefined, res.headers['content-encoding']);
+          assert.equal(body, buf.toString());
+          responses++;
+          server.close();
+        });
+      });
+    });
+  });
+});
+
+
+process.on('exit', function() {
+  assert.equal(4, responses);
+});
@@ -0,0 +1,66 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+
+// res.end(buffer) with a Content-Length writes the header and the body
+// with one writev(). Check both a small and a large body arrive intact,
+// and that a HEAD response still carries no body.
+
+var sizes = [1024, 64 * 1024];
+var bodies = sizes.map(function(size) {
+  var b = new Buffer(size);
+  for (var i = 0; i < size; i++) b[i] = i % 251;
+  return b;
+});
+
+var server = http.createServer(function(req, res) {
+  var body = bodies[parseInt(req.url.slice(1), 10)];
+  res.writeHead(200, { 'Content-Type': 'application/octet-stream',
+                       'Content-Length': body.length });
+  res.end(body);
+});
+
+var responses = 0;
+
+function get(method, i) {
+  var req = http.request({ port: common.PORT,
+                           method: method,
+                           path: '/' + i }, function(res) {
+    var chunks = [], length = 0;
+    assert.equal(bodies[i].length, res.headers['content-length']);
+
+    res.on('data', function(chunk) {
+      chunks.push(chunk);
+      length += chunk.length;
+    });
+
+    res.on('end', function() {
+      if (method == 'HEAD') {
+        assert.equal(0, length);
+      } else {
+        var got = new Buffer(length), pos = 0;
+        chunks.forEach(function(c) {
+          c.copy(got, pos);
+          pos += c.length;
+        });
+        assert.equal(bodies[i].length, got.length);
+        for (var j = 0; j < got.length; j++) {
+          if (got[j] !== bodies[i][j]) assert.fail(got[j], bodies[i][j]);
+        }
+      }
+      if (++responses == sizes.length * 2) server.close();
+    });
+  });
+  req.end();
+}
+
+server.listen(common.PORT, function() {
+  for (var i = 0; i < sizes.length; i++) {
+    get('GET', i);
+    get('HEAD', i);
+  }
+});
+
+process.on('exit', function() {
+  assert.equal(sizes.length * 2, responses);
+});
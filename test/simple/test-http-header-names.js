@@ -0,0 +1,101 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+var net = require('net');
+
+// Header names are lower-cased by the parser (interned when they are
+// common ones) and the headers object is only built when it is used.
+// Send the same request in one piece and split into several reads, and
+// check both produce the same headers and trailers.
+
+var request = 'POST /upload HTTP/1.1\r\n' +
+              'HOST: example.com\r\n' +
+              'Content-Type: text/plain\r\n' +
+              'X-Custom-Thing: one\r\n' +
+              'x-custom-thing: two\r\n' +
+              'Set-Cookie: a=1\r\n' +
+              'Set-Cookie: b=2\r\n' +
+              'Accept: text/html\r\n' +
+              'Accept: text/plain\r\n' +
+              'Referer: first\r\n' +
+              'Referer: second\r\n' +
+              'Some-Unusual-Header-Name: value with spaces\r\n' +
+              'Transfer-Encoding: chunked\r\n' +
+              'Connection: close\r\n' +
+              '\r\n' +
+              '3\r\nabc\r\n' +
+              '0\r\n' +
+              'Content-MD5: 900150983cd24fb0d6963f7d28e17f72\r\n' +
+              '\r\n';
+
+var expectedHeaders = {
+  'host': 'example.com',
+  'content-type': 'text/plain',
+  'x-custom-thing': 'one, two',
+  'set-cookie': ['a=1', 'b=2'],
+  'accept': 'text/html, text/plain',
+  'referer': 'first',
+  'some-unusual-header-name': 'value with spaces',
+  'transfer-encoding': 'chunked',
+  'connection': 'close'
+};
+
+var expectedTrailers = {
+  'content-md5': '900150983cd24fb0d6963f7d28e17f72'
+};
+
+var requests = 0;
+
+var server = http.createServer(function(req, res) {
+  assert.equal('text/plain', req._getHeader('content-type'));
+  assert.equal(undefined, req._getHeader('x-missing'));
+  assert.deepEqual(expectedHeaders, req.headers);
+  assert.strictEqual(req.headers, req.headers);
+
+  var body = '';
+  req.setEncoding('ascii');
+  req.on('data', function(d) {
+    body += d;
+  });
+  req.on('end', function() {
+    assert.equal('abc', body);
+    assert.deepEqual(expectedTrailers, req.trailers);
+
+    req.headers = { replaced: 'yes' };
+    assert.equal('yes', req.headers.replaced);
+
+    res.writeHead(200, { 'Content-Type': 'text/plain' });
+    res.end('ok');
+    if (++requests == 3) server.close();
+  });
+});
+
+// Writes the request in pieces of the given sizes, waiting between them
+// so they arrive as separate reads.
+function send(sizes) {
+  var c = net.createConnection(common.PORT);
+  var pos = 0;
+
+  c.on('connect', function() {
+    (function next() {
+      var size = sizes.shift() || request.length;
+      c.write(request.slice(pos, pos + size));
+      pos += size;
+      if (pos < request.length) setTimeout(next, 20);
+    })();
+  });
+
+  c.on('end', function() {
+    c.end();
+  });
+}
+
+server.listen(common.PORT, function() {
+  send([request.length]);
+  send([20, 45, 3, 100]);
+  send([request.indexOf('\r\n0\r\n') + 7, 10]);
+});
+
+process.on('exit', function() {
+  assert.equal(3, requests);
+});
@@ -7,6 +7,14 @@ var assert = require('assert');
 var http = require('http');
 
 var srv = http.createServer(function(req, res) {
+  // The internal lookup used before req.headers is built agrees with it.
+  assert.equal(req._getHeader('accept'), 'abc, def, ghijklmnopqrst');
+  assert.equal(req._getHeader('accept-encoding'), 'identity, gzip');
+  assert.equal(req._getHeader('host'), 'foo');
+  assert.equal(req._getHeader('x-bar'), 'banjo, bango');
+  assert.equal(req._getHeader('x-baz'), undefined);
+
+  assert.equal(req.headers['accept-encoding'], 'identity, gzip');
   assert.equal(req.headers.accept, 'abc, def, ghijklmnopqrst');
   assert.equal(req.headers.host, 'foo');
   assert.equal(req.headers['x-foo'], 'bingo');
@@ -25,6 +33,8 @@ srv.listen(common.PORT, function() {
         ['accept', 'abc'],
         ['accept', 'def'],
         ['Accept', 'ghijklmnopqrst'],
+        ['accept-encoding', 'identity'],
+        ['Accept-Encoding', 'gzip'],
         ['host', 'foo'],
         ['Host', 'bar'],
         ['hOst', 'baz'],
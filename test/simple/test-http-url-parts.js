@@ -0,0 +1,62 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+var net = require('net');
+
+// request.pathname and request.query come from the offsets the parser
+// reports, even when the request line arrives in pieces.
+
+var expected = [
+  { url: '/status?name=ryan&x=1&x=2#top',
+    pathname: '/status',
+    query: { name: 'ryan', x: ['1', '2'] } },
+  { url: '/plain', pathname: '/plain', query: {} },
+  { url: '/empty?', pathname: '/empty', query: {} },
+  { url: '/a%20b?q=%C3%A9+1', pathname: '/a%20b', query: { q: 'é 1' } },
+  { url: 'http://example.com/abs/path?y=2',
+    pathname: '/abs/path', query: { y: '2' } },
+  { url: '/rewritten?before=1', pathname: '/after', query: { after: '1' },
+    rewrite: '/after?after=1' }
+];
+
+var seen = 0;
+
+var server = http.createServer(function(req, res) {
+  var e = expected[seen++];
+  assert.equal(e.url, req.url);
+  if (e.rewrite) {
+    assert.equal('/rewritten', req.pathname);
+    req.url = e.rewrite;
+  }
+  assert.equal(e.pathname, req.pathname);
+  assert.deepEqual(e.query, req.query);
+  res.writeHead(200, { 'Content-Length': 0 });
+  res.end();
+});
+
+server.listen(common.PORT, function() {
+  var c = net.createConnection(common.PORT);
+  var requests = expected.map(function(e) {
+    return 'GET ' + e.url + ' HTTP/1.1\r\nHost: localhost\r\n\r\n';
+  }).join('');
+
+  // Dribble the requests in a few bytes at a time.
+  var pos = 0;
+  c.on('connect', function write() {
+    if (pos >= requests.length) return;
+    c.write(requests.slice(pos, pos + 7));
+    pos += 7;
+    setTimeout(write, 1);
+  });
+
+  c.on('data', function() {
+    if (seen == expected.length) {
+      c.end();
+      server.close();
+    }
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(expected.length, seen);
+});
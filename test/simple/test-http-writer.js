@@ -0,0 +1,84 @@
+var common = require('../common');
+var assert = require('assert');
+
+// Tests the header serializer binding used by http.OutgoingMessage.
+
+var writer = process.binding('http_writer');
+var http = require('http');  // pre-encodes the status lines
+
+var state = [0];
+var buffer = new Buffer(1024);
+
+function write(firstLine, reason, fields, values, flags) {
+  var n = writer.writeHeader(buffer, 10, firstLine, reason,
+                             fields, values, flags, state);
+  assert.ok(n > 0);
+  return buffer.toString('utf8', 10, 10 + n);
+}
+
+
+// Status line from the table, keep-alive with a Content-Length.
+assert.equal('HTTP/1.1 200 OK\r\n' +
+             'Content-Length: 5\r\n' +
+             'Connection: keep-alive\r\n\r\n',
+             write(200, http.STATUS_CODES[200], ['Content-Length'], [5],
+                   writer.HEADER_KEEP_ALIVE | writer.HEADER_HAS_BODY));
+assert.equal(0, state[0]);
+
+
+// Custom reason phrase, chunked by default.
+assert.equal('HTTP/1.1 200 Fine\r\n' +
+             'Set-Cookie: a=1\r\n' +
+             'Set-Cookie: b=é\r\n' +
+             'Connection: keep-alive\r\n' +
+             'Transfer-Encoding: chunked\r\n\r\n',
+             write(200, 'Fine', ['Set-Cookie', 'Set-Cookie'], ['a=1', 'b=é'],
+                   writer.HEADER_KEEP_ALIVE | writer.HEADER_CHUNKED_DEFAULT |
+                   writer.HEADER_HAS_BODY));
+assert.equal(writer.HEADER_CHUNKED, state[0]);
+
+
+// Explicit Connection: close ends the connection.
+assert.equal('HTTP/1.1 404 Not Found\r\n' +
+             'connection: Close\r\n\r\n',
+             write(404, http.STATUS_CODES[404], ['connection'], ['Close'],
+                   writer.HEADER_KEEP_ALIVE | writer.HEADER_HAS_BODY));
+assert.equal(writer.HEADER_LAST, state[0] & writer.HEADER_LAST);
+
+
+// Request line, body-less request, Expect.
+assert.equal('GET / HTTP/1.1\r\n' +
+             'Expect: 100-continue\r\n' +
+             'Connection: keep-alive\r\n\r\n',
+             write('GET / HTTP/1.1\r\n', undefined, ['Expect'], ['100-continue'],
+                   writer.HEADER_KEEP_ALIVE | writer.HEADER_BODYLESS |
+                   writer.HEADER_HAS_BODY));
+assert.equal(writer.HEADER_EXPECT, state[0] & writer.HEADER_EXPECT);
+
+
+// Without keep-alive and chunking the body ends with the connection.
+assert.equal('HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n',
+             write(200, http.STATUS_CODES[200], [], [],
+                   writer.HEADER_HAS_BODY));
+assert.equal(writer.HEADER_LAST, state[0]);
+
+
+// Headers that do not fit report -1.
+var small = new Buffer(32);
+assert.equal(-1, writer.writeHeader(small, 0, 200, 'OK',
+                                    ['X-Long'], [new Array(64).join('x')],
+                                    0, state));
+
+assert.throws(function() {
+  writer.writeHeader(buffer, 2048, 200, 'OK', [], [], 0, state);
+}, RangeError);
+
+
+// Chunk size lines.
+assert.equal(3, writer.writeChunkHeader(buffer, 0, 0));
+assert.equal('0\r\n', buffer.toString('ascii', 0, 3));
+assert.equal(5, writer.writeChunkHeader(buffer, 0, 0x1a2));
+assert.equal('1a2\r\n', buffer.toString('ascii', 0, 5));
+assert.equal(10, writer.writeChunkHeader(buffer, 4, 0xffffffff));
+assert.equal('ffffffff\r\n', buffer.toString('ascii', 4, 14));
+assert.equal(-1, writer.writeChunkHeader(buffer, 1020, 0x10000));
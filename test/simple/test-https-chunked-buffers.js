@@ -0,0 +1,55 @@
+if (!process.versions.openssl) {
+  console.error('Skipping because node compiled without OpenSSL.');
+  process.exit(0);
+}
+
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var https = require('https');
+
+// Chunked Buffer writes in both directions over CleartextStreams, which
+// have no _writeBuffers().
+var options = {
+  key: fs.readFileSync(common.fixturesDir + '/keys/agent1-key.pem'),
+  cert: fs.readFileSync(common.fixturesDir + '/keys/agent1-cert.pem')
+};
+
+var responses = 0;
+
+var server = https.createServer(options, function(req, res) {
+  var received = '';
+  req.setEncoding('utf8');
+  req.on('data', function(d) { received += d; });
+  req.on('end', function() {
+    assert.equal('chunked', req.headers['transfer-encoding']);
+    assert.equal('ping pong', received);
+
+    res.writeHead(200);
+    res.write(new Buffer('hello '));
+    res.write(new Buffer('world'));
+    res.end(new Buffer('!'));
+  });
+});
+
+server.listen(common.PORT, function() {
+  var req = https.request({ port: common.PORT,
+                            path: '/',
+                            method: 'POST' }, function(res) {
+    assert.equal('chunked', res.headers['transfer-encoding']);
+    var data = '';
+    res.setEncoding('utf8');
+    res.on('data', function(d) { data += d; });
+    res.on('end', function() {
+      assert.equal('hello world!', data);
+      responses++;
+      server.close();
+    });
+  });
+  req.write(new Buffer('ping '));
+  req.end(new Buffer('pong'));
+});
+
+process.on('exit', function() {
+  assert.equal(1, responses);
+});
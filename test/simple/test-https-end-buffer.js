@@ -0,0 +1,40 @@
+if (!process.versions.openssl) {
+  console.error('Skipping because node compiled without OpenSSL.');
+  process.exit(0);
+}
+
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var https = require('https');
+
+// res.end(buffer) over a CleartextStream, which has no _writeBuffers().
+var options = {
+  key: fs.readFileSync(common.fixturesDir + '/keys/agent1-key.pem'),
+  cert: fs.readFileSync(common.fixturesDir + '/keys/agent1-cert.pem')
+};
+
+var body = new Buffer('hello world\n');
+var responses = 0;
+
+var server = https.createServer(options, function(req, res) {
+  res.writeHead(200, { 'Content-Length': body.length });
+  res.end(body);
+});
+
+server.listen(common.PORT, function() {
+  https.get({ port: common.PORT, path: '/' }, function(res) {
+    var data = '';
+    res.setEncoding('utf8');
+    res.on('data', function(d) { data += d; });
+    res.on('end', function() {
+      assert.equal(body.toString(), data);
+      responses++;
+      server.close();
+    });
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(1, responses);
+});
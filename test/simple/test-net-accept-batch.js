@@ -0,0 +1,38 @@
+var common = require('../common');
+var assert = require('assert');
+var net = require('net');
+var binding = process.binding('net');
+
+// An empty listen queue yields null rather than an empty array.
+var fd = binding.socket('tcp4');
+binding.bind(fd, common.PORT + 1, '127.0.0.1');
+binding.listen(fd, 8);
+assert.equal(binding.acceptMany(fd, 16), null);
+binding.close(fd);
+
+var N = 20;
+var connections = 0;
+var closed = 0;
+
+var server = net.createServer({ acceptBatch: 4 }, function(socket) {
+  assert.equal(socket.remoteAddress, '127.0.0.1');
+  assert.ok(socket.remotePort > 0);
+  connections++;
+  socket.end(String(connections));
+});
+assert.equal(server.acceptBatch, 4);
+
+server.listen(common.PORT, '127.0.0.1', function() {
+  for (var i = 0; i < N; i++) {
+    var c = net.createConnection(common.PORT, '127.0.0.1');
+    c.on('end', function() {
+      this.end();
+      if (++closed == N) server.close();
+    });
+  }
+});
+
+process.on('exit', function() {
+  assert.equal(connections, N);
+  assert.equal(closed, N);
+});
@@ -0,0 +1,29 @@
+var common = require('../common');
+var assert = require('assert');
+var path = require('path');
+var prefork = require('prefork');
+
+var master = prefork.createMaster({
+  exec: path.join(common.fixturesDir, 'prefork-crash-worker.js'),
+  workers: 1,
+  port: common.PORT
+});
+
+// A worker that keeps dying on startup is respawned after 100, 200 and
+// 400 ms rather than in a tight loop.
+var exits = [];
+
+master.on('exit', function(worker, code) {
+  assert.equal(code, 1);
+  exits.push(Date.now());
+  if (exits.length == 4) master.stop();
+});
+
+master.start();
+
+process.on('exit', function() {
+  assert.equal(exits.length, 4);
+  assert.ok(exits[1] - exits[0] >= 100);
+  assert.ok(exits[2] - exits[1] >= 200);
+  assert.ok(exits[3] - exits[2] >= 400);
+});
@@ -0,0 +1,46 @@
+var common = require('../common');
+var assert = require('assert');
+var path = require('path');
+var prefork = require('prefork');
+
+var master = prefork.createMaster({
+  exec: path.join(common.fixturesDir, 'prefork-worker.js'),
+  workers: 2,
+  port: common.PORT
+});
+
+var codes = [];
+var restartError = null;
+
+master.on('exit', function(worker, code) {
+  codes.push(code);
+});
+
+function pids() {
+  return Object.keys(master.stats()).map(Number).sort();
+}
+
+master.start(function() {
+  var before = pids();
+  assert.equal(before.length, 2);
+
+  // The new code dies on startup: the restart gives up and the old workers
+  // keep serving, with no respawn of the broken one.
+  master.exec = path.join(common.fixturesDir, 'prefork-crash-worker.js');
+
+  master.restart(function(err) {
+    restartError = err;
+    assert.deepEqual(codes, [1]);
+
+    setTimeout(function() {
+      assert.deepEqual(pids(), before);
+      master.stop();
+    }, 500);
+  });
+});
+
+process.on('exit', function() {
+  assert.ok(restartError instanceof Error);
+  assert.ok(/exited before listening/.test(restartError.message));
+  assert.deepEqual(codes, [1, 0, 0]);
+});
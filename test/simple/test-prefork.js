@@ -0,0 +1,76 @@
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+var path = require('path');
+var prefork = require('prefork');
+
+assert.ok(prefork.isMaster);
+assert.ok(!prefork.isWorker);
+
+var master = prefork.createMaster({
+  exec: path.join(common.fixturesDir, 'prefork-worker.js'),
+  workers: 2,
+  port: common.PORT,
+  statsInterval: 100
+});
+
+var exits = 0;
+var statsSeen = 0;
+
+master.on('exit', function(worker, code) {
+  assert.equal(code, 0);
+  exits++;
+});
+
+master.on('stats', function(worker, stats) {
+  assert.equal(typeof stats.connections, 'number');
+  assert.ok(stats.memory.rss > 0);
+  statsSeen++;
+});
+
+function get(callback) {
+  http.get({ port: common.PORT, path: '/' }, function(res) {
+    var body = '';
+    res.setEncoding('utf8');
+    res.on('data', function(d) { body += d; });
+    res.on('end', function() { callback(parseInt(body, 10)); });
+  });
+}
+
+function pids() {
+  return Object.keys(master.stats()).map(Number).sort();
+}
+
+master.start(function() {
+  var before = pids();
+  assert.equal(before.length, 2);
+
+  get(function(pid) {
+    assert.notEqual(before.indexOf(pid), -1);
+
+    master.restart(function() {
+      var after = pids();
+      assert.equal(after.length, 2);
+      after.forEach(function(pid) {
+        assert.equal(before.indexOf(pid), -1);
+      });
+      assert.equal(exits, 2);
+
+      get(function(pid) {
+        assert.notEqual(after.indexOf(pid), -1);
+
+        setTimeout(function() {
+          master.stop(function() {
+            assert.equal(exits, 4);
+            assert.deepEqual(pids(), []);
+          });
+        }, 250);
+      });
+    });
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(exits, 4);
+  assert.ok(statsSeen > 0);
+});
@@ -180,3 +180,30 @@ assert.equal(0xd8, b[17]);
 assert.equal(0xa2, b[18]);
 assert.equal(0xe6, b[19]);
 
+
+// Buffers parse the same as strings.
+qsTestCases.forEach(function(testCase) {
+  assert.deepEqual(testCase[2], qs.parse(new Buffer(testCase[0])));
+});
+assert.deepEqual({}, qs.parse(new Buffer(0)));
+assert.deepEqual({'a': 'b c'}, qs.parse(new Buffer('a=b+c')));
+assert.equal('a b%2', qs.unescapeBuffer(new Buffer('a+b%2'), true).toString());
+
+// multi character separators, and eq only splitting once
+assert.deepEqual({'a': 'b', 'c': 'd==e'}, qs.parse('a=>b;;c=>d==e', ';;', '=>'));
+assert.deepEqual({'a': ['1', '2', '3'], 'b': ''}, qs.parse('a=1&b&a=2&a=3'));
+
+// strings are taken as UTF-8 rather than truncated to bytes
+assert.deepEqual({'\u00e9t\u00e9': '\u2603'},
+                 qs.parse('\u00e9t\u00e9=%E2%98%83'));
+assert.equal('\u2603 x', qs.unescape('\u2603+x', true));
+
+// an overridden unescape is used by parse
+var defaultUnescape = qs.unescape;
+qs.unescape = function(s) {
+  return s.toUpperCase();
+};
+assert.deepEqual({'A': ['B', 'C%20D']}, qs.parse('a=b&a=c%20d'));
+assert.deepEqual({'X': 'Y'}, qs.parse(new Buffer('x=y')));
+qs.unescape = defaultUnescape;
+assert.deepEqual({'a': ['b', 'c d']}, qs.parse('a=b&a=c%20d'));
@@ -0,0 +1,32 @@
+var common = require('../common');
+var assert = require('assert');
+var spawn = require('child_process').spawn;
+
+if (process.argv[2] === 'child') {
+  var line = new Array(1000).join('x') + '\n';
+
+  process.stdout.on('error', function(e) {
+    assert.equal('EPIPE', e.code);
+    assert.equal(false, process.stdout.writable);
+    process.exit(42);
+  });
+
+  // Keep writing until the helper thread hits the closed pipe.
+  setInterval(function() {
+    for (var i = 0; i < 10; i++) process.stdout.write(line);
+  }, 1);
+} else {
+  var child = spawn(process.execPath, [__filename, 'child']);
+  child.stdout.destroy();
+
+  var exited = false;
+
+  child.on('exit', function(code) {
+    assert.equal(42, code);
+    exited = true;
+  });
+
+  process.on('exit', function() {
+    assert.ok(exited);
+  });
+}
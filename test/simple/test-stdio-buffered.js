@@ -0,0 +1,58 @@
+var common = require('../common');
+var assert = require('assert');
+var spawn = require('child_process').spawn;
+
+var lines = 200;
+var line = new Array(1000).join('x');
+
+if (process.argv[2] === 'child') {
+  assert.equal('drop', process.stdout.stats.policy);
+
+  // Writes larger than the whole buffer can never fit and are dropped.
+  process.stdout.setPolicy('drop', 16);
+  for (var i = 0; i < 100; i++) {
+    assert.equal(true, process.stdout.write(line));
+  }
+  assert.equal(100 * line.length, process.stdout.stats.dropped);
+
+  // A buffer much smaller than the output: writers wait for room.
+  process.stdout.setPolicy('block', 4096);
+  assert.equal('block', process.stdout.stats.policy);
+  assert.equal(4096, process.stdout.stats.size);
+
+  // stderr is written synchronously.
+  assert.equal(undefined, process.stderr.setPolicy);
+  console.error('done');
+
+  for (var i = 0; i < lines; i++) console.log(line);
+
+  // Whatever is still buffered is written out before the process exits.
+  process.exit(0);
+}
+
+var child = spawn(process.execPath, [__filename, 'child']);
+
+var stdout = 0;
+var stderr = '';
+
+child.stdout.on('data', function(d) {
+  stdout += d.length;
+});
+
+child.stderr.setEncoding('utf8');
+child.stderr.on('data', function(d) {
+  stderr += d;
+});
+
+var exited = false;
+
+child.on('exit', function(code) {
+  assert.equal(0, code);
+  exited = true;
+});
+
+process.on('exit', function() {
+  assert.ok(exited);
+  assert.equal(lines * (line.length + 1), stdout);
+  assert.equal('done\n', stderr);
+});
@@ -0,0 +1,47 @@
+var common = require('../common');
+var assert = require('assert');
+var tls = require('tls');
+var fs = require('fs');
+
+
+var options = {
+  key: fs.readFileSync(common.fixturesDir + '/keys/agent2-key.pem'),
+  cert: fs.readFileSync(common.fixturesDir + '/keys/agent2-cert.pem'),
+  asyncHandshake: true
+};
+
+var N = 10;
+var connections = 0;
+var replies = 0;
+
+
+var server = tls.Server(options, function(socket) {
+  connections++;
+  socket.on('data', function(d) {
+    socket.end(d);
+  });
+});
+
+
+server.listen(common.PORT, function() {
+  for (var i = 0; i < N; i++) {
+    (function(i) {
+      var client = tls.connect(common.PORT, function() {
+        client.write('ping ' + i);
+      });
+      var buffer = '';
+      client.setEncoding('utf8');
+      client.on('data', function(d) { buffer += d; });
+      client.on('end', function() {
+        assert.equal('ping ' + i, buffer);
+        if (++replies == N) server.close();
+      });
+    })(i);
+  }
+});
+
+
+process.on('exit', function() {
+  assert.equal(N, connections);
+  assert.equal(N, replies);
+});
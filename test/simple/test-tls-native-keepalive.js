@@ -0,0 +1,57 @@
+var common = require('../common');
+var assert = require('assert');
+var tls = require('tls');
+var fs = require('fs');
+
+// Request/response over a native TLS connection that neither side closes:
+// every response has to arrive in full without the FIN pushing it out.
+var options = {
+  key: fs.readFileSync(common.fixturesDir + '/keys/agent2-key.pem'),
+  cert: fs.readFileSync(common.fixturesDir + '/keys/agent2-cert.pem'),
+  nativeTLS: true
+};
+
+var rounds = 5;
+var completed = 0;
+var response = new Buffer(64 * 1024 + 7);
+for (var i = 0; i < response.length; i++) response[i] = i % 253;
+
+var server = tls.Server(options, function(socket) {
+  var pending = '';
+  socket.setEncoding('ascii');
+  socket.on('data', function(d) {
+    pending += d;
+    while (pending.indexOf('\n') != -1) {
+      pending = pending.slice(pending.indexOf('\n') + 1);
+      socket.write(response);
+    }
+  });
+});
+
+server.listen(common.PORT, function() {
+  var client = tls.connect(common.PORT, { nativeTLS: true }, function() {
+    client.write('request\n');
+  });
+
+  var received = 0;
+  client.on('data', function(d) {
+    for (var i = 0; i < d.length; i++) {
+      assert.equal(response[(received + i) % response.length], d[i]);
+    }
+    received += d.length;
+    if (received < response.length) return;
+
+    assert.equal(response.length, received);
+    received = 0;
+    if (++completed < rounds) {
+      client.write('request\n');
+    } else {
+      client.destroy();
+      server.close();
+    }
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(rounds, completed);
+});
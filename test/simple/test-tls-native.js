@@ -0,0 +1,105 @@
+var common = require('../common');
+var assert = require('assert');
+var tls = require('tls');
+var net = require('net');
+var fs = require('fs');
+
+
+var options = {
+  key: fs.readFileSync(common.fixturesDir + '/keys/agent2-key.pem'),
+  cert: fs.readFileSync(common.fixturesDir + '/keys/agent2-cert.pem'),
+  nativeTLS: true
+};
+
+var connections = 0;
+var secureConnects = 0;
+var body = new Buffer(256 * 1024);
+for (var i = 0; i < body.length; i++) body[i] = i % 251;
+
+
+var server = tls.Server(options, function(socket) {
+  connections++;
+  assert.ok(socket instanceof require('net').Stream);
+  assert.equal(false, socket.authorized);
+  assert.ok(socket.getCipher().name);
+
+  var received = 0;
+  socket.on('data', function(d) {
+    received += d.length;
+    if (received == 5) socket.end(body);
+  });
+});
+
+
+server.listen(common.PORT, function() {
+  var client = tls.connect(common.PORT, { nativeTLS: true }, function() {
+    secureConnects++;
+    var cert = client.getPeerCertificate();
+    assert.equal('agent2', cert.subject.CN);
+  });
+
+  // Written before the handshake is done; must be queued until then.
+  client.write('hello');
+
+  var chunks = [];
+  var length = 0;
+  client.on('data', function(d) {
+    chunks.push(d);
+    length += d.length;
+  });
+
+  client.on('end', function() {
+    assert.equal(body.length, length);
+    var offset = 0;
+    chunks.forEach(function(c) {
+      for (var j = 0; j < c.length; j++) {
+        assert.equal(body[offset + j], c[j]);
+      }
+      offset += c.length;
+    });
+    testHandshakeErrors();
+  });
+});
+
+
+// A peer that does not speak TLS: the server reports 'clientError' and the
+// client gets 'error' on its stream.
+var clientErrors = 0;
+var serverErrors = 0;
+
+server.on('clientError', function(e) {
+  assert.ok(e instanceof Error);
+  serverErrors++;
+});
+
+function testHandshakeErrors() {
+  var plain = net.createConnection(common.PORT, function() {
+    plain.write('GET / HTTP/1.0\r\n\r\n');
+  });
+  plain.on('error', function() { });
+  plain.on('close', function() {
+    var garbage = net.createServer(function(socket) {
+      socket.end('HTTP/1.0 400 Bad Request\r\n\r\n');
+    });
+    garbage.listen(common.PORT + 1, function() {
+      var client = tls.connect(common.PORT + 1, { nativeTLS: true },
+                               function() {
+        assert.fail('handshake with a plain TCP server succeeded');
+      });
+      client.on('error', function(e) {
+        assert.ok(e instanceof Error);
+        clientErrors++;
+        garbage.close();
+        server.close();
+      });
+    });
+  });
+}
+
+
+process.on('exit', function() {
+  assert.equal(1, connections);
+  assert.equal(1, secureConnects);
+  assert.equal(1, serverErrors);
+  assert.equal(1, clientErrors);
+});
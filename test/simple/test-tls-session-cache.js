@@ -0,0 +1,54 @@
+var common = require('../common');
+var assert = require('assert');
+var tls = require('tls');
+var fs = require('fs');
+var path = require('path');
+
+var cacheFile = path.join(common.tmpDir, 'tls-session-cache');
+try { fs.unlinkSync(cacheFile); } catch (e) {}
+
+function makeServer() {
+  return tls.Server({
+    key: fs.readFileSync(common.fixturesDir + '/keys/agent2-key.pem'),
+    cert: fs.readFileSync(common.fixturesDir + '/keys/agent2-cert.pem'),
+    sessionCache: cacheFile,
+    sessionCacheSize: 64
+  }, function(socket) {
+    socket.end('ok');
+  });
+}
+
+// Two servers stand in for two worker processes: the session negotiated
+// with the first one must be resumed by the second through the file.
+var first = makeServer();
+var second = makeServer();
+var reused = [];
+
+function connect(port, session, cb) {
+  var client = tls.connect(port, { session: session }, function() {
+    reused.push(client.isSessionReused());
+    var s = client.getSession();
+    assert.ok(Buffer.isBuffer(s));
+    client.on('end', function() { cb(s); });
+  });
+}
+
+
+first.listen(common.PORT, function() {
+  second.listen(common.PORT + 1, function() {
+    connect(common.PORT, null, function(session) {
+      connect(common.PORT, session, function() {
+        connect(common.PORT + 1, session, function() {
+          first.close();
+          second.close();
+        });
+      });
+    });
+  });
+});
+
+
+process.on('exit', function() {
+  assert.deepEqual([false, true, true], reused);
+  fs.unlinkSync(cacheFile);
+});
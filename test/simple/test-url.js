@@ -164,6 +164,26 @@ var parseTests = {
     'host': 'isaacschlueter@jabber.org',
     'auth': 'isaacschlueter',
     'hostname': 'jabber.org'
+  },
+  'http://user:pw@example.com:8080/a/b?x=1#frag' : {
+    'href': 'http://user:pw@example.com:8080/a/b?x=1#frag',
+    'protocol': 'http:',
+    'slashes': true,
+    'host': 'user:pw@example.com:8080',
+    'auth': 'user:pw',
+    'port': '8080',
+    'hostname': 'example.com',
+    'hash': '#frag',
+    'search': '?x=1',
+    'query': 'x=1',
+    'pathname': '/a/b'
+  },
+  'http://a.com:x8/p' : {
+    'href': 'http://a.com:x8/p',
+    'protocol': 'http:',
+    'host': 'a.com:x8',
+    'hostname': 'a.com:x8',
+    'pathname': '/p'
   }
 };
 for (var u in parseTests) {
@@ -0,0 +1,56 @@
+var common = require('../common');
+var assert = require('assert');
+
+try {
+  var zlib = require('zlib');
+} catch (e) {
+  console.log('Not compiled with zlib support.');
+  process.exit();
+}
+
+var input = new Buffer(64 * 1024);
+for (var i = 0; i < input.length; i++) input[i] = (i * 13 + (i >> 8)) & 0xff;
+
+var errors = 0;
+var streamErrors = 0;
+
+zlib.gzip(input, function(err, compressed) {
+  assert.equal(null, err);
+
+  // Cut off the trailer, the middle of the data and most of the header.
+  [compressed.length - 1, compressed.length >> 1, 4].forEach(function(len) {
+    var truncated = compressed.slice(0, len);
+
+    [{}, { threadPoolThreshold: 1 }].forEach(function(options) {
+      zlib.gunzip(truncated, options, function(err, output) {
+        assert.ok(err instanceof Error);
+        assert.equal('unexpected end of file', err.message);
+        assert.equal(undefined, output);
+        errors++;
+      });
+    });
+
+    // The streaming interface reports it as an 'error' instead of 'end'.
+    var gunzip = zlib.createGunzip();
+    gunzip.on('error', function(err) {
+      assert.equal('unexpected end of file', err.message);
+      streamErrors++;
+    });
+    gunzip.on('end', function() {
+      assert.fail('end emitted for truncated input');
+    });
+    gunzip.write(truncated);
+    gunzip.end();
+  });
+
+  // The complete stream still decodes.
+  zlib.gunzip(compressed, function(err, output) {
+    assert.equal(null, err);
+    assert.equal(input.length, output.length);
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(6, errors);
+  assert.equal(3, streamErrors);
+});
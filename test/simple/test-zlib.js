@@ -0,0 +1,81 @@
+var common = require('../common');
+var assert = require('assert');
+
+try {
+  var zlib = require('zlib');
+} catch (e) {
+  console.log('Not compiled with zlib support.');
+  process.exit();
+}
+
+var input = new Buffer(256 * 1024);
+for (var i = 0; i < input.length; i++) input[i] = (i * 7 + (i >> 10)) & 0x3f;
+
+var done = 0;
+
+// Every format round trips, on the main thread and on the thread pool.
+[['gzip', 'gunzip'],
+ ['gzip', 'unzip'],
+ ['deflate', 'inflate'],
+ ['deflate', 'unzip'],
+ ['deflateRaw', 'inflateRaw']].forEach(function(pair) {
+  [{}, { threadPoolThreshold: 1 }].forEach(function(options) {
+    zlib[pair[0]](input, options, function(err, compressed) {
+      assert.equal(null, err);
+      assert.ok(compressed.length < input.length / 10);
+
+      zlib[pair[1]](compressed, options, function(err, output) {
+        assert.equal(null, err);
+        assert.equal(input.length, output.length);
+        for (var i = 0; i < input.length; i++) {
+          if (input[i] !== output[i]) assert.fail(i);
+        }
+        done++;
+      });
+    });
+  });
+});
+
+
+// Streaming: small output chunks, a flush() in the middle, strings.
+(function() {
+  var gzip = zlib.createGzip({ chunkSize: 512 });
+  var gunzip = zlib.createGunzip();
+  var result = '';
+  var flushed = false;
+
+  gzip.on('data', function(chunk) {
+    assert.ok(chunk.length <= 512);
+    gunzip.write(chunk);
+  });
+  gzip.on('end', function() {
+    gunzip.end();
+  });
+
+  gunzip.on('data', function(chunk) {
+    result += chunk.toString();
+    if (result === 'hello ') flushed = true;
+  });
+  gunzip.on('end', function() {
+    assert.ok(flushed);
+    assert.equal('hello world', result);
+    done++;
+  });
+
+  gzip.write('hello ');
+  gzip.flush();
+  gzip.end('world');
+})();
+
+
+// Corrupt input is reported, not thrown.
+zlib.inflate(new Buffer('this is not deflate'), function(err, output) {
+  assert.ok(err instanceof Error);
+  assert.equal(undefined, output);
+  done++;
+});
+
+
+process.on('exit', function() {
+  assert.equal(12, done);
+});